@@ -0,0 +1,111 @@
+/**
+ * @file        async.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_ASYNC_H
+#define KITSUNEMIMI_HANAMI_SHIORI_ASYNC_H
+
+#include <string>
+#include <future>
+
+#include <libKitsunemimiCommon/logger.h>
+#include <libKitsunemimiJson/json_item.h>
+
+#include <libKitsunemimiHanamiCommon/enums.h>
+
+namespace Kitsunemimi {
+struct DataBuffer;
+}
+
+namespace Shiori
+{
+
+template<typename T>
+struct AsyncResult
+{
+    T result = T();
+    bool success = false;
+    Kitsunemimi::ErrorContainer error;
+};
+
+void setNumberOfAsyncWorker(const uint32_t numberOfWorker);
+
+// datasets
+std::future<AsyncResult<Kitsunemimi::DataBuffer*>>
+getDatasetDataAsync(const std::string &token,
+                    const std::string &uuid,
+                    const std::string &columnName);
+
+std::future<AsyncResult<Kitsunemimi::JsonItem>>
+getDataSetInformationAsync(const std::string &dataSetUuid,
+                           const std::string &token);
+
+// snapshots
+std::future<AsyncResult<Kitsunemimi::DataBuffer*>>
+getSnapshotDataAsync(const std::string &location);
+
+std::future<AsyncResult<Kitsunemimi::JsonItem>>
+getSnapshotInformationAsync(const std::string &snapshotUuid,
+                            const std::string &token);
+
+std::future<AsyncResult<std::string>>
+runSnapshotInitProcessAsync(const std::string &snapshotUuid,
+                            const std::string &snapshotName,
+                            const std::string &userId,
+                            const std::string &projectId,
+                            const uint64_t totalSize,
+                            const std::string &headerMessage,
+                            const std::string &token);
+
+std::future<AsyncResult<uint64_t>>
+sendDataAsync(const Kitsunemimi::DataBuffer* data,
+              const uint64_t targetPos,
+              const std::string &uuid,
+              const std::string &fileUuid);
+
+std::future<AsyncResult<bool>>
+runSnapshotFinalizeProcessAsync(const std::string &snapshotUuid,
+                                const std::string &fileUuid,
+                                const std::string &token,
+                                const std::string &userId,
+                                const std::string &projectId);
+
+// other
+std::future<AsyncResult<bool>>
+sendResultsAsync(const std::string &uuid,
+                 const std::string &name,
+                 const std::string &userId,
+                 const std::string &projectId,
+                 const Kitsunemimi::DataArray* results);
+
+std::future<AsyncResult<bool>>
+sendErrorMessageAsync(const std::string &userId,
+                      const std::string &errorMessage);
+
+std::future<AsyncResult<bool>>
+sendAuditMessageAsync(const std::string &targetComponent,
+                      const std::string &targetEndpoint,
+                      const std::string &userId,
+                      const Kitsunemimi::Hanami::HttpRequestType requestType);
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_ASYNC_H
@@ -0,0 +1,127 @@
+/**
+ * @file        column_cache.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_COLUMN_CACHE_H
+#define KITSUNEMIMI_HANAMI_SHIORI_COLUMN_CACHE_H
+
+#include <string>
+#include <list>
+#include <map>
+#include <mutex>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi {
+struct DataBuffer;
+}
+
+namespace Shiori
+{
+
+class ColumnCache
+{
+public:
+    static ColumnCache* getInstance();
+    ~ColumnCache();
+
+    void setMemoryLimit(const uint64_t memoryLimit);
+    bool initDiskCache(const std::string &cacheDir,
+                       const uint64_t diskLimit,
+                       Kitsunemimi::ErrorContainer &error);
+
+    Kitsunemimi::DataBuffer* get(const std::string &location,
+                                 const std::string &columnName);
+    bool getRange(Kitsunemimi::DataBuffer* &result,
+                  uint64_t &columnSize,
+                  const std::string &location,
+                  const std::string &columnName,
+                  const uint64_t offset,
+                  const uint64_t size);
+    void add(const std::string &location,
+             const std::string &columnName,
+             const Kitsunemimi::DataBuffer* data);
+    void clear();
+
+private:
+    ColumnCache();
+
+    struct MemoryEntry
+    {
+        Kitsunemimi::DataBuffer* data = nullptr;
+        std::list<std::string>::iterator lruPos;
+    };
+
+    struct DiskEntry
+    {
+        std::string filePath = "";
+        uint64_t fileSize = 0;
+        std::list<std::string>::iterator lruPos;
+    };
+
+    // cache-file, which is mapped into memory
+    struct MappedFile
+    {
+        void* mapped = nullptr;
+        uint64_t mappedSize = 0;
+        const uint8_t* data = nullptr;
+        uint64_t dataSize = 0;
+    };
+
+    std::mutex m_lock;
+
+    uint64_t m_memoryLimit = 0;
+    uint64_t m_memoryUsage = 0;
+    std::map<std::string, MemoryEntry> m_memoryEntries;
+    std::list<std::string> m_memoryLru;
+
+    std::string m_cacheDir = "";
+    uint64_t m_diskLimit = 0;
+    uint64_t m_diskUsage = 0;
+    std::map<std::string, DiskEntry> m_diskEntries;
+    std::list<std::string> m_diskLru;
+
+    Kitsunemimi::DataBuffer* getFromMemory(const std::string &key);
+    bool getRangeFromMemory(Kitsunemimi::DataBuffer* &result,
+                            uint64_t &columnSize,
+                            const std::string &key,
+                            const uint64_t offset,
+                            const uint64_t size);
+    void addToMemory(const std::string &key, const Kitsunemimi::DataBuffer* data);
+    void evictMemory();
+
+    Kitsunemimi::DataBuffer* getFromDisk(const std::string &key);
+    bool getRangeFromDisk(Kitsunemimi::DataBuffer* &result,
+                          uint64_t &columnSize,
+                          const std::string &key,
+                          const uint64_t offset,
+                          const uint64_t size);
+    bool mapDiskEntry(MappedFile &file, const std::string &key);
+    void addToDisk(const std::string &key, const Kitsunemimi::DataBuffer* data);
+    void evictDisk();
+    void removeDiskEntry(const std::string &key);
+
+    const std::string getFilePath(const std::string &key) const;
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_COLUMN_CACHE_H
@@ -0,0 +1,81 @@
+/**
+ * @file        column_view.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_COLUMN_VIEW_H
+#define KITSUNEMIMI_HANAMI_SHIORI_COLUMN_VIEW_H
+
+#include <string>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Shiori
+{
+
+// alignment of the values of a column-view in bytes
+const uint64_t COLUMN_VIEW_ALIGNMENT = 64;
+
+enum ColumnValueType
+{
+    UINT8_VALUE_TYPE = 0,
+    UINT16_VALUE_TYPE = 1,
+    INT32_VALUE_TYPE = 2,
+    FLOAT_VALUE_TYPE = 3,
+};
+
+struct ColumnConversion
+{
+    // type of the values of the raw column
+    ColumnValueType sourceType = FLOAT_VALUE_TYPE;
+    // each value is converted into: value * scale + offset
+    float scale = 1.0f;
+    float offset = 0.0f;
+};
+
+class ColumnView
+{
+public:
+    ColumnView();
+    ~ColumnView();
+
+    ColumnView(const ColumnView &) = delete;
+    ColumnView& operator=(const ColumnView &) = delete;
+
+    bool convert(const void* data,
+                 const uint64_t dataSize,
+                 const ColumnConversion &conversion,
+                 Kitsunemimi::ErrorContainer &error);
+
+    const float* getValues() const;
+    float* getValues();
+    uint64_t getNumberOfValues() const;
+
+private:
+    float* m_values = nullptr;
+    uint64_t m_numberOfValues = 0;
+    uint64_t m_capacity = 0;
+};
+
+uint64_t getColumnValueSize(const ColumnValueType type);
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_COLUMN_VIEW_H
@@ -24,11 +24,14 @@
 #define KITSUNEMIMI_HANAMI_SHIORI_DATASETS_H
 
 #include <string>
+#include <vector>
 
 #include <libKitsunemimiCommon/logger.h>
 
 #include <libKitsunemimiHanamiCommon/enums.h>
 
+#include <libShioriArchive/column_view.h>
+
 namespace Kitsunemimi {
 struct DataBuffer;
 class JsonItem;
@@ -37,15 +40,80 @@ class JsonItem;
 namespace Shiori
 {
 
+struct DataSetInformation
+{
+    std::string uuid = "";
+    std::string name = "";
+    std::string type = "";
+    std::string location = "";
+    std::string projectId = "";
+    std::string ownerId = "";
+    std::string visibility = "";
+};
+
+class DataSetHandle
+{
+public:
+    DataSetHandle(const std::string &token,
+                  const std::string &uuid);
+
+    bool init(Kitsunemimi::ErrorContainer &error);
+    const std::string getLocation() const;
+
+    Kitsunemimi::DataBuffer* getColumn(const std::string &columnName,
+                                       Kitsunemimi::ErrorContainer &error);
+    bool getColumns(std::vector<Kitsunemimi::DataBuffer*> &result,
+                    const std::vector<std::string> &columnNames,
+                    Kitsunemimi::ErrorContainer &error);
+
+private:
+    std::string m_token = "";
+    std::string m_uuid = "";
+    std::string m_location = "";
+};
+
 Kitsunemimi::DataBuffer* getDatasetData(const std::string &token,
                                         const std::string &uuid,
                                         const std::string &columnName,
                                         Kitsunemimi::ErrorContainer &error);
 
+Kitsunemimi::DataBuffer* getDatasetDataRange(const std::string &token,
+                                             const std::string &uuid,
+                                             const std::string &columnName,
+                                             const uint64_t offset,
+                                             const uint64_t size,
+                                             Kitsunemimi::ErrorContainer &error);
+Kitsunemimi::DataBuffer* getDatasetRows(const std::string &token,
+                                        const std::string &uuid,
+                                        const std::string &columnName,
+                                        const uint64_t rowSize,
+                                        const uint64_t firstRow,
+                                        const uint64_t numberOfRows,
+                                        Kitsunemimi::ErrorContainer &error);
+
+bool prefetchDatasetData(const std::string &token,
+                         const std::string &uuid,
+                         const std::string &columnName,
+                         Kitsunemimi::ErrorContainer &error);
+void setDatasetPrefetchLimits(const uint64_t memoryLimit,
+                              const uint32_t numberOfThreads);
+void cancelDatasetPrefetch();
+
+bool getDatasetColumnView(ColumnView &result,
+                          const std::string &token,
+                          const std::string &uuid,
+                          const std::string &columnName,
+                          const ColumnConversion &conversion,
+                          Kitsunemimi::ErrorContainer &error);
+
 bool getDataSetInformation(Kitsunemimi::JsonItem &result,
                            const std::string &dataSetUuid,
                            const std::string &token,
                            Kitsunemimi::ErrorContainer &error);
+bool getDataSetInformation(DataSetInformation &result,
+                           const std::string &dataSetUuid,
+                           const std::string &token,
+                           Kitsunemimi::ErrorContainer &error);
 }
 
 #endif // KITSUNEMIMI_HANAMI_SHIORI_DATASETS_H
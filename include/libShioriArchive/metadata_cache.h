@@ -0,0 +1,93 @@
+/**
+ * @file        metadata_cache.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_METADATA_CACHE_H
+#define KITSUNEMIMI_HANAMI_SHIORI_METADATA_CACHE_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <memory>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi {
+class JsonItem;
+}
+
+namespace Shiori
+{
+
+class MetadataCache
+{
+public:
+    static MetadataCache* getInstance();
+
+    void setTimeToLive(const uint64_t timeToLiveMs);
+    bool request(std::string &responseContent,
+                 const std::string &endpoint,
+                 const std::string &uuid,
+                 const std::string &token,
+                 Kitsunemimi::ErrorContainer &error);
+    bool request(std::shared_ptr<const Kitsunemimi::JsonItem> &parsedContent,
+                 const std::string &endpoint,
+                 const std::string &uuid,
+                 const std::string &token,
+                 Kitsunemimi::ErrorContainer &error);
+    void clear();
+
+private:
+    MetadataCache();
+
+    struct FetchResult
+    {
+        bool success = false;
+        std::string content = "";
+        // response parsed only once, so cached lookups don't have to parse it again
+        std::shared_ptr<const Kitsunemimi::JsonItem> parsed;
+    };
+
+    struct Entry
+    {
+        std::shared_future<FetchResult> result;
+        bool completed = false;
+        std::chrono::steady_clock::time_point validUntil;
+    };
+
+    std::mutex m_lock;
+    std::chrono::milliseconds m_timeToLive = std::chrono::milliseconds(0);
+    std::map<std::string, Entry> m_entries;
+
+    std::shared_future<FetchResult> getResult(const std::string &endpoint,
+                                              const std::string &uuid,
+                                              const std::string &token);
+    FetchResult fetch(const std::string &endpoint,
+                      const std::string &uuid,
+                      const std::string &token);
+    void removeExpiredEntries();
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_METADATA_CACHE_H
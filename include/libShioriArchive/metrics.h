@@ -0,0 +1,82 @@
+/**
+ * @file        metrics.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_METRICS_H
+#define KITSUNEMIMI_HANAMI_SHIORI_METRICS_H
+
+#include <string>
+#include <vector>
+
+namespace Shiori
+{
+
+enum MetricOperation
+{
+    GET_DATASET_DATA_OPERATION = 0,
+    GET_DATASET_COLUMN_OPERATION = 1,
+    GET_DATASET_INFORMATION_OPERATION = 2,
+    GET_SNAPSHOT_DATA_OPERATION = 3,
+    GET_SNAPSHOT_MANIFEST_OPERATION = 4,
+    GET_SNAPSHOT_INFORMATION_OPERATION = 5,
+    SNAPSHOT_INIT_OPERATION = 6,
+    SEND_DATA_OPERATION = 7,
+    SEND_DATA_PIPELINED_OPERATION = 8,
+    RETRY_SEND_DATA_OPERATION = 9,
+    SNAPSHOT_FINALIZE_OPERATION = 10,
+    SEND_RESULTS_OPERATION = 11,
+    SEND_ERROR_MESSAGE_OPERATION = 12,
+    FLUSH_ERROR_MESSAGES_OPERATION = 13,
+    SEND_AUDIT_MESSAGE_OPERATION = 14,
+    PREFETCH_DATASET_DATA_OPERATION = 15,
+    GET_DATASET_DATA_RANGE_OPERATION = 16,
+    GET_DATASET_COLUMN_VIEW_OPERATION = 17,
+
+    NUMBER_OF_METRIC_OPERATIONS = 18,
+};
+
+// upper borders of the latency-buckets in seconds, the last bucket has no upper border
+const uint32_t NUMBER_OF_LATENCY_BUCKETS = 12;
+const double LATENCY_BUCKET_BORDERS[NUMBER_OF_LATENCY_BUCKETS - 1] =
+    {0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 10.0};
+
+struct OperationMetrics
+{
+    uint64_t numberOfCalls = 0;
+    uint64_t numberOfFailures = 0;
+    uint64_t numberOfRetries = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t numberOfSegments = 0;
+    uint64_t latencySumNs = 0;
+    // number of calls per latency-bucket, not cumulative
+    uint64_t latencyBuckets[NUMBER_OF_LATENCY_BUCKETS] = {};
+};
+
+const std::string getMetricOperationName(const MetricOperation operation);
+
+void getMetrics(std::vector<OperationMetrics> &metrics);
+const std::string getMetricsAsPrometheus();
+void resetMetrics();
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_METRICS_H
@@ -24,31 +24,101 @@
 #define KITSUNEMIMI_HANAMI_SHIORI_OTHER_H
 
 #include <string>
+#include <vector>
 
 #include <libKitsunemimiCommon/logger.h>
 
 #include <libKitsunemimiHanamiCommon/enums.h>
 
+#include <libShioriArchive/shiori_connection.h>
+
 namespace Kitsunemimi {
 struct DataBuffer;
 namespace Json {
 class JsonItem;
 }
+namespace Hanami {
+class HanamiMessagingClient;
+}
 }
 
 namespace Shiori
 {
 
+enum ClientSelection
+{
+    ROUND_ROBIN_SELECTION = 0,
+    LEAST_LOADED_SELECTION = 1,
+};
+
+class ResultStream
+{
+public:
+    ResultStream(const std::string &uuid,
+                 const std::string &name,
+                 const std::string &userId,
+                 const std::string &projectId,
+                 const uint64_t batchSize);
+
+    bool append(const float* values,
+                const uint64_t numberOfValues,
+                Kitsunemimi::ErrorContainer &error);
+    bool append(const int64_t* values,
+                const uint64_t numberOfValues,
+                Kitsunemimi::ErrorContainer &error);
+    uint64_t getNumberOfValues() const;
+    uint64_t getNumberOfParts() const;
+    bool close(Kitsunemimi::ErrorContainer &error);
+
+private:
+    std::string m_uuid = "";
+    std::string m_name = "";
+    std::string m_userId = "";
+    std::string m_projectId = "";
+    uint64_t m_batchSize = 0;
+
+    // raw values of the part, which is not sent yet
+    std::string m_batch = "";
+    std::string m_batchType = "float32";
+    uint64_t m_numberOfValues = 0;
+    uint64_t m_numberOfParts = 0;
+    bool m_closed = false;
+    // true, if a part could not be sent, because further parts would leave a gap in the numbers
+    bool m_failed = false;
+
+    bool appendValues(const std::string &type,
+                      const void* values,
+                      const uint64_t numberOfValues,
+                      const uint64_t valueSize,
+                      Kitsunemimi::ErrorContainer &error);
+    bool sendPart(const bool isLast, Kitsunemimi::ErrorContainer &error);
+};
+
 bool sendResults(const std::string &uuid,
                  const std::string &name,
                  const std::string &userId,
                  const std::string &projectId,
                  const Kitsunemimi::DataArray &results,
                  Kitsunemimi::ErrorContainer &error);
+bool sendResults(const std::string &uuid,
+                 const std::string &name,
+                 const std::string &userId,
+                 const std::string &projectId,
+                 const std::vector<float> &results,
+                 Kitsunemimi::ErrorContainer &error);
+bool sendResults(const std::string &uuid,
+                 const std::string &name,
+                 const std::string &userId,
+                 const std::string &projectId,
+                 const std::vector<int64_t> &results,
+                 Kitsunemimi::ErrorContainer &error);
 
 bool sendErrorMessage(const std::string &userId,
                       const std::string &errorMessage,
                       Kitsunemimi::ErrorContainer &error);
+void setErrorMessageLimits(const uint64_t windowMs,
+                           const uint32_t maxMessagesPerSecond);
+bool flushErrorMessages(Kitsunemimi::ErrorContainer &error);
 
 bool sendAuditMessage(const std::string &targetComponent,
                       const std::string &targetEndpoint,
@@ -56,6 +126,17 @@ bool sendAuditMessage(const std::string &targetComponent,
                       const Kitsunemimi::Hanami::HttpRequestType requestType,
                       Kitsunemimi::ErrorContainer &error);
 
+bool startAuditQueue(const uint32_t maxBatchSize,
+                     const uint32_t flushIntervalMs);
+void stopAuditQueue();
+
+void setBufferPoolLimit(const uint64_t limit);
+uint64_t getBufferPoolSize();
+
+bool addShioriClient(Kitsunemimi::Hanami::HanamiMessagingClient* client);
+bool addShioriConnection(ShioriConnection* connection);
+void setShioriClientSelection(const ClientSelection selection);
+
 }
 
 #endif // KITSUNEMIMI_HANAMI_SHIORI_OTHER_H
@@ -0,0 +1,69 @@
+/**
+ * @file        shiori_connection.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_SHIORI_CONNECTION_H
+#define KITSUNEMIMI_HANAMI_SHIORI_SHIORI_CONNECTION_H
+
+#include <string>
+
+#include <libKitsunemimiCommon/logger.h>
+
+#include <libKitsunemimiHanamiCommon/structs.h>
+
+namespace Kitsunemimi {
+struct DataBuffer;
+}
+
+namespace Shiori
+{
+
+// connection to shiori, which is used for all requests of the library. The connections of the
+// hanami-messaging are wrapped by the library. Own implementations can be added with
+// addShioriConnection, for example to run tests and benchmarks without a running shiori.
+// The library sends only one stream-message at a time over a connection, but all other
+// methods can be called by multiple threads at the same time.
+class ShioriConnection
+{
+public:
+    virtual ~ShioriConnection() {}
+
+    virtual bool triggerSakuraFile(Kitsunemimi::Hanami::ResponseMessage &response,
+                                   const Kitsunemimi::Hanami::RequestMessage &request,
+                                   Kitsunemimi::ErrorContainer &error) = 0;
+    virtual bool sendStreamMessage(const void* data,
+                                   const uint64_t dataSize,
+                                   const bool replyExpected,
+                                   Kitsunemimi::ErrorContainer &error) = 0;
+    virtual bool sendGenericMessage(const uint32_t subType,
+                                    const void* data,
+                                    const uint64_t dataSize,
+                                    Kitsunemimi::ErrorContainer &error) = 0;
+    virtual Kitsunemimi::DataBuffer* sendGenericRequest(const uint32_t subType,
+                                                        const void* data,
+                                                        const uint64_t dataSize,
+                                                        Kitsunemimi::ErrorContainer &error) = 0;
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_SHIORI_CONNECTION_H
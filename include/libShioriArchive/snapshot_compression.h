@@ -0,0 +1,75 @@
+/**
+ * @file        snapshot_compression.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_SNAPSHOT_COMPRESSION_H
+#define KITSUNEMIMI_HANAMI_SHIORI_SNAPSHOT_COMPRESSION_H
+
+#include <string>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi {
+struct DataBuffer;
+}
+
+namespace Shiori
+{
+
+enum SnapshotCompression
+{
+    NO_COMPRESSION = 0,
+    LZ4_COMPRESSION = 1,
+    ZSTD_COMPRESSION = 2,
+};
+
+// encoding of the stored data of a snapshot, like it is recorded in the header of the snapshot
+struct SnapshotEncoding
+{
+    SnapshotCompression compression = NO_COMPRESSION;
+    // true, if the stored data is a delta-snapshot, which needs its parent to be restored
+    bool isDelta = false;
+};
+
+const std::string getCompressionName(const SnapshotCompression compression);
+bool getCompressionType(SnapshotCompression &compression,
+                        const std::string &name);
+
+Kitsunemimi::DataBuffer* compressSnapshot(const Kitsunemimi::DataBuffer &input,
+                                          const SnapshotCompression compression,
+                                          Kitsunemimi::ErrorContainer &error);
+
+bool isCompressedSnapshot(const Kitsunemimi::DataBuffer &input);
+
+bool getDecompressedSize(uint64_t &size,
+                         const Kitsunemimi::DataBuffer &input,
+                         Kitsunemimi::ErrorContainer &error);
+
+bool decompressSnapshot(uint8_t* target,
+                        const uint64_t targetSize,
+                        const Kitsunemimi::DataBuffer &input,
+                        Kitsunemimi::ErrorContainer &error);
+Kitsunemimi::DataBuffer* decompressSnapshot(const Kitsunemimi::DataBuffer &input,
+                                            Kitsunemimi::ErrorContainer &error);
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_SNAPSHOT_COMPRESSION_H
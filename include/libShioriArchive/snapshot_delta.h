@@ -0,0 +1,95 @@
+/**
+ * @file        snapshot_delta.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_SNAPSHOT_DELTA_H
+#define KITSUNEMIMI_HANAMI_SHIORI_SNAPSHOT_DELTA_H
+
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCommon/logger.h>
+
+#include <libShioriArchive/snapshot_compression.h>
+
+namespace Kitsunemimi {
+struct DataBuffer;
+}
+
+namespace Shiori
+{
+
+// maximum number of delta-snapshots in a row. Each delta-snapshot in the chain is an additional
+// full download at restore, so after this number of deltas a full snapshot has to be uploaded.
+const uint32_t MAX_DELTA_CHAIN_LENGTH = 8;
+
+struct SnapshotChunk
+{
+    uint64_t position = 0;
+    uint64_t size = 0;
+    uint8_t hash[32];
+};
+
+struct SnapshotManifest
+{
+    // file-location of the snapshot within shiori, which is used as parent by delta-snapshots
+    std::string location = "";
+    // encoding of the snapshot stored at the location, which is needed to restore the parent
+    SnapshotEncoding encoding;
+    // number of delta-snapshots from this snapshot back to the last full snapshot
+    uint32_t chainLength = 0;
+    uint64_t totalSize = 0;
+    std::vector<SnapshotChunk> chunks;
+};
+
+void createSnapshotManifest(SnapshotManifest &manifest,
+                            const Kitsunemimi::DataBuffer &input);
+
+bool needsFullSnapshot(const SnapshotManifest &parentManifest);
+
+Kitsunemimi::DataBuffer* createDeltaSnapshot(SnapshotManifest &manifest,
+                                             const Kitsunemimi::DataBuffer &input,
+                                             const SnapshotManifest &parentManifest,
+                                             Kitsunemimi::ErrorContainer &error);
+
+bool isDeltaSnapshot(const Kitsunemimi::DataBuffer &input);
+
+bool getDeltaSnapshotSize(uint64_t &size,
+                          const Kitsunemimi::DataBuffer &input,
+                          Kitsunemimi::ErrorContainer &error);
+
+bool getDeltaParent(std::string &location,
+                    SnapshotEncoding &encoding,
+                    uint64_t &parentSize,
+                    const Kitsunemimi::DataBuffer &input);
+
+bool applyDeltaSnapshot(uint8_t* target,
+                        const uint64_t targetSize,
+                        const Kitsunemimi::DataBuffer &delta,
+                        const Kitsunemimi::DataBuffer &parent,
+                        Kitsunemimi::ErrorContainer &error);
+Kitsunemimi::DataBuffer* applyDeltaSnapshot(const Kitsunemimi::DataBuffer &delta,
+                                            const Kitsunemimi::DataBuffer &parent,
+                                            Kitsunemimi::ErrorContainer &error);
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_SNAPSHOT_DELTA_H
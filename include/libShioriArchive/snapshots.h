@@ -24,11 +24,15 @@
 #define KITSUNEMIMI_HANAMI_SHIORI_SNAPSHOTS_H
 
 #include <string>
+#include <vector>
 
 #include <libKitsunemimiCommon/logger.h>
 
 #include <libKitsunemimiHanamiCommon/enums.h>
 
+#include <libShioriArchive/snapshot_compression.h>
+#include <libShioriArchive/snapshot_delta.h>
+
 namespace Kitsunemimi {
 struct DataBuffer;
 class JsonItem;
@@ -37,13 +41,58 @@ class JsonItem;
 namespace Shiori
 {
 
+struct SegmentState
+{
+    uint64_t position = 0;
+    uint64_t size = 0;
+    uint32_t checksum = 0;
+    // true, if the segment was written to the connection. Shiori doesn't confirm single
+    // segments, so this doesn't mean, that the segment is already stored by shiori.
+    bool sent = false;
+    std::string errorMessage = "";
+};
+
+struct SnapshotInformation
+{
+    std::string uuid = "";
+    std::string name = "";
+    std::string location = "";
+    // header of the snapshot as json-string
+    std::string header = "";
+    std::string projectId = "";
+    std::string ownerId = "";
+    std::string visibility = "";
+};
+
 Kitsunemimi::DataBuffer* getSnapshotData(const std::string &location,
                                          Kitsunemimi::ErrorContainer &error);
+Kitsunemimi::DataBuffer* getSnapshotData(const SnapshotInformation &snapshot,
+                                         Kitsunemimi::ErrorContainer &error);
+bool getSnapshotData(void* target,
+                     uint64_t &snapshotSize,
+                     const uint64_t targetSize,
+                     const SnapshotInformation &snapshot,
+                     Kitsunemimi::ErrorContainer &error);
+bool getSnapshotDataToFile(uint64_t &snapshotSize,
+                           const std::string &filePath,
+                           const SnapshotInformation &snapshot,
+                           Kitsunemimi::ErrorContainer &error);
+bool getSnapshotManifest(SnapshotManifest &manifest,
+                         const SnapshotInformation &snapshot,
+                         Kitsunemimi::ErrorContainer &error);
+
+bool getSnapshotEncoding(SnapshotEncoding &encoding,
+                         const SnapshotInformation &snapshot,
+                         Kitsunemimi::ErrorContainer &error);
 
 bool getSnapshotInformation(Kitsunemimi::JsonItem &result,
                             const std::string &snapshotUuid,
                             const std::string &token,
                             Kitsunemimi::ErrorContainer &error);
+bool getSnapshotInformation(SnapshotInformation &result,
+                            const std::string &snapshotUuid,
+                            const std::string &token,
+                            Kitsunemimi::ErrorContainer &error);
 
 bool runSnapshotInitProcess(std::string &fileUuid,
                             const std::string &snapshotUuid,
@@ -54,6 +103,16 @@ bool runSnapshotInitProcess(std::string &fileUuid,
                             const std::string &headerMessage,
                             const std::string &token,
                             Kitsunemimi::ErrorContainer &error);
+bool runSnapshotInitProcess(std::string &fileUuid,
+                            const std::string &snapshotUuid,
+                            const std::string &snapshotName,
+                            const std::string &userId,
+                            const std::string &projectId,
+                            const uint64_t totalSize,
+                            const std::string &headerMessage,
+                            const std::string &token,
+                            const SnapshotEncoding &encoding,
+                            Kitsunemimi::ErrorContainer &error);
 
 bool sendData(const Kitsunemimi::DataBuffer* data,
               uint64_t &targetPos,
@@ -61,6 +120,26 @@ bool sendData(const Kitsunemimi::DataBuffer* data,
               const std::string &fileUuid,
               Kitsunemimi::ErrorContainer &error);
 
+bool sendDataPipelined(const Kitsunemimi::DataBuffer* data,
+                       uint64_t &targetPos,
+                       const std::string &uuid,
+                       const std::string &fileUuid,
+                       const uint32_t numberOfWorkers,
+                       std::vector<SegmentState> &segmentStates,
+                       Kitsunemimi::ErrorContainer &error);
+bool retrySendData(const Kitsunemimi::DataBuffer* data,
+                   uint64_t &targetPos,
+                   const std::string &uuid,
+                   const std::string &fileUuid,
+                   const uint32_t numberOfWorkers,
+                   std::vector<SegmentState> &segmentStates,
+                   Kitsunemimi::ErrorContainer &error);
+
+bool configureSegmentSize(const uint64_t initialSize,
+                          const uint64_t minSize,
+                          const uint64_t maxSize,
+                          const bool adaptive);
+
 bool runSnapshotFinalizeProcess(const std::string &snapshotUuid,
                                 const std::string &fileUuid,
                                 const std::string &token,
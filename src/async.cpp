@@ -0,0 +1,247 @@
+/**
+ * @file        async.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <libShioriArchive/async.h>
+#include <libShioriArchive/datasets.h>
+#include <libShioriArchive/snapshots.h>
+#include <libShioriArchive/other.h>
+
+#include <async_worker.h>
+
+#include <memory>
+
+namespace Shiori
+{
+
+/**
+ * @brief run a blocking function within the async-worker
+ *
+ * @param function function, which fills the result
+ *
+ * @return future, which is fulfilled, when the function is done
+ */
+template<typename T>
+static std::future<AsyncResult<T>>
+runAsync(const std::function<void(AsyncResult<T>&)> &function)
+{
+    std::shared_ptr<std::promise<AsyncResult<T>>> promise =
+            std::make_shared<std::promise<AsyncResult<T>>>();
+    std::future<AsyncResult<T>> future = promise->get_future();
+
+    AsyncWorker::getInstance()->addTask([promise, function]()
+    {
+        AsyncResult<T> result;
+        function(result);
+        promise->set_value(std::move(result));
+    });
+
+    return future;
+}
+
+/**
+ * @brief set number of worker-threads, which process the asynchronous requests. This is also
+ *        the maximum number of requests in flight at the same time.
+ *
+ * @param numberOfWorker new number of worker-threads
+ */
+void
+setNumberOfAsyncWorker(const uint32_t numberOfWorker)
+{
+    AsyncWorker::getInstance()->setNumberOfThreads(numberOfWorker);
+}
+
+/**
+ * @brief asynchronous version of getDatasetData
+ */
+std::future<AsyncResult<Kitsunemimi::DataBuffer*>>
+getDatasetDataAsync(const std::string &token,
+                    const std::string &uuid,
+                    const std::string &columnName)
+{
+    return runAsync<Kitsunemimi::DataBuffer*>([=](AsyncResult<Kitsunemimi::DataBuffer*> &r)
+    {
+        r.result = getDatasetData(token, uuid, columnName, r.error);
+        r.success = r.result != nullptr;
+    });
+}
+
+/**
+ * @brief asynchronous version of getDataSetInformation
+ */
+std::future<AsyncResult<Kitsunemimi::JsonItem>>
+getDataSetInformationAsync(const std::string &dataSetUuid,
+                           const std::string &token)
+{
+    return runAsync<Kitsunemimi::JsonItem>([=](AsyncResult<Kitsunemimi::JsonItem> &r)
+    {
+        r.success = getDataSetInformation(r.result, dataSetUuid, token, r.error);
+    });
+}
+
+/**
+ * @brief asynchronous version of getSnapshotData
+ */
+std::future<AsyncResult<Kitsunemimi::DataBuffer*>>
+getSnapshotDataAsync(const std::string &location)
+{
+    return runAsync<Kitsunemimi::DataBuffer*>([=](AsyncResult<Kitsunemimi::DataBuffer*> &r)
+    {
+        r.result = getSnapshotData(location, r.error);
+        r.success = r.result != nullptr;
+    });
+}
+
+/**
+ * @brief asynchronous version of getSnapshotInformation
+ */
+std::future<AsyncResult<Kitsunemimi::JsonItem>>
+getSnapshotInformationAsync(const std::string &snapshotUuid,
+                            const std::string &token)
+{
+    return runAsync<Kitsunemimi::JsonItem>([=](AsyncResult<Kitsunemimi::JsonItem> &r)
+    {
+        r.success = getSnapshotInformation(r.result, snapshotUuid, token, r.error);
+    });
+}
+
+/**
+ * @brief asynchronous version of runSnapshotInitProcess
+ *
+ * @return future with the uuid of the temporary file in shiori as result
+ */
+std::future<AsyncResult<std::string>>
+runSnapshotInitProcessAsync(const std::string &snapshotUuid,
+                            const std::string &snapshotName,
+                            const std::string &userId,
+                            const std::string &projectId,
+                            const uint64_t totalSize,
+                            const std::string &headerMessage,
+                            const std::string &token)
+{
+    return runAsync<std::string>([=](AsyncResult<std::string> &r)
+    {
+        r.success = runSnapshotInitProcess(r.result,
+                                           snapshotUuid,
+                                           snapshotName,
+                                           userId,
+                                           projectId,
+                                           totalSize,
+                                           headerMessage,
+                                           token,
+                                           r.error);
+    });
+}
+
+/**
+ * @brief asynchronous version of sendData. The data must not be deleted, before the returned
+ *        future is fulfilled.
+ *
+ * @return future with the position behind the sent data as result
+ */
+std::future<AsyncResult<uint64_t>>
+sendDataAsync(const Kitsunemimi::DataBuffer* data,
+              const uint64_t targetPos,
+              const std::string &uuid,
+              const std::string &fileUuid)
+{
+    return runAsync<uint64_t>([=](AsyncResult<uint64_t> &r)
+    {
+        r.result = targetPos;
+        r.success = sendData(data, r.result, uuid, fileUuid, r.error);
+    });
+}
+
+/**
+ * @brief asynchronous version of runSnapshotFinalizeProcess
+ */
+std::future<AsyncResult<bool>>
+runSnapshotFinalizeProcessAsync(const std::string &snapshotUuid,
+                                const std::string &fileUuid,
+                                const std::string &token,
+                                const std::string &userId,
+                                const std::string &projectId)
+{
+    return runAsync<bool>([=](AsyncResult<bool> &r)
+    {
+        r.success = runSnapshotFinalizeProcess(snapshotUuid,
+                                               fileUuid,
+                                               token,
+                                               userId,
+                                               projectId,
+                                               r.error);
+        r.result = r.success;
+    });
+}
+
+/**
+ * @brief asynchronous version of sendResults. The results must not be deleted, before the
+ *        returned future is fulfilled.
+ */
+std::future<AsyncResult<bool>>
+sendResultsAsync(const std::string &uuid,
+                 const std::string &name,
+                 const std::string &userId,
+                 const std::string &projectId,
+                 const Kitsunemimi::DataArray* results)
+{
+    return runAsync<bool>([=](AsyncResult<bool> &r)
+    {
+        r.success = sendResults(uuid, name, userId, projectId, *results, r.error);
+        r.result = r.success;
+    });
+}
+
+/**
+ * @brief asynchronous version of sendErrorMessage
+ */
+std::future<AsyncResult<bool>>
+sendErrorMessageAsync(const std::string &userId,
+                      const std::string &errorMessage)
+{
+    return runAsync<bool>([=](AsyncResult<bool> &r)
+    {
+        r.success = sendErrorMessage(userId, errorMessage, r.error);
+        r.result = r.success;
+    });
+}
+
+/**
+ * @brief asynchronous version of sendAuditMessage
+ */
+std::future<AsyncResult<bool>>
+sendAuditMessageAsync(const std::string &targetComponent,
+                      const std::string &targetEndpoint,
+                      const std::string &userId,
+                      const Kitsunemimi::Hanami::HttpRequestType requestType)
+{
+    return runAsync<bool>([=](AsyncResult<bool> &r)
+    {
+        r.success = sendAuditMessage(targetComponent,
+                                     targetEndpoint,
+                                     userId,
+                                     requestType,
+                                     r.error);
+        r.result = r.success;
+    });
+}
+
+}
@@ -0,0 +1,126 @@
+/**
+ * @file        async_worker.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <async_worker.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ */
+AsyncWorker::AsyncWorker() {}
+
+/**
+ * @brief get instance of the worker
+ *
+ * @return pointer to the static instance
+ */
+AsyncWorker*
+AsyncWorker::getInstance()
+{
+    static AsyncWorker* instance = new AsyncWorker();
+    return instance;
+}
+
+/**
+ * @brief set number of threads, which process the tasks. Because all requests to shiori are
+ *        blocking, this is also the maximum number of requests in flight at the same time.
+ *
+ * @param numberOfThreads new number of threads
+ */
+void
+AsyncWorker::setNumberOfThreads(const uint32_t numberOfThreads)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_targetNumberOfThreads = std::max(numberOfThreads, 1u);
+    if(m_numberOfThreads > 0) {
+        startThreads();
+    }
+
+    // wake up all threads, so surplus threads can stop
+    m_cv.notify_all();
+}
+
+/**
+ * @brief add new task to the queue. The threads are started with the first task.
+ *
+ * @param task task to process
+ */
+void
+AsyncWorker::addTask(const std::function<void()> &task)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_tasks.push_back(task);
+    startThreads();
+    m_cv.notify_one();
+}
+
+/**
+ * @brief start missing threads. Must be called while holding the lock.
+ */
+void
+AsyncWorker::startThreads()
+{
+    while(m_numberOfThreads < m_targetNumberOfThreads)
+    {
+        std::thread(&AsyncWorker::run, this).detach();
+        m_numberOfThreads++;
+    }
+}
+
+/**
+ * @brief loop of a single thread
+ */
+void
+AsyncWorker::run()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    while(true)
+    {
+        m_cv.wait(lock, [this] {
+            return m_tasks.empty() == false
+                   || m_numberOfThreads > m_targetNumberOfThreads;
+        });
+
+        if(m_numberOfThreads > m_targetNumberOfThreads)
+        {
+            m_numberOfThreads--;
+            return;
+        }
+
+        std::function<void()> task = m_tasks.front();
+        m_tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+}
@@ -0,0 +1,57 @@
+/**
+ * @file        async_worker.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_ASYNC_WORKER_H
+#define KITSUNEMIMI_HANAMI_SHIORI_ASYNC_WORKER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+namespace Shiori
+{
+
+class AsyncWorker
+{
+public:
+    static AsyncWorker* getInstance();
+
+    void setNumberOfThreads(const uint32_t numberOfThreads);
+    void addTask(const std::function<void()> &task);
+
+private:
+    AsyncWorker();
+
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_tasks;
+    uint32_t m_numberOfThreads = 0;
+    uint32_t m_targetNumberOfThreads = 8;
+
+    void startThreads();
+    void run();
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_ASYNC_WORKER_H
@@ -0,0 +1,331 @@
+/**
+ * @file        audit_queue.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <audit_queue.h>
+#include <buffer_pool.h>
+#include <client_pool.h>
+#include <metrics_collector.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <libKitsunemimiCommon/logger.h>
+
+#include <libKitsunemimiHanamiNetwork/hanami_messaging.h>
+#include <libKitsunemimiHanamiNetwork/hanami_messaging_client.h>
+
+#include <../../libKitsunemimiHanamiMessages/protobuffers/shiori_messages.proto3.pb.h>
+#include <../../libKitsunemimiHanamiMessages/message_sub_types.h>
+
+namespace Shiori
+{
+
+// upper limit of not yet sent entries, to keep the memory bounded, if shiori is not reachable
+const uint64_t MAX_PENDING_AUDIT_ENTRIES = 1000000;
+
+/**
+ * @brief constructor
+ */
+AuditQueue::AuditQueue()
+{
+    m_tail = new AuditEntry();
+    m_head = m_tail;
+}
+
+/**
+ * @brief get instance of the queue
+ *
+ * @return pointer to the static instance
+ */
+AuditQueue*
+AuditQueue::getInstance()
+{
+    static AuditQueue* instance = new AuditQueue();
+    return instance;
+}
+
+/**
+ * @brief start background-thread to send the queued entries. The batch-size only controls,
+ *        how often the thread wakes up. Each entry is still sent as its own message, because
+ *        shiori has no message for multiple audit-entries.
+ *
+ * @param maxBatchSize number of pending entries, which wake up the thread before the interval
+ *                     ends, and maximum number of entries sent per wake-up
+ * @param flushIntervalMs maximum time in milliseconds, how long an entry is queued
+ *
+ * @return false, if already active, else true
+ */
+bool
+AuditQueue::start(const uint32_t maxBatchSize,
+                  const uint32_t flushIntervalMs)
+{
+    std::lock_guard<std::mutex> threadGuard(m_threadLock);
+
+    if(m_active) {
+        return false;
+    }
+
+    m_maxBatchSize = std::max(maxBatchSize, 1u);
+    m_flushIntervalMs = std::max(flushIntervalMs, 1u);
+    m_active = true;
+    m_thread = std::thread(&AuditQueue::run, this);
+
+    return true;
+}
+
+/**
+ * @brief stop background-thread after all pending entries were sent. Entries, which are pushed
+ *        while stopping, are either sent before the thread ends or rejected.
+ */
+void
+AuditQueue::stop()
+{
+    // held until the thread is joined, so a concurrent start can't replace the running thread
+    std::lock_guard<std::mutex> threadGuard(m_threadLock);
+
+    if(m_active == false) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_active = false;
+        m_cv.notify_one();
+    }
+    m_thread.join();
+}
+
+/**
+ * @brief check if the queue is active
+ *
+ * @return true, if background-thread is running, else false
+ */
+bool
+AuditQueue::isActive() const
+{
+    return m_active;
+}
+
+/**
+ * @brief add new entry to the queue. Can be called by multiple threads at the same time and
+ *        never blocks.
+ *
+ * @param component accessed component
+ * @param endpoint accessed endpoint
+ * @param userId user-id who made the request to the endpoint
+ * @param httpType http-type of the request
+ *
+ * @return AUDIT_QUEUE_INACTIVE, if the queue is not started or is stopping, AUDIT_QUEUE_FULL,
+ *         if the queue is full, else AUDIT_ENTRY_QUEUED
+ */
+AuditPushResult
+AuditQueue::push(const std::string &component,
+                 const std::string &endpoint,
+                 const std::string &userId,
+                 const std::string &httpType)
+{
+    // registered before the check, so stop can't finish, before this entry is queued
+    m_numberOfPushing++;
+    if(m_active == false)
+    {
+        m_numberOfPushing--;
+        m_numberOfRejected++;
+        return AUDIT_QUEUE_INACTIVE;
+    }
+
+    if(m_numberOfPending >= MAX_PENDING_AUDIT_ENTRIES)
+    {
+        m_numberOfPushing--;
+        m_numberOfDropped++;
+        return AUDIT_QUEUE_FULL;
+    }
+
+    AuditEntry* entry = new AuditEntry();
+    entry->component = component;
+    entry->endpoint = endpoint;
+    entry->userId = userId;
+    entry->httpType = httpType;
+
+    AuditEntry* prev = m_head.exchange(entry, std::memory_order_acq_rel);
+    prev->next.store(entry, std::memory_order_release);
+
+    if(m_numberOfPending.fetch_add(1) + 1 == m_maxBatchSize) {
+        m_cv.notify_one();
+    }
+    m_numberOfPushing--;
+
+    return AUDIT_ENTRY_QUEUED;
+}
+
+/**
+ * @brief get number of entries, which were rejected, because the queue was not active
+ *
+ * @return number of rejected entries
+ */
+uint64_t
+AuditQueue::getNumberOfRejected() const
+{
+    return m_numberOfRejected;
+}
+
+/**
+ * @brief get number of entries, which were discarded, because there was no client to shiori
+ *
+ * @return number of discarded entries
+ */
+uint64_t
+AuditQueue::getNumberOfDiscarded() const
+{
+    return m_numberOfDiscarded;
+}
+
+/**
+ * @brief get next entry from the queue. Must be only called by the background-thread.
+ *
+ * @param output reference for the content of the entry
+ *
+ * @return false, if queue is empty, else true
+ */
+bool
+AuditQueue::pop(AuditEntry &output)
+{
+    AuditEntry* next = m_tail->next.load(std::memory_order_acquire);
+    if(next == nullptr) {
+        return false;
+    }
+
+    // the next entry becomes the new stub-node, so only its content is moved
+    output.component = std::move(next->component);
+    output.endpoint = std::move(next->endpoint);
+    output.userId = std::move(next->userId);
+    output.httpType = std::move(next->httpType);
+
+    delete m_tail;
+    m_tail = next;
+    m_numberOfPending--;
+
+    return true;
+}
+
+/**
+ * @brief loop of the background-thread
+ */
+void
+AuditQueue::run()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    while(m_active)
+    {
+        m_cv.wait_for(lock, std::chrono::milliseconds(m_flushIntervalMs), [this] {
+            return m_active == false
+                   || m_numberOfPending >= m_maxBatchSize;
+        });
+
+        lock.unlock();
+        while(sendBatch() > 0) {}
+        lock.lock();
+    }
+
+    // wait for entries, which are pushed at the moment, and send all remaining entries
+    lock.unlock();
+    while(m_numberOfPushing > 0) {
+        std::this_thread::yield();
+    }
+    while(sendBatch() > 0) {}
+}
+
+/**
+ * @brief send up to one batch of entries to shiori
+ *
+ * @return number of processed entries
+ */
+uint64_t
+AuditQueue::sendBatch()
+{
+    const uint64_t dropped = m_numberOfDropped.exchange(0);
+    if(dropped > 0) {
+        LOG_WARNING("Dropped " + std::to_string(dropped)
+                    + " audit-messages, because the queue was full");
+    }
+
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
+
+    // message and buffer are reused for all entries of the batch
+    AuditEntry entry;
+    AuditLog_Message msg;
+    PooledBuffer buffer;
+    uint64_t numberOfEntries = 0;
+
+    while(numberOfEntries < m_maxBatchSize
+          && pop(entry))
+    {
+        numberOfEntries++;
+        if(client == nullptr) {
+            continue;
+        }
+
+        msg.set_userid(entry.userId);
+        msg.set_type(entry.httpType);
+        msg.set_component(entry.component);
+        msg.set_endpoint(entry.endpoint);
+
+        Kitsunemimi::ErrorContainer error;
+        uint64_t msgSize = 0;
+        const uint8_t* serialized = serializeMessage(buffer, msgSize, msg, error);
+        if(serialized == nullptr)
+        {
+            error.addMeesage("Failed to serialize audit-message to shiori");
+            LOG_ERROR(error);
+            continue;
+        }
+
+        MetricsCollector::getInstance()->add(SEND_AUDIT_MESSAGE_OPERATION,
+                                             BYTES_SENT_FIELD,
+                                             msgSize);
+        if(client->sendGenericMessage(SHIORI_AUDIT_LOG_MESSAGE_TYPE,
+                                      serialized,
+                                      msgSize,
+                                      error) == false)
+        {
+            error.addMeesage("Failed to send audit-message to shiori");
+            LOG_ERROR(error);
+        }
+    }
+
+    if(client == nullptr
+            && numberOfEntries > 0)
+    {
+        m_numberOfDiscarded += numberOfEntries;
+
+        Kitsunemimi::ErrorContainer error;
+        error.addMeesage("Failed to get client for connection to shiori, so "
+                         + std::to_string(numberOfEntries) + " audit-messages are discarded");
+        error.addSolution("Check if shiori is correctly configured");
+        LOG_ERROR(error);
+    }
+
+    return numberOfEntries;
+}
+
+}
@@ -0,0 +1,97 @@
+/**
+ * @file        audit_queue.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_AUDIT_QUEUE_H
+#define KITSUNEMIMI_HANAMI_SHIORI_AUDIT_QUEUE_H
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Shiori
+{
+
+enum AuditPushResult
+{
+    AUDIT_ENTRY_QUEUED = 0,
+    AUDIT_QUEUE_FULL = 1,
+    AUDIT_QUEUE_INACTIVE = 2,
+};
+
+struct AuditEntry
+{
+    std::atomic<AuditEntry*> next = {nullptr};
+    std::string component = "";
+    std::string endpoint = "";
+    std::string userId = "";
+    std::string httpType = "";
+};
+
+class AuditQueue
+{
+public:
+    static AuditQueue* getInstance();
+
+    bool start(const uint32_t maxBatchSize, const uint32_t flushIntervalMs);
+    void stop();
+    bool isActive() const;
+
+    AuditPushResult push(const std::string &component,
+                         const std::string &endpoint,
+                         const std::string &userId,
+                         const std::string &httpType);
+
+    uint64_t getNumberOfRejected() const;
+    uint64_t getNumberOfDiscarded() const;
+
+private:
+    AuditQueue();
+
+    // lock-free multi-producer-single-consumer queue with a stub-node
+    std::atomic<AuditEntry*> m_head;
+    AuditEntry* m_tail = nullptr;
+    std::atomic<uint64_t> m_numberOfPending = {0};
+    std::atomic<uint64_t> m_numberOfDropped = {0};
+    std::atomic<uint64_t> m_numberOfRejected = {0};
+    std::atomic<uint64_t> m_numberOfDiscarded = {0};
+
+    std::atomic<bool> m_active = {false};
+    // number of threads within push, which the background-thread waits for before it stops
+    std::atomic<uint32_t> m_numberOfPushing = {0};
+    std::thread m_thread;
+    // serializes start and stop, which create and join the background-thread
+    std::mutex m_threadLock;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    uint32_t m_maxBatchSize = 1;
+    uint32_t m_flushIntervalMs = 0;
+
+    bool pop(AuditEntry &output);
+    void run();
+    uint64_t sendBatch();
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_AUDIT_QUEUE_H
@@ -0,0 +1,388 @@
+/**
+ * @file        buffer_pool.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+
+#include <buffer_pool.h>
+
+#include <limits>
+
+namespace Shiori
+{
+
+/**
+ * @brief get the size-class of a buffer-size
+ *
+ * @param size requested size in bytes
+ *
+ * @return size-class, which is NUMBER_OF_SIZE_CLASSES for sizes above the biggest class
+ */
+static uint32_t
+getSizeClass(const uint64_t size)
+{
+    uint32_t shift = MIN_BUFFER_SIZE_SHIFT;
+    while(shift <= MAX_BUFFER_SIZE_SHIFT
+          && (static_cast<uint64_t>(1) << shift) < size)
+    {
+        shift++;
+    }
+
+    return shift - MIN_BUFFER_SIZE_SHIFT;
+}
+
+/**
+ * @brief constructor
+ */
+BufferPool::BufferPool() {}
+
+/**
+ * @brief get instance of the pool
+ *
+ * @return pointer to the static instance
+ */
+BufferPool*
+BufferPool::getInstance()
+{
+    static BufferPool* instance = new BufferPool();
+    return instance;
+}
+
+/**
+ * @brief destructor of the free buffers of a thread, which moves the buffers of the finished
+ *        thread into the pool
+ */
+BufferPool::ThreadCache::~ThreadCache()
+{
+    BufferPool::getInstance()->retire(this);
+}
+
+/**
+ * @brief get a buffer from the pool. Buffers up to the biggest size-class are reused, bigger
+ *        ones are allocated for each request.
+ *
+ * @param capacity reference for the real size of the buffer, which has to be given back to
+ *                 the pool together with the buffer
+ * @param size minimum size of the buffer in bytes
+ * @param error reference for error-output
+ *
+ * @return pointer to the buffer, if successful, else nullptr
+ */
+uint8_t*
+BufferPool::acquire(uint64_t &capacity,
+                    const uint64_t size,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    const uint32_t sizeClass = getSizeClass(size);
+    capacity = size;
+    if(sizeClass < NUMBER_OF_SIZE_CLASSES)
+    {
+        capacity = static_cast<uint64_t>(1) << (sizeClass + MIN_BUFFER_SIZE_SHIFT);
+
+        // free buffers of the own thread can be used without lock
+        std::vector<uint8_t*>* threadBuffers = &getThreadCache()->freeBuffers[sizeClass];
+        if(threadBuffers->size() > 0)
+        {
+            uint8_t* buffer = threadBuffers->back();
+            threadBuffers->pop_back();
+            return buffer;
+        }
+
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(m_freeBuffers[sizeClass].size() > 0)
+        {
+            uint8_t* buffer = m_freeBuffers[sizeClass].back();
+            m_freeBuffers[sizeClass].pop_back();
+            return buffer;
+        }
+    }
+
+    if(reserve(capacity) == false)
+    {
+        error.addMeesage("Failed to get buffer with "
+                         + std::to_string(size)
+                         + " bytes, because the memory-limit of "
+                         + std::to_string(m_limit)
+                         + " bytes for buffers is reached");
+        error.addSolution("Increase the limit with setBufferPoolLimit");
+        return nullptr;
+    }
+
+    return new uint8_t[capacity];
+}
+
+/**
+ * @brief give a buffer back to the pool
+ *
+ * @param buffer buffer to give back
+ * @param capacity capacity of the buffer, which was returned together with the buffer
+ */
+void
+BufferPool::release(uint8_t* buffer,
+                    const uint64_t capacity)
+{
+    if(buffer == nullptr) {
+        return;
+    }
+
+    const uint32_t sizeClass = getSizeClass(capacity);
+    if(sizeClass < NUMBER_OF_SIZE_CLASSES)
+    {
+        std::vector<uint8_t*>* threadBuffers = &getThreadCache()->freeBuffers[sizeClass];
+        if(threadBuffers->size() < MAX_FREE_BUFFERS_PER_THREAD)
+        {
+            threadBuffers->push_back(buffer);
+            return;
+        }
+    }
+
+    freeBuffer(buffer, capacity);
+}
+
+/**
+ * @brief set the maximum number of bytes, which can be allocated for buffers at the same time.
+ *        By default there is no limit.
+ *
+ * @param limit new limit in bytes
+ */
+void
+BufferPool::setLimit(const uint64_t limit)
+{
+    m_limit = limit;
+    if(m_allocatedSize > limit) {
+        trim();
+    }
+}
+
+/**
+ * @brief get the maximum number of bytes, which can be allocated for buffers
+ *
+ * @return limit in bytes
+ */
+uint64_t
+BufferPool::getLimit() const
+{
+    return m_limit;
+}
+
+/**
+ * @brief get the number of bytes, which are allocated for used and free buffers
+ *
+ * @return number of allocated bytes
+ */
+uint64_t
+BufferPool::getAllocatedSize() const
+{
+    return m_allocatedSize;
+}
+
+/**
+ * @brief get free buffers of the current thread
+ *
+ * @return pointer to the free buffers of the current thread
+ */
+BufferPool::ThreadCache*
+BufferPool::getThreadCache()
+{
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+/**
+ * @brief reserve memory within the limit for a new buffer. If the limit is reached, the free
+ *        buffers are released before the reservation fails.
+ *
+ * @param size number of bytes to reserve
+ *
+ * @return true, if the memory is within the limit, else false
+ */
+bool
+BufferPool::reserve(const uint64_t size)
+{
+    for(uint32_t attempt = 0; attempt < 2; attempt++)
+    {
+        if(m_allocatedSize.fetch_add(size) + size <= m_limit) {
+            return true;
+        }
+        m_allocatedSize.fetch_sub(size);
+
+        if(attempt == 0) {
+            trim();
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief release the free buffers of the current thread and of the finished threads. Free
+ *        buffers of other running threads can not be touched without lock.
+ */
+void
+BufferPool::trim()
+{
+    ThreadCache* cache = getThreadCache();
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for(uint32_t sizeClass = 0; sizeClass < NUMBER_OF_SIZE_CLASSES; sizeClass++)
+    {
+        const uint64_t capacity = static_cast<uint64_t>(1) << (sizeClass + MIN_BUFFER_SIZE_SHIFT);
+        for(uint8_t* buffer : cache->freeBuffers[sizeClass]) {
+            freeBuffer(buffer, capacity);
+        }
+        for(uint8_t* buffer : m_freeBuffers[sizeClass]) {
+            freeBuffer(buffer, capacity);
+        }
+        cache->freeBuffers[sizeClass].clear();
+        m_freeBuffers[sizeClass].clear();
+    }
+}
+
+/**
+ * @brief move the free buffers of a finished thread into the pool, so they can be used by
+ *        other threads
+ *
+ * @param cache free buffers of the finished thread
+ */
+void
+BufferPool::retire(ThreadCache* cache)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for(uint32_t sizeClass = 0; sizeClass < NUMBER_OF_SIZE_CLASSES; sizeClass++)
+    {
+        const uint64_t capacity = static_cast<uint64_t>(1) << (sizeClass + MIN_BUFFER_SIZE_SHIFT);
+        for(uint8_t* buffer : cache->freeBuffers[sizeClass])
+        {
+            if(m_freeBuffers[sizeClass].size() < MAX_GLOBAL_FREE_BUFFERS) {
+                m_freeBuffers[sizeClass].push_back(buffer);
+            }
+            else {
+                freeBuffer(buffer, capacity);
+            }
+        }
+        cache->freeBuffers[sizeClass].clear();
+    }
+}
+
+/**
+ * @brief delete a buffer and remove it from the accounting
+ *
+ * @param buffer buffer to delete
+ * @param capacity capacity of the buffer
+ */
+void
+BufferPool::freeBuffer(uint8_t* buffer,
+                       const uint64_t capacity)
+{
+    delete[] buffer;
+    m_allocatedSize.fetch_sub(capacity);
+}
+
+/**
+ * @brief constructor
+ */
+PooledBuffer::PooledBuffer() {}
+
+/**
+ * @brief destructor, which gives the buffer back to the pool
+ */
+PooledBuffer::~PooledBuffer()
+{
+    BufferPool::getInstance()->release(m_buffer, m_capacity);
+}
+
+/**
+ * @brief get the buffer with at least the requested size. The buffer is only exchanged, if the
+ *        current one is too small, so it can be reused for multiple messages.
+ *
+ * @param size minimum size of the buffer in bytes
+ * @param error reference for error-output
+ *
+ * @return pointer to the buffer, if successful, else nullptr
+ */
+uint8_t*
+PooledBuffer::get(const uint64_t size,
+                  Kitsunemimi::ErrorContainer &error)
+{
+    if(m_buffer != nullptr
+            && m_capacity >= size)
+    {
+        return m_buffer;
+    }
+
+    BufferPool* pool = BufferPool::getInstance();
+    pool->release(m_buffer, m_capacity);
+    m_buffer = pool->acquire(m_capacity, size, error);
+    if(m_buffer == nullptr) {
+        m_capacity = 0;
+    }
+
+    return m_buffer;
+}
+
+/**
+ * @brief serialize a protobuf-message into a pooled buffer
+ *
+ * @param buffer buffer for the serialized message
+ * @param msgSize reference for the size of the serialized message
+ * @param msg message to serialize
+ * @param error reference for error-output
+ *
+ * @return pointer to the serialized message, if successful, else nullptr
+ */
+uint8_t*
+serializeMessage(PooledBuffer &buffer,
+                 uint64_t &msgSize,
+                 const google::protobuf::MessageLite &msg,
+                 Kitsunemimi::ErrorContainer &error)
+{
+    msgSize = msg.ByteSizeLong();
+    if(msgSize > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+    {
+        error.addMeesage("Failed to serialize message with "
+                         + std::to_string(msgSize)
+                         + " bytes, because protobuf can not serialize messages above 2 GiB");
+        return nullptr;
+    }
+
+    uint8_t* target = buffer.get(msgSize, error);
+    if(target == nullptr)
+    {
+        error.addMeesage("Failed to get buffer to serialize message");
+        return nullptr;
+    }
+
+    // size was already calculated and cached by ByteSizeLong
+    const uint8_t* end = msg.SerializeWithCachedSizesToArray(target);
+    if(end != target + msgSize)
+    {
+        error.addMeesage("Failed to serialize message, because "
+                         + std::to_string(end - target)
+                         + " bytes were written instead of "
+                         + std::to_string(msgSize)
+                         + " bytes");
+        return nullptr;
+    }
+
+    return target;
+}
+
+}
@@ -0,0 +1,111 @@
+/**
+ * @file        buffer_pool.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_BUFFER_POOL_H
+#define KITSUNEMIMI_HANAMI_SHIORI_BUFFER_POOL_H
+
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include <libKitsunemimiCommon/logger.h>
+
+#include <google/protobuf/message_lite.h>
+
+namespace Shiori
+{
+
+// smallest and biggest size-class of the pool as power of two (1 KiB to 64 MiB)
+const uint32_t MIN_BUFFER_SIZE_SHIFT = 10;
+const uint32_t MAX_BUFFER_SIZE_SHIFT = 26;
+const uint32_t NUMBER_OF_SIZE_CLASSES = MAX_BUFFER_SIZE_SHIFT - MIN_BUFFER_SIZE_SHIFT + 1;
+
+// maximum number of free buffers per size-class, which are kept by a single thread
+const uint32_t MAX_FREE_BUFFERS_PER_THREAD = 4;
+// maximum number of free buffers per size-class, which are kept from finished threads
+const uint32_t MAX_GLOBAL_FREE_BUFFERS = 16;
+
+// no limit by default, because a message, which doesn't fit into the limit, can not be sent
+const uint64_t DEFAULT_BUFFER_POOL_LIMIT = std::numeric_limits<uint64_t>::max();
+
+class BufferPool
+{
+public:
+    static BufferPool* getInstance();
+
+    uint8_t* acquire(uint64_t &capacity,
+                     const uint64_t size,
+                     Kitsunemimi::ErrorContainer &error);
+    void release(uint8_t* buffer, const uint64_t capacity);
+
+    void setLimit(const uint64_t limit);
+    uint64_t getLimit() const;
+    uint64_t getAllocatedSize() const;
+
+private:
+    BufferPool();
+
+    // free buffers of a single thread, which are only used by their own thread
+    struct ThreadCache
+    {
+        std::vector<uint8_t*> freeBuffers[NUMBER_OF_SIZE_CLASSES];
+        ~ThreadCache();
+    };
+
+    std::mutex m_lock;
+    // free buffers of already finished threads
+    std::vector<uint8_t*> m_freeBuffers[NUMBER_OF_SIZE_CLASSES];
+    std::atomic<uint64_t> m_allocatedSize = {0};
+    std::atomic<uint64_t> m_limit = {DEFAULT_BUFFER_POOL_LIMIT};
+
+    ThreadCache* getThreadCache();
+    bool reserve(const uint64_t size);
+    void trim();
+    void retire(ThreadCache* cache);
+    void freeBuffer(uint8_t* buffer, const uint64_t capacity);
+};
+
+class PooledBuffer
+{
+public:
+    PooledBuffer();
+    ~PooledBuffer();
+
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer& operator=(const PooledBuffer &) = delete;
+
+    uint8_t* get(const uint64_t size, Kitsunemimi::ErrorContainer &error);
+
+private:
+    uint8_t* m_buffer = nullptr;
+    uint64_t m_capacity = 0;
+};
+
+uint8_t* serializeMessage(PooledBuffer &buffer,
+                          uint64_t &msgSize,
+                          const google::protobuf::MessageLite &msg,
+                          Kitsunemimi::ErrorContainer &error);
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_BUFFER_POOL_H
@@ -0,0 +1,272 @@
+/**
+ * @file        client_pool.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <client_pool.h>
+
+#include <libKitsunemimiHanamiNetwork/hanami_messaging.h>
+#include <libKitsunemimiHanamiNetwork/hanami_messaging_client.h>
+
+using Kitsunemimi::Hanami::HanamiMessaging;
+using Kitsunemimi::Hanami::HanamiMessagingClient;
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ */
+ShioriClientPool::ShioriClientPool()
+    : m_defaultConnection(nullptr) {}
+
+/**
+ * @brief get instance of the pool
+ *
+ * @return pointer to the static instance
+ */
+ShioriClientPool*
+ShioriClientPool::getInstance()
+{
+    static ShioriClientPool* instance = new ShioriClientPool();
+    return instance;
+}
+
+/**
+ * @brief add a new client of the hanami-messaging to the pool
+ *
+ * @param client client with an own connection to shiori
+ *
+ * @return false, if client is invalid, already in the pool or the pool is full, else true
+ */
+bool
+ShioriClientPool::addClient(HanamiMessagingClient* client)
+{
+    if(client == nullptr) {
+        return false;
+    }
+
+    return addEntry(nullptr, client);
+}
+
+/**
+ * @brief add a new connection to the pool, which is not a client of the hanami-messaging
+ *
+ * @param connection connection to shiori
+ *
+ * @return false, if connection is invalid, already in the pool or the pool is full, else true
+ */
+bool
+ShioriClientPool::addConnection(ShioriConnection* connection)
+{
+    if(connection == nullptr) {
+        return false;
+    }
+
+    return addEntry(connection, nullptr);
+}
+
+/**
+ * @brief add a new entry to the pool
+ *
+ * @param connection connection to add, or nullptr to wrap the client into a new connection
+ * @param client client of the hanami-messaging, or nullptr for other connections
+ *
+ * @return false, if already in the pool or the pool is full, else true
+ */
+bool
+ShioriClientPool::addEntry(ShioriConnection* connection,
+                           HanamiMessagingClient* client)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    const uint32_t numberOfClients = m_numberOfClients.load();
+    if(numberOfClients >= MAX_NUMBER_OF_SHIORI_CLIENTS) {
+        return false;
+    }
+    for(uint32_t i = 0; i < numberOfClients; i++)
+    {
+        if((client != nullptr && m_entries[i].client == client)
+                || (connection != nullptr && m_entries[i].connection == connection))
+        {
+            return false;
+        }
+    }
+
+    // entries are never removed, so the wrapper of a client lives as long as the pool
+    if(connection == nullptr) {
+        connection = new HanamiConnection(client);
+    }
+
+    // the entry must be complete, before it becomes visible for the other threads
+    m_entries[numberOfClients].connection = connection;
+    m_entries[numberOfClients].client = client;
+    m_numberOfClients.store(numberOfClients + 1, std::memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief set how the client for a request is selected
+ *
+ * @param selection new type of selection
+ */
+void
+ShioriClientPool::setSelection(const ClientSelection selection)
+{
+    m_selection = selection;
+}
+
+/**
+ * @brief select a connection for a new request. As long as no connection was added to the
+ *        pool, the default client of the messaging is used.
+ *
+ * @param entryId reference for the id of the pool-entry, which has to be given back together
+ *                with the connection
+ *
+ * @return selected connection, or nullptr if there is no connection to shiori
+ */
+ShioriConnection*
+ShioriClientPool::acquire(uint32_t &entryId)
+{
+    entryId = MAX_NUMBER_OF_SHIORI_CLIENTS;
+    const uint32_t numberOfClients = m_numberOfClients.load(std::memory_order_acquire);
+    if(numberOfClients == 0)
+    {
+        if(HanamiMessaging::getInstance()->shioriClient == nullptr) {
+            return nullptr;
+        }
+        return &m_defaultConnection;
+    }
+
+    // the search for the least loaded client starts at the next client of the round-robin,
+    // so clients with the same load are used alternately
+    const uint32_t start = static_cast<uint32_t>(m_nextClient.fetch_add(1) % numberOfClients);
+    entryId = start;
+    if(m_selection == LEAST_LOADED_SELECTION)
+    {
+        uint64_t minLoad = m_entries[start].activeRequests.load(std::memory_order_relaxed);
+        for(uint32_t i = 1; i < numberOfClients && minLoad > 0; i++)
+        {
+            const uint32_t pos = (start + i) % numberOfClients;
+            const uint64_t load = m_entries[pos].activeRequests.load(std::memory_order_relaxed);
+            if(load < minLoad)
+            {
+                minLoad = load;
+                entryId = pos;
+            }
+        }
+    }
+
+    m_entries[entryId].activeRequests.fetch_add(1, std::memory_order_relaxed);
+
+    return m_entries[entryId].connection;
+}
+
+/**
+ * @brief give a client back after its request was finished
+ *
+ * @param entryId id of the pool-entry, which was returned together with the client
+ */
+void
+ShioriClientPool::release(const uint32_t entryId)
+{
+    if(entryId >= MAX_NUMBER_OF_SHIORI_CLIENTS) {
+        return;
+    }
+
+    m_entries[entryId].activeRequests.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief get the lock for the stream-messages of a connection
+ *
+ * @param entryId id of the pool-entry, which was returned together with the connection
+ *
+ * @return pointer to the lock of the entry, or to the lock of the default connection
+ */
+std::mutex*
+ShioriClientPool::getStreamLock(const uint32_t entryId)
+{
+    if(entryId >= MAX_NUMBER_OF_SHIORI_CLIENTS) {
+        return &m_defaultStreamLock;
+    }
+
+    return &m_entries[entryId].streamLock;
+}
+
+/**
+ * @brief constructor, which selects a client from the pool
+ */
+ClientLease::ClientLease()
+{
+    m_client = ShioriClientPool::getInstance()->acquire(m_entryId);
+}
+
+/**
+ * @brief destructor, which gives the client back to the pool
+ */
+ClientLease::~ClientLease()
+{
+    ShioriClientPool::getInstance()->release(m_entryId);
+}
+
+/**
+ * @brief get the selected connection
+ *
+ * @return selected connection, or nullptr if there is no connection to shiori
+ */
+ShioriConnection*
+ClientLease::getClient() const
+{
+    return m_client;
+}
+
+/**
+ * @brief send a stream-message over the selected connection. Multiple threads can use the
+ *        same connection at the same time, so the stream-messages of a connection are sent
+ *        one after another and only their preparation runs in parallel.
+ *
+ * @param data pointer to the data to send
+ * @param dataSize number of bytes to send
+ * @param replyExpected true to let shiori send a reply
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ClientLease::sendStreamMessage(const void* data,
+                               const uint64_t dataSize,
+                               const bool replyExpected,
+                               Kitsunemimi::ErrorContainer &error)
+{
+    if(m_client == nullptr)
+    {
+        error.addMeesage("Failed to get client to shiori");
+        return false;
+    }
+
+    std::mutex* streamLock = ShioriClientPool::getInstance()->getStreamLock(m_entryId);
+    std::lock_guard<std::mutex> guard(*streamLock);
+
+    return m_client->sendStreamMessage(data, dataSize, replyExpected, error);
+}
+
+}
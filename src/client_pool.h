@@ -0,0 +1,107 @@
+/**
+ * @file        client_pool.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_CLIENT_POOL_H
+#define KITSUNEMIMI_HANAMI_SHIORI_CLIENT_POOL_H
+
+#include <atomic>
+#include <mutex>
+
+#include <libShioriArchive/other.h>
+
+#include <hanami_connection.h>
+
+namespace Kitsunemimi {
+namespace Hanami {
+class HanamiMessagingClient;
+}
+}
+
+namespace Shiori
+{
+
+const uint32_t MAX_NUMBER_OF_SHIORI_CLIENTS = 64;
+
+class ShioriClientPool
+{
+public:
+    static ShioriClientPool* getInstance();
+
+    bool addClient(Kitsunemimi::Hanami::HanamiMessagingClient* client);
+    bool addConnection(ShioriConnection* connection);
+    void setSelection(const ClientSelection selection);
+
+    ShioriConnection* acquire(uint32_t &entryId);
+    void release(const uint32_t entryId);
+    std::mutex* getStreamLock(const uint32_t entryId);
+
+private:
+    ShioriClientPool();
+
+    struct PoolEntry
+    {
+        ShioriConnection* connection = nullptr;
+        // client of the hanami-messaging, if the connection wraps one, else nullptr
+        Kitsunemimi::Hanami::HanamiMessagingClient* client = nullptr;
+        // number of requests, which currently use the connection
+        std::atomic<uint64_t> activeRequests = {0};
+        // stream-messages of parallel requests must not be interleaved on the connection
+        std::mutex streamLock;
+    };
+
+    bool addEntry(ShioriConnection* connection,
+                  Kitsunemimi::Hanami::HanamiMessagingClient* client);
+
+    std::mutex m_lock;
+    // entries are only added and never removed, so they can be read without lock
+    PoolEntry m_entries[MAX_NUMBER_OF_SHIORI_CLIENTS];
+    std::atomic<uint32_t> m_numberOfClients = {0};
+    std::atomic<uint64_t> m_nextClient = {0};
+    std::atomic<ClientSelection> m_selection = {ROUND_ROBIN_SELECTION};
+    // used, as long as no connection was added to the pool
+    HanamiConnection m_defaultConnection;
+    std::mutex m_defaultStreamLock;
+};
+
+class ClientLease
+{
+public:
+    ClientLease();
+    ~ClientLease();
+
+    ClientLease(const ClientLease &) = delete;
+    ClientLease& operator=(const ClientLease &) = delete;
+
+    ShioriConnection* getClient() const;
+    bool sendStreamMessage(const void* data,
+                           const uint64_t dataSize,
+                           const bool replyExpected,
+                           Kitsunemimi::ErrorContainer &error);
+
+private:
+    ShioriConnection* m_client = nullptr;
+    uint32_t m_entryId = MAX_NUMBER_OF_SHIORI_CLIENTS;
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_CLIENT_POOL_H
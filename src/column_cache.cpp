@@ -0,0 +1,667 @@
+/**
+ * @file        column_cache.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <libShioriArchive/column_cache.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+namespace Shiori
+{
+
+// header at the beginning of each cache-file, followed by the key and the data of the column
+struct CacheFileHeader
+{
+    uint64_t magic = 0;
+    uint64_t keySize = 0;
+    uint64_t dataSize = 0;
+};
+
+const uint64_t CACHE_FILE_MAGIC = 0x314c4f4349524f48;  // "HORICOL1"
+const std::string CACHE_FILE_ENDING = ".column";
+
+/**
+ * @brief build key for a column of a data-set. The location of a data-set within shiori
+ *        changes, when the data-set is replaced, so entries of old data-sets can never match.
+ *
+ * @param location file-location of the data-set within shiori
+ * @param columnName name of the column
+ *
+ * @return key for the cache
+ */
+static const std::string
+buildKey(const std::string &location,
+         const std::string &columnName)
+{
+    return location + "\n" + columnName;
+}
+
+/**
+ * @brief create a new data-buffer with a copy of the given data
+ *
+ * @param data pointer to the data to copy
+ * @param dataSize number of bytes to copy
+ *
+ * @return pointer to new data-buffer
+ */
+static Kitsunemimi::DataBuffer*
+copyToBuffer(const void* data,
+             const uint64_t dataSize)
+{
+    Kitsunemimi::DataBuffer* result = new Kitsunemimi::DataBuffer();
+    Kitsunemimi::addData_DataBuffer(*result, data, dataSize);
+    return result;
+}
+
+/**
+ * @brief constructor
+ */
+ColumnCache::ColumnCache() {}
+
+/**
+ * @brief destructor
+ */
+ColumnCache::~ColumnCache()
+{
+    clear();
+}
+
+/**
+ * @brief get instance of the cache
+ *
+ * @return pointer to the static instance
+ */
+ColumnCache*
+ColumnCache::getInstance()
+{
+    static ColumnCache* instance = new ColumnCache();
+    return instance;
+}
+
+/**
+ * @brief set the maximum number of bytes, which can be held in memory. With a limit of 0
+ *        the memory-tier is disabled.
+ *
+ * @param memoryLimit new limit in bytes
+ */
+void
+ColumnCache::setMemoryLimit(const uint64_t memoryLimit)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_memoryLimit = memoryLimit;
+    evictMemory();
+}
+
+/**
+ * @brief initialize the disk-tier of the cache. Already existing cache-files within the
+ *        directory are taken over, so restarted processes can use them again.
+ *
+ * @param cacheDir directory for the cache-files
+ * @param diskLimit maximum number of bytes of all cache-files together
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ColumnCache::initDiskCache(const std::string &cacheDir,
+                           const uint64_t diskLimit,
+                           Kitsunemimi::ErrorContainer &error)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    if(ec)
+    {
+        error.addMeesage("Failed to create directory '" + cacheDir + "' for the column-cache");
+        return false;
+    }
+
+    // collect already existing cache-files
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+    for(const auto &dirEntry : std::filesystem::directory_iterator(cacheDir, ec))
+    {
+        if(dirEntry.path().extension() == CACHE_FILE_ENDING) {
+            files.emplace_back(dirEntry.last_write_time(ec), dirEntry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_cacheDir = cacheDir;
+    m_diskLimit = diskLimit;
+    m_diskUsage = 0;
+    m_diskEntries.clear();
+    m_diskLru.clear();
+
+    // register existing files, with the most recently used at the front
+    for(const auto &[writeTime, path] : files)
+    {
+        std::ifstream file(path, std::ios::binary);
+        CacheFileHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(CacheFileHeader));
+        if(file.good() == false
+                || header.magic != CACHE_FILE_MAGIC
+                || header.keySize > 64*1024)
+        {
+            std::filesystem::remove(path, ec);
+            continue;
+        }
+
+        std::string key(header.keySize, '\0');
+        file.read(&key[0], header.keySize);
+        if(file.good() == false)
+        {
+            std::filesystem::remove(path, ec);
+            continue;
+        }
+
+        DiskEntry entry;
+        entry.filePath = path.string();
+        entry.fileSize = sizeof(CacheFileHeader) + header.keySize + header.dataSize;
+        m_diskLru.push_front(key);
+        entry.lruPos = m_diskLru.begin();
+        m_diskEntries[key] = entry;
+        m_diskUsage += entry.fileSize;
+    }
+
+    evictDisk();
+
+    return true;
+}
+
+/**
+ * @brief get a column from the cache
+ *
+ * @param location file-location of the data-set within shiori
+ * @param columnName name of the column
+ *
+ * @return new data-buffer with a copy of the column, if found, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+ColumnCache::get(const std::string &location,
+                 const std::string &columnName)
+{
+    const std::string key = buildKey(location, columnName);
+
+    Kitsunemimi::DataBuffer* result = getFromMemory(key);
+    if(result != nullptr) {
+        return result;
+    }
+
+    result = getFromDisk(key);
+    if(result != nullptr)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        addToMemory(key, result);
+    }
+
+    return result;
+}
+
+/**
+ * @brief get a part of a column from the cache. The complete column is not loaded into the
+ *        memory-tier, if only found on disk, because a random access to the parts of a big
+ *        column would otherwise read the whole file for each part.
+ *
+ * @param result reference for the new data-buffer with a copy of the part, which is nullptr,
+ *               if the column is not cached or the part is not within the column
+ * @param columnSize reference for the size of the cached column
+ * @param location file-location of the data-set within shiori
+ * @param columnName name of the column
+ * @param offset byte-offset of the part within the column
+ * @param size number of bytes of the part
+ *
+ * @return true, if the column is cached, else false
+ */
+bool
+ColumnCache::getRange(Kitsunemimi::DataBuffer* &result,
+                      uint64_t &columnSize,
+                      const std::string &location,
+                      const std::string &columnName,
+                      const uint64_t offset,
+                      const uint64_t size)
+{
+    const std::string key = buildKey(location, columnName);
+
+    result = nullptr;
+    if(getRangeFromMemory(result, columnSize, key, offset, size)) {
+        return true;
+    }
+
+    return getRangeFromDisk(result, columnSize, key, offset, size);
+}
+
+/**
+ * @brief add a column to the cache
+ *
+ * @param location file-location of the data-set within shiori
+ * @param columnName name of the column
+ * @param data data of the column, which will be copied
+ */
+void
+ColumnCache::add(const std::string &location,
+                 const std::string &columnName,
+                 const Kitsunemimi::DataBuffer* data)
+{
+    const std::string key = buildKey(location, columnName);
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        addToMemory(key, data);
+    }
+
+    addToDisk(key, data);
+}
+
+/**
+ * @brief remove all entries of the memory-tier. The files of the disk-tier are kept, so they
+ *        can be used again later.
+ */
+void
+ColumnCache::clear()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for(auto &[key, entry] : m_memoryEntries) {
+        delete entry.data;
+    }
+    m_memoryEntries.clear();
+    m_memoryLru.clear();
+    m_memoryUsage = 0;
+}
+
+/**
+ * @brief get column from the memory-tier
+ *
+ * @param key key of the column
+ *
+ * @return new data-buffer with a copy of the column, if found, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+ColumnCache::getFromMemory(const std::string &key)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    auto it = m_memoryEntries.find(key);
+    if(it == m_memoryEntries.end()) {
+        return nullptr;
+    }
+
+    // mark as most recently used
+    m_memoryLru.splice(m_memoryLru.begin(), m_memoryLru, it->second.lruPos);
+
+    const Kitsunemimi::DataBuffer* data = it->second.data;
+    return copyToBuffer(data->data, data->usedBufferSize);
+}
+
+/**
+ * @brief get a part of a column from the memory-tier
+ *
+ * @param result reference for the new data-buffer with a copy of the part, which is nullptr,
+ *               if the part is not within the column
+ * @param columnSize reference for the size of the cached column
+ * @param key key of the column
+ * @param offset byte-offset of the part within the column
+ * @param size number of bytes of the part
+ *
+ * @return true, if the column is in the memory-tier, else false
+ */
+bool
+ColumnCache::getRangeFromMemory(Kitsunemimi::DataBuffer* &result,
+                                uint64_t &columnSize,
+                                const std::string &key,
+                                const uint64_t offset,
+                                const uint64_t size)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    auto it = m_memoryEntries.find(key);
+    if(it == m_memoryEntries.end()) {
+        return false;
+    }
+
+    // mark as most recently used
+    m_memoryLru.splice(m_memoryLru.begin(), m_memoryLru, it->second.lruPos);
+
+    const Kitsunemimi::DataBuffer* data = it->second.data;
+    columnSize = data->usedBufferSize;
+    if(offset <= columnSize
+            && size <= columnSize - offset)
+    {
+        const uint8_t* u8Data = static_cast<const uint8_t*>(data->data);
+        result = copyToBuffer(&u8Data[offset], size);
+    }
+
+    return true;
+}
+
+/**
+ * @brief add column to the memory-tier, if it fits into the limit
+ *
+ * @param key key of the column
+ * @param data data of the column, which will be copied
+ */
+void
+ColumnCache::addToMemory(const std::string &key,
+                         const Kitsunemimi::DataBuffer* data)
+{
+    if(data->usedBufferSize > m_memoryLimit
+            || m_memoryEntries.find(key) != m_memoryEntries.end())
+    {
+        return;
+    }
+
+    MemoryEntry entry;
+    entry.data = copyToBuffer(data->data, data->usedBufferSize);
+    m_memoryLru.push_front(key);
+    entry.lruPos = m_memoryLru.begin();
+    m_memoryEntries[key] = entry;
+    m_memoryUsage += data->usedBufferSize;
+
+    evictMemory();
+}
+
+/**
+ * @brief remove least recently used entries from the memory-tier until the limit is reached
+ */
+void
+ColumnCache::evictMemory()
+{
+    while(m_memoryUsage > m_memoryLimit
+          && m_memoryLru.empty() == false)
+    {
+        auto it = m_memoryEntries.find(m_memoryLru.back());
+        m_memoryUsage -= it->second.data->usedBufferSize;
+        delete it->second.data;
+        m_memoryEntries.erase(it);
+        m_memoryLru.pop_back();
+    }
+}
+
+/**
+ * @brief map the cache-file of a column into memory and validate its content
+ *
+ * @param file reference for the mapped file, which has to be unmapped by the caller
+ * @param key key of the column
+ *
+ * @return true, if the file is valid and mapped, else false
+ */
+bool
+ColumnCache::mapDiskEntry(MappedFile &file,
+                          const std::string &key)
+{
+    std::string filePath = "";
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        auto it = m_diskEntries.find(key);
+        if(it == m_diskEntries.end()) {
+            return false;
+        }
+
+        m_diskLru.splice(m_diskLru.begin(), m_diskLru, it->second.lruPos);
+        filePath = it->second.filePath;
+    }
+
+    // map file into memory
+    const int fd = open(filePath.c_str(), O_RDONLY);
+    if(fd == -1)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        removeDiskEntry(key);
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) == -1
+            || static_cast<uint64_t>(fileStat.st_size) < sizeof(CacheFileHeader))
+    {
+        close(fd);
+        return false;
+    }
+    const uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size);
+    void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED) {
+        return false;
+    }
+
+    // validate content of the file
+    const uint8_t* u8Mapped = static_cast<const uint8_t*>(mapped);
+    const CacheFileHeader* header = reinterpret_cast<const CacheFileHeader*>(u8Mapped);
+    if(header->magic != CACHE_FILE_MAGIC
+            || sizeof(CacheFileHeader) + header->keySize + header->dataSize != fileSize
+            || key.compare(0,
+                           std::string::npos,
+                           reinterpret_cast<const char*>(&u8Mapped[sizeof(CacheFileHeader)]),
+                           header->keySize) != 0)
+    {
+        munmap(mapped, fileSize);
+        std::lock_guard<std::mutex> guard(m_lock);
+        removeDiskEntry(key);
+        return false;
+    }
+
+    file.mapped = mapped;
+    file.mappedSize = fileSize;
+    file.data = &u8Mapped[sizeof(CacheFileHeader) + header->keySize];
+    file.dataSize = header->dataSize;
+
+    // update timestamp to keep the order of usage over restarts
+    std::error_code ec;
+    std::filesystem::last_write_time(filePath, std::filesystem::file_time_type::clock::now(), ec);
+
+    return true;
+}
+
+/**
+ * @brief get column from the disk-tier by mapping the cache-file into memory
+ *
+ * @param key key of the column
+ *
+ * @return new data-buffer with a copy of the column, if found, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+ColumnCache::getFromDisk(const std::string &key)
+{
+    MappedFile file;
+    if(mapDiskEntry(file, key) == false) {
+        return nullptr;
+    }
+
+    madvise(file.mapped, file.mappedSize, MADV_SEQUENTIAL);
+    Kitsunemimi::DataBuffer* result = copyToBuffer(file.data, file.dataSize);
+    munmap(file.mapped, file.mappedSize);
+
+    return result;
+}
+
+/**
+ * @brief get a part of a column from the disk-tier. Only the pages of the requested part are
+ *        read from the mapped cache-file.
+ *
+ * @param result reference for the new data-buffer with a copy of the part, which is nullptr,
+ *               if the part is not within the column
+ * @param columnSize reference for the size of the cached column
+ * @param key key of the column
+ * @param offset byte-offset of the part within the column
+ * @param size number of bytes of the part
+ *
+ * @return true, if the column is in the disk-tier, else false
+ */
+bool
+ColumnCache::getRangeFromDisk(Kitsunemimi::DataBuffer* &result,
+                              uint64_t &columnSize,
+                              const std::string &key,
+                              const uint64_t offset,
+                              const uint64_t size)
+{
+    MappedFile file;
+    if(mapDiskEntry(file, key) == false) {
+        return false;
+    }
+
+    columnSize = file.dataSize;
+    if(offset <= columnSize
+            && size <= columnSize - offset)
+    {
+        madvise(file.mapped, file.mappedSize, MADV_RANDOM);
+        result = copyToBuffer(&file.data[offset], size);
+    }
+    munmap(file.mapped, file.mappedSize);
+
+    return true;
+}
+
+/**
+ * @brief write column into a new cache-file of the disk-tier
+ *
+ * @param key key of the column
+ * @param data data of the column
+ */
+void
+ColumnCache::addToDisk(const std::string &key,
+                       const Kitsunemimi::DataBuffer* data)
+{
+    static std::atomic<uint64_t> tempCounter = {0};
+
+    std::string filePath = "";
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        const uint64_t fileSize = sizeof(CacheFileHeader) + key.size() + data->usedBufferSize;
+        if(m_cacheDir == ""
+                || fileSize > m_diskLimit
+                || m_diskEntries.find(key) != m_diskEntries.end())
+        {
+            return;
+        }
+        filePath = getFilePath(key);
+    }
+
+    // write into temporary file and rename it afterwards, so other processes never see
+    // incomplete cache-files
+    const std::string tempPath = filePath + ".tmp" + std::to_string(getpid())
+                                 + "_" + std::to_string(tempCounter.fetch_add(1));
+    CacheFileHeader header;
+    header.magic = CACHE_FILE_MAGIC;
+    header.keySize = key.size();
+    header.dataSize = data->usedBufferSize;
+
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(CacheFileHeader));
+    file.write(key.c_str(), static_cast<std::streamsize>(key.size()));
+    file.write(static_cast<const char*>(data->data),
+               static_cast<std::streamsize>(data->usedBufferSize));
+    file.close();
+
+    std::error_code ec;
+    if(file.fail())
+    {
+        LOG_WARNING("Failed to write cache-file '" + tempPath + "'");
+        std::filesystem::remove(tempPath, ec);
+        return;
+    }
+    std::filesystem::rename(tempPath, filePath, ec);
+    if(ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    removeDiskEntry(key);
+    DiskEntry entry;
+    entry.filePath = filePath;
+    entry.fileSize = sizeof(CacheFileHeader) + key.size() + data->usedBufferSize;
+    m_diskLru.push_front(key);
+    entry.lruPos = m_diskLru.begin();
+    m_diskEntries[key] = entry;
+    m_diskUsage += entry.fileSize;
+
+    evictDisk();
+}
+
+/**
+ * @brief remove least recently used files from the disk-tier until the limit is reached
+ */
+void
+ColumnCache::evictDisk()
+{
+    while(m_diskUsage > m_diskLimit
+          && m_diskLru.empty() == false)
+    {
+        const std::string key = m_diskLru.back();
+        auto it = m_diskEntries.find(key);
+
+        std::error_code ec;
+        std::filesystem::remove(it->second.filePath, ec);
+        removeDiskEntry(key);
+    }
+}
+
+/**
+ * @brief remove an entry from the index of the disk-tier, without removing the file
+ *
+ * @param key key of the column
+ */
+void
+ColumnCache::removeDiskEntry(const std::string &key)
+{
+    auto it = m_diskEntries.find(key);
+    if(it == m_diskEntries.end()) {
+        return;
+    }
+
+    m_diskUsage -= it->second.fileSize;
+    m_diskLru.erase(it->second.lruPos);
+    m_diskEntries.erase(it);
+}
+
+/**
+ * @brief get path of the cache-file for a column
+ *
+ * @param key key of the column
+ *
+ * @return path of the file
+ */
+const std::string
+ColumnCache::getFilePath(const std::string &key) const
+{
+    char name[17];
+    const uint64_t hash = std::hash<std::string>{}(key);
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return m_cacheDir + "/" + std::string(name) + CACHE_FILE_ENDING;
+}
+
+}
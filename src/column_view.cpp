@@ -0,0 +1,405 @@
+/**
+ * @file        column_view.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <libShioriArchive/column_view.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace Shiori
+{
+
+// below this number of values a column is converted by a single thread
+const uint64_t PARALLEL_CONVERT_LIMIT = 4 * 1024 * 1024;
+
+/**
+ * @brief convert values with plain c++ for cpus without sse4.1 and for the remaining values
+ *        of the vectorized conversions
+ *
+ * @param target target for the converted values
+ * @param source pointer to the raw values
+ * @param numberOfValues number of values to convert
+ * @param conversion type of the raw values and the conversion to apply
+ */
+template<typename T>
+static void
+convertScalar(float* target,
+              const uint8_t* source,
+              const uint64_t numberOfValues,
+              const ColumnConversion &conversion)
+{
+    for(uint64_t i = 0; i < numberOfValues; i++)
+    {
+        T value;
+        memcpy(&value, &source[i * sizeof(T)], sizeof(T));
+        target[i] = static_cast<float>(value) * conversion.scale + conversion.offset;
+    }
+}
+
+/**
+ * @brief convert values with plain c++
+ *
+ * @param target target for the converted values
+ * @param source pointer to the raw values
+ * @param numberOfValues number of values to convert
+ * @param conversion type of the raw values and the conversion to apply
+ */
+static void
+convertValuesScalar(float* target,
+                    const uint8_t* source,
+                    const uint64_t numberOfValues,
+                    const ColumnConversion &conversion)
+{
+    switch(conversion.sourceType)
+    {
+        case UINT8_VALUE_TYPE:
+            convertScalar<uint8_t>(target, source, numberOfValues, conversion);
+            break;
+        case UINT16_VALUE_TYPE:
+            convertScalar<uint16_t>(target, source, numberOfValues, conversion);
+            break;
+        case INT32_VALUE_TYPE:
+            convertScalar<int32_t>(target, source, numberOfValues, conversion);
+            break;
+        case FLOAT_VALUE_TYPE:
+            convertScalar<float>(target, source, numberOfValues, conversion);
+            break;
+    }
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief convert values with sse4.1 in blocks of 4 values
+ *
+ * @param target target for the converted values, aligned to 16 bytes
+ * @param source pointer to the raw values
+ * @param numberOfValues number of values to convert
+ * @param conversion type of the raw values and the conversion to apply
+ */
+__attribute__((target("sse4.1")))
+static void
+convertValuesSse(float* target,
+                 const uint8_t* source,
+                 const uint64_t numberOfValues,
+                 const ColumnConversion &conversion)
+{
+    const __m128 scale = _mm_set1_ps(conversion.scale);
+    const __m128 offset = _mm_set1_ps(conversion.offset);
+    const uint64_t valueSize = getColumnValueSize(conversion.sourceType);
+    const uint64_t numberOfBlocks = numberOfValues / 4;
+
+    for(uint64_t i = 0; i < numberOfBlocks; i++)
+    {
+        const uint8_t* block = &source[i * 4 * valueSize];
+        __m128 values;
+        switch(conversion.sourceType)
+        {
+            case UINT8_VALUE_TYPE:
+            {
+                int32_t raw;
+                memcpy(&raw, block, 4);
+                values = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(raw)));
+                break;
+            }
+            case UINT16_VALUE_TYPE:
+            {
+                const __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+                values = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(raw));
+                break;
+            }
+            case INT32_VALUE_TYPE:
+            {
+                const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+                values = _mm_cvtepi32_ps(raw);
+                break;
+            }
+            default:
+            {
+                values = _mm_loadu_ps(reinterpret_cast<const float*>(block));
+                break;
+            }
+        }
+        _mm_store_ps(&target[i * 4], _mm_add_ps(_mm_mul_ps(values, scale), offset));
+    }
+
+    const uint64_t done = numberOfBlocks * 4;
+    convertValuesScalar(&target[done],
+                        &source[done * valueSize],
+                        numberOfValues - done,
+                        conversion);
+}
+
+/**
+ * @brief convert values with avx2 in blocks of 8 values
+ *
+ * @param target target for the converted values, aligned to 32 bytes
+ * @param source pointer to the raw values
+ * @param numberOfValues number of values to convert
+ * @param conversion type of the raw values and the conversion to apply
+ */
+__attribute__((target("avx2")))
+static void
+convertValuesAvx2(float* target,
+                  const uint8_t* source,
+                  const uint64_t numberOfValues,
+                  const ColumnConversion &conversion)
+{
+    const __m256 scale = _mm256_set1_ps(conversion.scale);
+    const __m256 offset = _mm256_set1_ps(conversion.offset);
+    const uint64_t valueSize = getColumnValueSize(conversion.sourceType);
+    const uint64_t numberOfBlocks = numberOfValues / 8;
+
+    for(uint64_t i = 0; i < numberOfBlocks; i++)
+    {
+        const uint8_t* block = &source[i * 8 * valueSize];
+        __m256 values;
+        switch(conversion.sourceType)
+        {
+            case UINT8_VALUE_TYPE:
+            {
+                const __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+                values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(raw));
+                break;
+            }
+            case UINT16_VALUE_TYPE:
+            {
+                const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+                values = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(raw));
+                break;
+            }
+            case INT32_VALUE_TYPE:
+            {
+                const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+                values = _mm256_cvtepi32_ps(raw);
+                break;
+            }
+            default:
+            {
+                values = _mm256_loadu_ps(reinterpret_cast<const float*>(block));
+                break;
+            }
+        }
+        _mm256_store_ps(&target[i * 8], _mm256_add_ps(_mm256_mul_ps(values, scale), offset));
+    }
+
+    const uint64_t done = numberOfBlocks * 8;
+    convertValuesScalar(&target[done],
+                        &source[done * valueSize],
+                        numberOfValues - done,
+                        conversion);
+}
+#endif
+
+/**
+ * @brief convert values with the best available instruction-set of the cpu
+ *
+ * @param target target for the converted values, aligned to 32 bytes
+ * @param source pointer to the raw values
+ * @param numberOfValues number of values to convert
+ * @param conversion type of the raw values and the conversion to apply
+ */
+static void
+convertValues(float* target,
+              const uint8_t* source,
+              const uint64_t numberOfValues,
+              const ColumnConversion &conversion)
+{
+#if defined(__x86_64__)
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    static const bool hasSse41 = __builtin_cpu_supports("sse4.1");
+    if(hasAvx2)
+    {
+        convertValuesAvx2(target, source, numberOfValues, conversion);
+        return;
+    }
+    if(hasSse41)
+    {
+        convertValuesSse(target, source, numberOfValues, conversion);
+        return;
+    }
+#endif
+
+    convertValuesScalar(target, source, numberOfValues, conversion);
+}
+
+/**
+ * @brief get size of a single raw value
+ *
+ * @param type type of the value
+ *
+ * @return size of the value in bytes
+ */
+uint64_t
+getColumnValueSize(const ColumnValueType type)
+{
+    switch(type)
+    {
+        case UINT8_VALUE_TYPE:  return sizeof(uint8_t);
+        case UINT16_VALUE_TYPE: return sizeof(uint16_t);
+        case INT32_VALUE_TYPE:  return sizeof(int32_t);
+        case FLOAT_VALUE_TYPE:  return sizeof(float);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief constructor
+ */
+ColumnView::ColumnView() {}
+
+/**
+ * @brief destructor
+ */
+ColumnView::~ColumnView()
+{
+    free(m_values);
+}
+
+/**
+ * @brief convert raw values of a column into aligned float-values. An already existing memory
+ *        of the view is reused, if it is big enough. Big columns are converted by multiple
+ *        threads.
+ *
+ * @param data pointer to the raw values
+ * @param dataSize number of bytes of the raw values
+ * @param conversion type of the raw values and the conversion to apply
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ColumnView::convert(const void* data,
+                    const uint64_t dataSize,
+                    const ColumnConversion &conversion,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    const uint64_t valueSize = getColumnValueSize(conversion.sourceType);
+    if(dataSize % valueSize != 0)
+    {
+        error.addMeesage("Size of the column '"
+                         + std::to_string(dataSize)
+                         + "' is not a multiple of the size of its values '"
+                         + std::to_string(valueSize)
+                         + "'");
+        return false;
+    }
+    const uint64_t numberOfValues = dataSize / valueSize;
+
+    // allocate aligned memory, where the size must be a multiple of the alignment
+    const uint64_t alignedSize = std::max((numberOfValues * sizeof(float)
+                                           + COLUMN_VIEW_ALIGNMENT - 1)
+                                          / COLUMN_VIEW_ALIGNMENT
+                                          * COLUMN_VIEW_ALIGNMENT,
+                                          COLUMN_VIEW_ALIGNMENT);
+    if(alignedSize > m_capacity)
+    {
+        free(m_values);
+        m_values = static_cast<float*>(aligned_alloc(COLUMN_VIEW_ALIGNMENT, alignedSize));
+        m_capacity = alignedSize;
+        if(m_values == nullptr)
+        {
+            m_capacity = 0;
+            m_numberOfValues = 0;
+            error.addMeesage("Failed to allocate "
+                             + std::to_string(alignedSize)
+                             + " bytes for column-view");
+            return false;
+        }
+    }
+    m_numberOfValues = numberOfValues;
+
+    uint64_t numberOfThreads = 1;
+    if(numberOfValues >= PARALLEL_CONVERT_LIMIT) {
+        numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // each part starts at an aligned position of the target
+    const uint64_t valuesPerBlock = COLUMN_VIEW_ALIGNMENT / sizeof(float);
+    uint64_t valuesPerThread = (numberOfValues + numberOfThreads - 1) / numberOfThreads;
+    valuesPerThread = (valuesPerThread + valuesPerBlock - 1) / valuesPerBlock * valuesPerBlock;
+
+    float* values = m_values;
+    const uint8_t* u8Data = static_cast<const uint8_t*>(data);
+    std::vector<std::thread> threads;
+    for(uint64_t i = 1; i < numberOfThreads; i++)
+    {
+        const uint64_t begin = i * valuesPerThread;
+        if(begin >= numberOfValues) {
+            break;
+        }
+        const uint64_t partSize = std::min(valuesPerThread, numberOfValues - begin);
+        threads.emplace_back([=]()
+        {
+            convertValues(&values[begin], &u8Data[begin * valueSize], partSize, conversion);
+        });
+    }
+
+    convertValues(values, u8Data, std::min(valuesPerThread, numberOfValues), conversion);
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return true;
+}
+
+/**
+ * @brief get the converted values
+ *
+ * @return pointer to the values, aligned to COLUMN_VIEW_ALIGNMENT bytes
+ */
+const float*
+ColumnView::getValues() const
+{
+    return m_values;
+}
+
+/**
+ * @brief get the converted values
+ *
+ * @return pointer to the values, aligned to COLUMN_VIEW_ALIGNMENT bytes
+ */
+float*
+ColumnView::getValues()
+{
+    return m_values;
+}
+
+/**
+ * @brief get number of values of the view
+ *
+ * @return number of values
+ */
+uint64_t
+ColumnView::getNumberOfValues() const
+{
+    return m_numberOfValues;
+}
+
+}
@@ -0,0 +1,136 @@
+/**
+ * @file        crc32c.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <crc32c.h>
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace Shiori
+{
+
+// reversed polynomial of crc32c (castagnoli)
+const uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;
+
+/**
+ * @brief table-based crc32c for cpus without sse4.2
+ *
+ * @param crc inverted crc of the previous data
+ * @param data pointer to the data
+ * @param dataSize number of bytes
+ *
+ * @return inverted crc
+ */
+static uint32_t
+crc32cSoftware(uint32_t crc,
+               const uint8_t* data,
+               uint64_t dataSize)
+{
+    static uint32_t table[256];
+    static bool tableInitialized = []()
+    {
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t value = i;
+            for(uint32_t j = 0; j < 8; j++) {
+                value = (value & 1) ? (value >> 1) ^ CRC32C_POLYNOMIAL : value >> 1;
+            }
+            table[i] = value;
+        }
+        return true;
+    }();
+    (void)tableInitialized;
+
+    for(uint64_t i = 0; i < dataSize; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief crc32c with the crc32-instruction of sse4.2
+ *
+ * @param crc inverted crc of the previous data
+ * @param data pointer to the data
+ * @param dataSize number of bytes
+ *
+ * @return inverted crc
+ */
+__attribute__((target("sse4.2")))
+static uint32_t
+crc32cHardware(uint32_t crc,
+               const uint8_t* data,
+               uint64_t dataSize)
+{
+    uint64_t crc64 = crc;
+    while(dataSize >= 8)
+    {
+        uint64_t value;
+        memcpy(&value, data, 8);
+        crc64 = _mm_crc32_u64(crc64, value);
+        data += 8;
+        dataSize -= 8;
+    }
+
+    crc = static_cast<uint32_t>(crc64);
+    while(dataSize > 0)
+    {
+        crc = _mm_crc32_u8(crc, *data);
+        data++;
+        dataSize--;
+    }
+
+    return crc;
+}
+#endif
+
+/**
+ * @brief calculate crc32c-checksum of a block of data. If the cpu supports sse4.2, the
+ *        hardware-instruction is used.
+ *
+ * @param data pointer to the data
+ * @param dataSize number of bytes
+ *
+ * @return checksum
+ */
+uint32_t
+calculateCrc32c(const void* data,
+                const uint64_t dataSize)
+{
+    const uint8_t* u8Data = static_cast<const uint8_t*>(data);
+
+#if defined(__x86_64__)
+    static const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+    if(hasSse42) {
+        return ~crc32cHardware(0xffffffff, u8Data, dataSize);
+    }
+#endif
+
+    return ~crc32cSoftware(0xffffffff, u8Data, dataSize);
+}
+
+}
@@ -0,0 +1,254 @@
+/**
+ * @file        dataset_prefetcher.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <dataset_prefetcher.h>
+
+#include <algorithm>
+#include <thread>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ */
+DatasetPrefetcher::DatasetPrefetcher() {}
+
+/**
+ * @brief get instance of the prefetcher
+ *
+ * @return pointer to the static instance
+ */
+DatasetPrefetcher*
+DatasetPrefetcher::getInstance()
+{
+    static DatasetPrefetcher* instance = new DatasetPrefetcher();
+    return instance;
+}
+
+/**
+ * @brief set limits of the prefetcher
+ *
+ * @param memoryLimit maximum size of all prefetched buffers, which were not taken yet. If the
+ *                    limit is reached, no further fetch is started. A value of 0 disables
+ *                    the prefetching.
+ * @param numberOfThreads number of threads, which fetch at the same time
+ */
+void
+DatasetPrefetcher::setLimits(const uint64_t memoryLimit,
+                             const uint32_t numberOfThreads)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_memoryLimit = memoryLimit;
+    m_targetNumberOfThreads = std::max(numberOfThreads, 1u);
+    if(m_numberOfThreads > 0) {
+        startThreads();
+    }
+
+    // wake up all threads, so surplus threads can stop and the others check the new limit
+    m_workerCv.notify_all();
+}
+
+/**
+ * @brief register a new fetch. The fetches are started in the order of their registration.
+ *
+ * @param key identifier of the fetched data
+ * @param fetch function, which fetches the data
+ * @param error reference for error-output
+ *
+ * @return false, if prefetching is disabled, else true
+ */
+bool
+DatasetPrefetcher::add(const std::string &key,
+                       const std::function<Kitsunemimi::DataBuffer*(
+                           Kitsunemimi::ErrorContainer&)> &fetch,
+                       Kitsunemimi::ErrorContainer &error)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_memoryLimit == 0)
+    {
+        error.addMeesage("Prefetching of data-sets is disabled");
+        error.addSolution("Set a memory-limit greater than 0 with setDatasetPrefetchLimits");
+        return false;
+    }
+
+    // already registered fetches are not fetched again
+    if(m_entries.find(key) != m_entries.end()) {
+        return true;
+    }
+
+    std::shared_ptr<PrefetchEntry> entry = std::make_shared<PrefetchEntry>();
+    entry->fetch = fetch;
+    m_entries.insert(std::make_pair(key, entry));
+    m_pending.push_back(entry);
+
+    startThreads();
+    m_workerCv.notify_one();
+
+    return true;
+}
+
+/**
+ * @brief take the prefetched data. If the fetch is still running, it waits until the fetch is
+ *        finished. Not yet started fetches are removed, so the caller can fetch the data itself
+ *        without waiting for the queue.
+ *
+ * @param data reference for the prefetched data, which has to be deleted by the caller
+ * @param key identifier of the fetched data
+ *
+ * @return true, if prefetched data are available, else false
+ */
+bool
+DatasetPrefetcher::take(Kitsunemimi::DataBuffer* &data,
+                        const std::string &key)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    data = nullptr;
+    const auto it = m_entries.find(key);
+    if(it == m_entries.end()) {
+        return false;
+    }
+
+    std::shared_ptr<PrefetchEntry> entry = it->second;
+    if(entry->started == false)
+    {
+        entry->cancelled = true;
+        m_entries.erase(it);
+        return false;
+    }
+
+    m_readyCv.wait(lock, [&entry] {
+        return entry->finished || entry->cancelled;
+    });
+    if(entry->cancelled) {
+        return false;
+    }
+
+    m_entries.erase(key);
+    if(entry->data == nullptr)
+    {
+        LOG_WARNING("Prefetch failed and is retried: " + entry->errorMessage);
+        return false;
+    }
+
+    data = entry->data;
+    entry->data = nullptr;
+    m_memoryUsage -= data->usedBufferSize;
+    m_workerCv.notify_one();
+
+    return true;
+}
+
+/**
+ * @brief remove all registered fetches and delete all not yet taken data. Already running
+ *        fetches are finished, but their data are dropped.
+ */
+void
+DatasetPrefetcher::clear()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for(auto &[key, entry] : m_entries)
+    {
+        entry->cancelled = true;
+        delete entry->data;
+        entry->data = nullptr;
+    }
+    m_entries.clear();
+    m_pending.clear();
+    m_memoryUsage = 0;
+
+    m_readyCv.notify_all();
+}
+
+/**
+ * @brief start missing threads. Must be called while holding the lock.
+ */
+void
+DatasetPrefetcher::startThreads()
+{
+    while(m_numberOfThreads < m_targetNumberOfThreads)
+    {
+        std::thread(&DatasetPrefetcher::run, this).detach();
+        m_numberOfThreads++;
+    }
+}
+
+/**
+ * @brief loop of a single thread. A new fetch is only started, if the prefetched data, which
+ *        were not taken yet, are below the memory-limit. So the limit can be exceeded at most
+ *        by the running fetches.
+ */
+void
+DatasetPrefetcher::run()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    while(true)
+    {
+        m_workerCv.wait(lock, [this] {
+            return (m_pending.empty() == false && m_memoryUsage < m_memoryLimit)
+                   || m_numberOfThreads > m_targetNumberOfThreads;
+        });
+
+        if(m_numberOfThreads > m_targetNumberOfThreads)
+        {
+            m_numberOfThreads--;
+            return;
+        }
+
+        std::shared_ptr<PrefetchEntry> entry = m_pending.front();
+        m_pending.pop_front();
+        if(entry->cancelled) {
+            continue;
+        }
+        entry->started = true;
+
+        lock.unlock();
+        Kitsunemimi::ErrorContainer error;
+        Kitsunemimi::DataBuffer* data = entry->fetch(error);
+        lock.lock();
+
+        entry->finished = true;
+        if(entry->cancelled)
+        {
+            delete data;
+            continue;
+        }
+
+        entry->data = data;
+        if(data != nullptr) {
+            m_memoryUsage += data->usedBufferSize;
+        }
+        else {
+            entry->errorMessage = error.toString();
+        }
+        m_readyCv.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,88 @@
+/**
+ * @file        dataset_prefetcher.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_DATASET_PREFETCHER_H
+#define KITSUNEMIMI_HANAMI_SHIORI_DATASET_PREFETCHER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi {
+struct DataBuffer;
+}
+
+namespace Shiori
+{
+
+const uint64_t DEFAULT_PREFETCH_MEMORY_LIMIT = 256 * 1024 * 1024;
+
+class DatasetPrefetcher
+{
+public:
+    static DatasetPrefetcher* getInstance();
+
+    void setLimits(const uint64_t memoryLimit,
+                   const uint32_t numberOfThreads);
+    bool add(const std::string &key,
+             const std::function<Kitsunemimi::DataBuffer*(Kitsunemimi::ErrorContainer&)> &fetch,
+             Kitsunemimi::ErrorContainer &error);
+    bool take(Kitsunemimi::DataBuffer* &data,
+              const std::string &key);
+    void clear();
+
+private:
+    DatasetPrefetcher();
+
+    struct PrefetchEntry
+    {
+        std::function<Kitsunemimi::DataBuffer*(Kitsunemimi::ErrorContainer&)> fetch;
+        Kitsunemimi::DataBuffer* data = nullptr;
+        std::string errorMessage = "";
+        bool started = false;
+        bool finished = false;
+        bool cancelled = false;
+    };
+
+    std::mutex m_lock;
+    std::condition_variable m_workerCv;
+    std::condition_variable m_readyCv;
+    std::deque<std::shared_ptr<PrefetchEntry>> m_pending;
+    std::map<std::string, std::shared_ptr<PrefetchEntry>> m_entries;
+    uint64_t m_memoryLimit = DEFAULT_PREFETCH_MEMORY_LIMIT;
+    // size of all fetched buffers, which were not taken yet
+    uint64_t m_memoryUsage = 0;
+    uint32_t m_numberOfThreads = 0;
+    uint32_t m_targetNumberOfThreads = 2;
+
+    void startThreads();
+    void run();
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_DATASET_PREFETCHER_H
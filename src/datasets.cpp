@@ -21,6 +21,19 @@
  */
 
 #include <libShioriArchive/datasets.h>
+#include <libShioriArchive/column_cache.h>
+#include <libShioriArchive/metadata_cache.h>
+
+#include <buffer_pool.h>
+#include <client_pool.h>
+#include <dataset_prefetcher.h>
+#include <json_helper.h>
+#include <metrics_collector.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
 
 #include <libKitsunemimiCommon/buffer/data_buffer.h>
 #include <libKitsunemimiCrypto/common.h>
@@ -34,75 +47,605 @@
 #include <../../libKitsunemimiHanamiMessages/protobuffers/shiori_messages.proto3.pb.h>
 #include <../../libKitsunemimiHanamiMessages/message_sub_types.h>
 
-using Kitsunemimi::Hanami::HanamiMessaging;
-using Kitsunemimi::Hanami::HanamiMessagingClient;
 using Kitsunemimi::Hanami::SupportedComponents;
 
 namespace Shiori
 {
 
+// maximum number of columns, which are requested at the same time by a data-set handle
+const uint64_t MAX_PARALLEL_COLUMN_REQUESTS = 8;
+
 /**
- * @brief get data-set payload from shiori
+ * @brief get the file-location of a data-set within shiori
  *
+ * @param location reference for the resulting location
  * @param token token for request
- * @param uuid uuid of the data-set to download
+ * @param uuid uuid of the data-set
  * @param error reference for error-output
  *
- * @return data-buffer with data if successful, else nullptr
+ * @return true, if successful, else false
  */
-Kitsunemimi::DataBuffer*
-getDatasetData(const std::string &token,
-               const std::string &uuid,
-               const std::string &columnName,
-               Kitsunemimi::ErrorContainer &error)
+static bool
+getDatasetLocation(std::string &location,
+                   const std::string &token,
+                   const std::string &uuid,
+                   Kitsunemimi::ErrorContainer &error)
 {
-    Kitsunemimi::Hanami::ResponseMessage response;
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
+    // request information of the data-set from shiori
+    std::shared_ptr<const Kitsunemimi::JsonItem> parsedContent;
+    if(MetadataCache::getInstance()->request(parsedContent,
+                                             "v1/data_set",
+                                             uuid,
+                                             token,
+                                             error) == false)
+    {
+        return false;
+    }
 
-    // build request to get train-data from shiori
-    Kitsunemimi::Hanami::RequestMessage request;
-    request.id = "v1/data_set";
-    request.httpType = Kitsunemimi::Hanami::GET_TYPE;
-    request.inputValues = "{\"token\":\"" + token + "\""
-                          ",\"uuid\":\"" + uuid + "\""
-                          "}";
+    location = getJsonString(*parsedContent, "location");
+
+    return true;
+}
 
+/**
+ * @brief request the data of a single column of a data-set from shiori
+ *
+ * @param location file-location of the data-set within shiori
+ * @param columnName name of the requested column
+ * @param operation operation, which is measured by the metrics
+ * @param error reference for error-output
+ *
+ * @return data-buffer with data if successful, else nullptr
+ */
+static Kitsunemimi::DataBuffer*
+requestColumnData(const std::string &location,
+                  const std::string &columnName,
+                  const MetricOperation operation,
+                  Kitsunemimi::ErrorContainer &error)
+{
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
     if(client == nullptr) {
         return nullptr;
     }
 
-    // send request to shiori
-    if(client->triggerSakuraFile(response, request, error) == false) {
+    // create real request
+    DatasetRequest_Message msg;
+    msg.set_location(location);
+    msg.set_columnname(columnName);
+
+    PooledBuffer buffer;
+    uint64_t msgSize = 0;
+    const uint8_t* serialized = serializeMessage(buffer, msgSize, msg, error);
+    if(serialized == nullptr)
+    {
+        error.addMeesage("Failed to serialize dataset-request to shiori");
         return nullptr;
     }
 
-    // check response
-    if(response.success == false)
+    MetricsCollector* metrics = MetricsCollector::getInstance();
+    metrics->add(operation, BYTES_SENT_FIELD, msgSize);
+    Kitsunemimi::DataBuffer* data = client->sendGenericRequest(SHIORI_DATASET_REQUEST_MESSAGE_TYPE,
+                                                               serialized,
+                                                               msgSize,
+                                                               error);
+    if(data != nullptr) {
+        metrics->add(operation, BYTES_RECEIVED_FIELD, data->usedBufferSize);
+    }
+
+    return data;
+}
+
+/**
+ * @brief get the data of a single column of a data-set from the local column-cache or,
+ *        if not cached, from shiori
+ *
+ * @param location file-location of the data-set within shiori
+ * @param columnName name of the requested column
+ * @param operation operation, which is measured by the metrics
+ * @param error reference for error-output
+ *
+ * @return data-buffer with data if successful, else nullptr
+ */
+static Kitsunemimi::DataBuffer*
+getColumnData(const std::string &location,
+              const std::string &columnName,
+              const MetricOperation operation,
+              Kitsunemimi::ErrorContainer &error)
+{
+    ColumnCache* cache = ColumnCache::getInstance();
+
+    Kitsunemimi::DataBuffer* data = cache->get(location, columnName);
+    if(data != nullptr) {
+        return data;
+    }
+
+    data = requestColumnData(location, columnName, operation, error);
+    if(data != nullptr) {
+        cache->add(location, columnName, data);
+    }
+
+    return data;
+}
+
+/**
+ * @brief constructor
+ *
+ * @param token token for requests
+ * @param uuid uuid of the data-set
+ */
+DataSetHandle::DataSetHandle(const std::string &token,
+                             const std::string &uuid)
+{
+    m_token = token;
+    m_uuid = uuid;
+}
+
+/**
+ * @brief resolve the location of the data-set within shiori. This has to be done only once
+ *        for all columns, which are requested over this handle.
+ *
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+DataSetHandle::init(Kitsunemimi::ErrorContainer &error)
+{
+    return getDatasetLocation(m_location, m_token, m_uuid, error);
+}
+
+/**
+ * @brief get location of the data-set
+ *
+ * @return location of the data-set within shiori, or empty string if not initialized
+ */
+const std::string
+DataSetHandle::getLocation() const
+{
+    return m_location;
+}
+
+/**
+ * @brief get data of a single column of the data-set
+ *
+ * @param columnName name of the requested column
+ * @param error reference for error-output
+ *
+ * @return data-buffer with data if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+DataSetHandle::getColumn(const std::string &columnName,
+                         Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_DATASET_COLUMN_OPERATION);
+
+    if(m_location == ""
+            && init(error) == false)
     {
-        error.addMeesage(response.responseContent);
         return nullptr;
     }
 
-    // parse result
-    Kitsunemimi::JsonItem jsonItem;
-    if(jsonItem.parse(response.responseContent, error) == false) {
+    return metric.finish(getColumnData(m_location,
+                                       columnName,
+                                       GET_DATASET_COLUMN_OPERATION,
+                                       error));
+}
+
+/**
+ * @brief get data of multiple columns of the data-set. The requests are sent by multiple
+ *        threads at the same time and not one after another. The number of threads is limited
+ *        by MAX_PARALLEL_COLUMN_REQUESTS, so a data-set with many columns doesn't start one
+ *        thread and one request per column at once.
+ *
+ * @param result reference for the resulting buffers in the same order as the column-names
+ * @param columnNames names of the requested columns
+ * @param error reference for error-output
+ *
+ * @return true, if all columns were received, else false
+ */
+bool
+DataSetHandle::getColumns(std::vector<Kitsunemimi::DataBuffer*> &result,
+                          const std::vector<std::string> &columnNames,
+                          Kitsunemimi::ErrorContainer &error)
+{
+    result.clear();
+
+    if(m_location == ""
+            && init(error) == false)
+    {
+        return false;
+    }
+
+    // send requests with multiple workers, where each worker requests one column at a time
+    std::vector<Kitsunemimi::ErrorContainer> errors(columnNames.size());
+    std::vector<Kitsunemimi::DataBuffer*> columns(columnNames.size(), nullptr);
+    std::atomic<uint64_t> nextColumn = {0};
+    auto worker = [&]()
+    {
+        uint64_t pos = nextColumn.fetch_add(1);
+        while(pos < columnNames.size())
+        {
+            MetricScope metric(GET_DATASET_COLUMN_OPERATION);
+            columns[pos] = metric.finish(getColumnData(m_location,
+                                                       columnNames.at(pos),
+                                                       GET_DATASET_COLUMN_OPERATION,
+                                                       errors[pos]));
+            pos = nextColumn.fetch_add(1);
+        }
+    };
+
+    const uint64_t numberOfThreads = std::min(MAX_PARALLEL_COLUMN_REQUESTS,
+                                              static_cast<uint64_t>(columnNames.size()));
+    std::vector<std::thread> threads;
+    for(uint64_t i = 0; i < numberOfThreads; i++) {
+        threads.emplace_back(worker);
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // collect results
+    bool success = true;
+    for(uint64_t i = 0; i < columns.size(); i++)
+    {
+        Kitsunemimi::DataBuffer* data = columns[i];
+        if(data == nullptr)
+        {
+            error.addMeesage(errors[i].toString());
+            error.addMeesage("Failed to get column '" + columnNames.at(i) + "' of data-set '"
+                             + m_uuid + "'");
+            success = false;
+        }
+        result.push_back(data);
+    }
+
+    if(success == false)
+    {
+        for(Kitsunemimi::DataBuffer* data : result) {
+            delete data;
+        }
+        result.clear();
+    }
+
+    return success;
+}
+
+/**
+ * @brief check if a byte-range is within a column
+ *
+ * @param columnName name of the column
+ * @param offset byte-offset of the range within the column
+ * @param size number of bytes of the range
+ * @param columnSize size of the column in bytes
+ * @param error reference for error-output
+ *
+ * @return true, if the range is within the column, else false
+ */
+static bool
+checkColumnRange(const std::string &columnName,
+                 const uint64_t offset,
+                 const uint64_t size,
+                 const uint64_t columnSize,
+                 Kitsunemimi::ErrorContainer &error)
+{
+    if(offset > columnSize
+            || size > columnSize - offset)
+    {
+        error.addMeesage("Range with offset '"
+                         + std::to_string(offset)
+                         + "' and size '"
+                         + std::to_string(size)
+                         + "' is outside of column '"
+                         + columnName
+                         + "' with size '"
+                         + std::to_string(columnSize)
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get a byte-range of a column of a data-set. This is no ranged read from shiori,
+ *        because shiori can only send complete columns. Only a column in the local
+ *        column-cache is read partially. A not cached column is downloaded completely and
+ *        added to the cache, so the following ranges of the column are served locally.
+ *        Without a configured column-cache, which is the default, every call downloads the
+ *        complete column, so for multiple ranges of the same column a single call of
+ *        getDatasetData is cheaper in this case.
+ *
+ * @param token token for request
+ * @param uuid uuid of the data-set
+ * @param columnName name of the requested column
+ * @param offset byte-offset of the range within the column
+ * @param size number of bytes of the range
+ * @param error reference for error-output
+ *
+ * @return data-buffer with the range if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+getDatasetDataRange(const std::string &token,
+                    const std::string &uuid,
+                    const std::string &columnName,
+                    const uint64_t offset,
+                    const uint64_t size,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_DATASET_DATA_RANGE_OPERATION);
+
+    std::string location = "";
+    if(getDatasetLocation(location, token, uuid, error) == false) {
         return nullptr;
     }
 
-    // create real request
-    DatasetRequest_Message msg;
-    msg.set_location(jsonItem.get("location").getString());
-    msg.set_columnname(columnName);
+    // a cached column is also used to check the range, without a request to shiori
+    Kitsunemimi::DataBuffer* result = nullptr;
+    uint64_t columnSize = 0;
+    if(ColumnCache::getInstance()->getRange(result,
+                                            columnSize,
+                                            location,
+                                            columnName,
+                                            offset,
+                                            size))
+    {
+        if(checkColumnRange(columnName, offset, size, columnSize, error) == false) {
+            return nullptr;
+        }
+        return metric.finish(result);
+    }
 
-    uint8_t buffer[96*1024];
-    const uint64_t msgSize = msg.ByteSizeLong();
-    if(msg.SerializeToArray(buffer, msgSize) == false)
+    Kitsunemimi::DataBuffer* data = getColumnData(location,
+                                                  columnName,
+                                                  GET_DATASET_DATA_RANGE_OPERATION,
+                                                  error);
+    if(data == nullptr) {
+        return nullptr;
+    }
+
+    if(checkColumnRange(columnName, offset, size, data->usedBufferSize, error) == false)
+    {
+        delete data;
+        return nullptr;
+    }
+
+    const uint8_t* u8Data = static_cast<const uint8_t*>(data->data);
+    result = new Kitsunemimi::DataBuffer();
+    Kitsunemimi::addData_DataBuffer(*result, &u8Data[offset], size);
+    delete data;
+
+    return metric.finish(result);
+}
+
+/**
+ * @brief get a range of rows of a column of a data-set, where all rows have the same size.
+ *        Like getDatasetDataRange, this is no ranged read from shiori.
+ *
+ * @param token token for request
+ * @param uuid uuid of the data-set
+ * @param columnName name of the requested column
+ * @param rowSize size of a single row in bytes
+ * @param firstRow index of the first requested row
+ * @param numberOfRows number of requested rows
+ * @param error reference for error-output
+ *
+ * @return data-buffer with the rows if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+getDatasetRows(const std::string &token,
+               const std::string &uuid,
+               const std::string &columnName,
+               const uint64_t rowSize,
+               const uint64_t firstRow,
+               const uint64_t numberOfRows,
+               Kitsunemimi::ErrorContainer &error)
+{
+    if(rowSize == 0)
     {
-        error.addMeesage("Failed to serialize error-message to shiori");
+        error.addMeesage("Row-size for the rows of a data-set must be greater than 0");
         return nullptr;
     }
 
-    return client->sendGenericRequest(SHIORI_DATASET_REQUEST_MESSAGE_TYPE, buffer, msgSize, error);
+    const uint64_t maxRows = std::numeric_limits<uint64_t>::max() / rowSize;
+    if(firstRow > maxRows
+            || numberOfRows > maxRows
+            || firstRow + numberOfRows > maxRows)
+    {
+        error.addMeesage("Requested rows of column '" + columnName + "' are out of range");
+        return nullptr;
+    }
+
+    return getDatasetDataRange(token,
+                               uuid,
+                               columnName,
+                               firstRow * rowSize,
+                               numberOfRows * rowSize,
+                               error);
+}
+
+/**
+ * @brief get identifier of a prefetched column
+ *
+ * @param token token for request
+ * @param uuid uuid of the data-set
+ * @param columnName name of the column
+ *
+ * @return identifier of the column within the prefetcher
+ */
+static const std::string
+getPrefetchKey(const std::string &token,
+               const std::string &uuid,
+               const std::string &columnName)
+{
+    return token + "\n" + uuid + "\n" + columnName;
+}
+
+/**
+ * @brief get data of a single column of a data-set from the prefetcher, if prefetched, or
+ *        else from the column-cache or shiori
+ *
+ * @param token token for request
+ * @param uuid uuid of the data-set
+ * @param columnName name of the requested column
+ * @param operation operation, which is measured by the metrics
+ * @param error reference for error-output
+ *
+ * @return data-buffer with data if successful, else nullptr
+ */
+static Kitsunemimi::DataBuffer*
+getPrefetchedColumnData(const std::string &token,
+                        const std::string &uuid,
+                        const std::string &columnName,
+                        const MetricOperation operation,
+                        Kitsunemimi::ErrorContainer &error)
+{
+    Kitsunemimi::DataBuffer* data = nullptr;
+    const std::string key = getPrefetchKey(token, uuid, columnName);
+    if(DatasetPrefetcher::getInstance()->take(data, key)) {
+        return data;
+    }
+
+    std::string location = "";
+    if(getDatasetLocation(location, token, uuid, error) == false) {
+        return nullptr;
+    }
+
+    return getColumnData(location, columnName, operation, error);
+}
+
+/**
+ * @brief register a column of a data-set to be fetched in background. The columns are fetched
+ *        in the order of their registration, while the prefetched, but not yet requested,
+ *        columns are below the memory-limit. A later call of getDatasetData for the column
+ *        gets the prefetched data or waits for the running fetch, instead of sending a new
+ *        request.
+ *
+ * @param token token for request
+ * @param uuid uuid of the data-set to download
+ * @param columnName name of the requested column
+ * @param error reference for error-output
+ *
+ * @return false, if prefetching is disabled, else true
+ */
+bool
+prefetchDatasetData(const std::string &token,
+                    const std::string &uuid,
+                    const std::string &columnName,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    auto fetch = [token, uuid, columnName](Kitsunemimi::ErrorContainer &fetchError)
+    {
+        MetricScope metric(PREFETCH_DATASET_DATA_OPERATION);
+
+        std::string location = "";
+        if(getDatasetLocation(location, token, uuid, fetchError) == false) {
+            return static_cast<Kitsunemimi::DataBuffer*>(nullptr);
+        }
+
+        return metric.finish(getColumnData(location,
+                                           columnName,
+                                           PREFETCH_DATASET_DATA_OPERATION,
+                                           fetchError));
+    };
+
+    return DatasetPrefetcher::getInstance()->add(getPrefetchKey(token, uuid, columnName),
+                                                 fetch,
+                                                 error);
+}
+
+/**
+ * @brief set limits for the prefetching of data-set columns
+ *
+ * @param memoryLimit maximum size in bytes of all prefetched, but not yet requested, columns.
+ *                    A value of 0 disables the prefetching.
+ * @param numberOfThreads number of columns, which are fetched at the same time
+ */
+void
+setDatasetPrefetchLimits(const uint64_t memoryLimit,
+                         const uint32_t numberOfThreads)
+{
+    DatasetPrefetcher::getInstance()->setLimits(memoryLimit, numberOfThreads);
+}
+
+/**
+ * @brief remove all registered prefetches and delete all prefetched, but not yet requested,
+ *        columns
+ */
+void
+cancelDatasetPrefetch()
+{
+    DatasetPrefetcher::getInstance()->clear();
+}
+
+/**
+ * @brief get data-set payload from shiori
+ *
+ * @param token token for request
+ * @param uuid uuid of the data-set to download
+ * @param columnName name of the requested column
+ * @param error reference for error-output
+ *
+ * @return data-buffer with data if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+getDatasetData(const std::string &token,
+               const std::string &uuid,
+               const std::string &columnName,
+               Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_DATASET_DATA_OPERATION);
+
+    return metric.finish(getPrefetchedColumnData(token,
+                                                 uuid,
+                                                 columnName,
+                                                 GET_DATASET_DATA_OPERATION,
+                                                 error));
+}
+
+/**
+ * @brief get a column of a data-set as aligned float-values. The raw values are converted with
+ *        the vector-instructions of the cpu in the same pass, in which they are copied out of
+ *        the received data, so the caller doesn't need an own conversion-pass.
+ *
+ * @param result reference for the converted column, whose memory is reused if big enough
+ * @param token token for request
+ * @param uuid uuid of the data-set to download
+ * @param columnName name of the requested column
+ * @param conversion type of the raw values and the conversion to apply
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getDatasetColumnView(ColumnView &result,
+                     const std::string &token,
+                     const std::string &uuid,
+                     const std::string &columnName,
+                     const ColumnConversion &conversion,
+                     Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_DATASET_COLUMN_VIEW_OPERATION);
+
+    Kitsunemimi::DataBuffer* data = getPrefetchedColumnData(token,
+                                                            uuid,
+                                                            columnName,
+                                                            GET_DATASET_COLUMN_VIEW_OPERATION,
+                                                            error);
+    if(data == nullptr) {
+        return false;
+    }
+
+    const bool success = result.convert(data->data, data->usedBufferSize, conversion, error);
+    delete data;
+    if(success == false)
+    {
+        error.addMeesage("Failed to convert column '" + columnName + "' of data-set '"
+                         + uuid + "'");
+        return false;
+    }
+
+    return metric.finish(true);
 }
 
 /**
@@ -121,38 +664,62 @@ getDataSetInformation(Kitsunemimi::JsonItem &result,
                       const std::string &token,
                       Kitsunemimi::ErrorContainer &error)
 {
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
-    if(client == nullptr) {
+    MetricScope metric(GET_DATASET_INFORMATION_OPERATION);
+
+    // request information of the data-set from shiori
+    std::shared_ptr<const Kitsunemimi::JsonItem> parsedContent;
+    if(MetadataCache::getInstance()->request(parsedContent,
+                                             "v1/data_set",
+                                             dataSetUuid,
+                                             token,
+                                             error) == false)
+    {
         return false;
     }
 
-    Kitsunemimi::Hanami::ResponseMessage response;
+    result = *parsedContent;
 
-    // create request for remote-calls
-    Kitsunemimi::Hanami::RequestMessage request;
-    request.id = "v1/data_set";
-    request.httpType = Kitsunemimi::Hanami::GET_TYPE;
-    request.inputValues = "{\"uuid\" : \"" + dataSetUuid + "\","
-                          "\"token\":\"" + token + "\"}";
+    return metric.finish(true);
+}
 
-    // send request to the target
-    if(client->triggerSakuraFile(response, request, error) == false) {
-        return false;
-    }
+/**
+ * @brief get information of a specific data-set from shiori as typed struct
+ *
+ * @param result reference for result-output
+ * @param dataSetUuid uuid of the requested data-set
+ * @param token for authetification against shiori
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getDataSetInformation(DataSetInformation &result,
+                      const std::string &dataSetUuid,
+                      const std::string &token,
+                      Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_DATASET_INFORMATION_OPERATION);
 
-    // check response
-    if(response.success == false)
+    // request information of the data-set from shiori
+    std::shared_ptr<const Kitsunemimi::JsonItem> parsedContent;
+    if(MetadataCache::getInstance()->request(parsedContent,
+                                             "v1/data_set",
+                                             dataSetUuid,
+                                             token,
+                                             error) == false)
     {
-        error.addMeesage(response.responseContent);
         return false;
     }
 
-    // parse result
-    if(result.parse(response.responseContent, error) == false) {
-        return false;
-    }
+    result.uuid = getJsonString(*parsedContent, "uuid");
+    result.name = getJsonString(*parsedContent, "name");
+    result.type = getJsonString(*parsedContent, "type");
+    result.location = getJsonString(*parsedContent, "location");
+    result.projectId = getJsonString(*parsedContent, "project_id");
+    result.ownerId = getJsonString(*parsedContent, "owner_id");
+    result.visibility = getJsonString(*parsedContent, "visibility");
 
-    return true;
+    return metric.finish(true);
 }
 
 }
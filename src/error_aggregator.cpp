@@ -0,0 +1,356 @@
+/**
+ * @file        error_aggregator.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <error_aggregator.h>
+
+#include <algorithm>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ */
+ErrorAggregator::ErrorAggregator()
+{
+    m_lastRefill = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief get instance of the aggregator
+ *
+ * @return pointer to the static instance
+ */
+ErrorAggregator*
+ErrorAggregator::getInstance()
+{
+    static ErrorAggregator* instance = new ErrorAggregator();
+    return instance;
+}
+
+/**
+ * @brief set limits for error-messages. A value of 0 disables the corresponding limit. With a
+ *        time-window, a background-thread sends the counted messages at the end of their
+ *        time-window. Without time-window, the thread is stopped and all counted messages
+ *        are sent.
+ *
+ * @param windowMs time-window in milliseconds, in which identical messages of the same user
+ *                 are combined into one counted message
+ * @param maxMessagesPerSecond maximum number of messages per second, which are sent to shiori
+ * @param send function, which is called by the background-thread to send messages
+ */
+void
+ErrorAggregator::setLimits(const uint64_t windowMs,
+                           const uint32_t maxMessagesPerSecond,
+                           const SendFunction &send)
+{
+    std::thread oldThread;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        m_window = std::chrono::milliseconds(windowMs);
+        m_maxMessagesPerSecond = maxMessagesPerSecond;
+        m_tokens = maxMessagesPerSecond;
+        m_lastRefill = std::chrono::steady_clock::now();
+        m_send = send;
+
+        if(m_window.count() > 0
+                && m_active == false)
+        {
+            m_active = true;
+            m_thread = std::thread(&ErrorAggregator::run, this);
+        }
+        else if(m_window.count() == 0
+                && m_active)
+        {
+            m_active = false;
+            oldThread = std::move(m_thread);
+        }
+        m_cv.notify_one();
+    }
+
+    if(oldThread.joinable() == false) {
+        return;
+    }
+
+    // send the messages, which were counted with the old time-window
+    oldThread.join();
+    std::vector<ErrorRecord> readyToSend;
+    flush(readyToSend);
+    if(readyToSend.size() > 0
+            && send != nullptr)
+    {
+        send(readyToSend);
+    }
+}
+
+/**
+ * @brief add new error-message
+ *
+ * @param readyToSend reference for all messages, which have to be sent now
+ * @param userId id of the user where the error belongs to
+ * @param errorMessage error-message
+ */
+void
+ErrorAggregator::add(std::vector<ErrorRecord> &readyToSend,
+                     const std::string &userId,
+                     const std::string &errorMessage)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // count identical messages within the time-window
+    const AggregateKey key(userId, errorMessage);
+    if(m_window.count() > 0)
+    {
+        auto it = m_aggregates.find(key);
+        if(it != m_aggregates.end())
+        {
+            it->second.numberOfSuppressed++;
+            return;
+        }
+    }
+
+    // without time-window or with too many different messages, each message is handled on its
+    // own and dropped, if above the rate-limit
+    if(m_window.count() == 0
+            || m_aggregates.size() >= MAX_NUMBER_OF_AGGREGATES)
+    {
+        if(takeToken(now)) {
+            readyToSend.push_back({userId, errorMessage});
+        }
+        else {
+            m_numberOfDropped++;
+        }
+        return;
+    }
+
+    // first message within the time-window is sent directly
+    Aggregate aggregate;
+    aggregate.windowStart = now;
+    if(takeToken(now))
+    {
+        readyToSend.push_back({userId, errorMessage});
+        aggregate.firstSent = true;
+    }
+    else
+    {
+        aggregate.numberOfSuppressed = 1;
+    }
+    m_expiryOrder.push_back(m_aggregates.emplace(key, aggregate).first);
+}
+
+/**
+ * @brief get all counted messages, independent of their time-window. Messages above the
+ *        rate-limit are dropped and counted as dropped, so no aggregate is left afterwards.
+ *
+ * @param readyToSend reference for all messages, which have to be sent now
+ */
+void
+ErrorAggregator::flush(std::vector<ErrorRecord> &readyToSend)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    collectExpired(readyToSend, std::chrono::steady_clock::now(), true);
+}
+
+/**
+ * @brief get number of different messages, which are counted at the moment
+ *
+ * @return number of aggregates
+ */
+uint64_t
+ErrorAggregator::getNumberOfAggregates()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_aggregates.size();
+}
+
+/**
+ * @brief get number of messages, which were dropped because of the rate-limit, either without
+ *        being counted within an aggregate or by a flush of the aggregates
+ *
+ * @return number of dropped messages
+ */
+uint64_t
+ErrorAggregator::getNumberOfDropped()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_numberOfDropped;
+}
+
+/**
+ * @brief take a token of the rate-limit. Must be called while holding the lock.
+ *
+ * @param now current time
+ *
+ * @return true, if a message can be sent, else false
+ */
+bool
+ErrorAggregator::takeToken(const std::chrono::steady_clock::time_point now)
+{
+    if(m_maxMessagesPerSecond == 0) {
+        return true;
+    }
+
+    // refill tokens, based on the time since the last refill
+    const std::chrono::duration<double> elapsed = now - m_lastRefill;
+    m_lastRefill = now;
+    m_tokens = std::min(static_cast<double>(m_maxMessagesPerSecond),
+                        m_tokens + elapsed.count() * m_maxMessagesPerSecond);
+
+    if(m_tokens < 1.0) {
+        return false;
+    }
+
+    m_tokens -= 1.0;
+
+    return true;
+}
+
+/**
+ * @brief convert all aggregates with expired time-window into counted messages. The aggregates
+ *        are checked in the order of their time-window, so only the expired ones are visited.
+ *        Must be called while holding the lock.
+ *
+ * @param readyToSend reference for all messages, which have to be sent now
+ * @param now current time
+ * @param force true to handle all aggregates as expired and to drop the ones above the
+ *              rate-limit instead of keeping them
+ */
+void
+ErrorAggregator::collectExpired(std::vector<ErrorRecord> &readyToSend,
+                                const std::chrono::steady_clock::time_point now,
+                                const bool force)
+{
+    while(m_expiryOrder.size() > 0)
+    {
+        auto it = m_expiryOrder.front();
+        if(force == false
+                && now - it->second.windowStart < m_window)
+        {
+            return;
+        }
+
+        const Aggregate* aggregate = &it->second;
+        if(aggregate->numberOfSuppressed > 0
+                && takeToken(now) == false)
+        {
+            // without token, this and all following aggregates are kept until the next try,
+            // except when forced, where the suppressed messages are dropped
+            if(force == false) {
+                return;
+            }
+            m_numberOfDropped += aggregate->numberOfSuppressed;
+        }
+        else if(aggregate->numberOfSuppressed > 0)
+        {
+            std::string message = it->first.second;
+            if(aggregate->firstSent)
+            {
+                message += " (repeated "
+                           + std::to_string(aggregate->numberOfSuppressed)
+                           + " times)";
+            }
+            else if(aggregate->numberOfSuppressed > 1)
+            {
+                message += " (occurred "
+                           + std::to_string(aggregate->numberOfSuppressed)
+                           + " times)";
+            }
+            readyToSend.push_back({it->first.first, message});
+        }
+
+        m_aggregates.erase(it);
+        m_expiryOrder.pop_front();
+    }
+}
+
+/**
+ * @brief get time, when the background-thread has to check the aggregates the next time. Must
+ *        be called while holding the lock.
+ *
+ * @param now current time
+ *
+ * @return time of the next check
+ */
+std::chrono::steady_clock::time_point
+ErrorAggregator::getNextWakeUp(const std::chrono::steady_clock::time_point now)
+{
+    if(m_expiryOrder.size() == 0) {
+        return now + m_window;
+    }
+
+    const std::chrono::steady_clock::time_point expiry = m_expiryOrder.front()->second.windowStart
+                                                         + m_window;
+    if(expiry > now) {
+        return expiry;
+    }
+
+    // the oldest aggregate is already expired and waits for a new token
+    const uint32_t maxMessagesPerSecond = std::max(m_maxMessagesPerSecond, 1u);
+    return now + std::chrono::microseconds(1000000 / maxMessagesPerSecond);
+}
+
+/**
+ * @brief loop of the background-thread, which sends the counted messages at the end of their
+ *        time-window
+ */
+void
+ErrorAggregator::run()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    uint64_t reportedDropped = m_numberOfDropped;
+
+    while(m_active)
+    {
+        m_cv.wait_until(lock, getNextWakeUp(std::chrono::steady_clock::now()));
+        if(m_active == false) {
+            break;
+        }
+
+        std::vector<ErrorRecord> readyToSend;
+        collectExpired(readyToSend, std::chrono::steady_clock::now(), false);
+        const uint64_t numberOfDropped = m_numberOfDropped - reportedDropped;
+        reportedDropped = m_numberOfDropped;
+        const SendFunction send = m_send;
+
+        // send without lock, so new messages can be added in the meantime
+        lock.unlock();
+        if(numberOfDropped > 0)
+        {
+            LOG_WARNING("Dropped " + std::to_string(numberOfDropped)
+                        + " error-messages, because of the rate-limit");
+        }
+        if(readyToSend.size() > 0
+                && send != nullptr)
+        {
+            send(readyToSend);
+        }
+        lock.lock();
+    }
+}
+
+}
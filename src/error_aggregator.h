@@ -0,0 +1,105 @@
+/**
+ * @file        error_aggregator.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_ERROR_AGGREGATOR_H
+#define KITSUNEMIMI_HANAMI_SHIORI_ERROR_AGGREGATOR_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+namespace Shiori
+{
+
+// upper limit of different messages within their time-window, to keep the memory bounded
+const uint64_t MAX_NUMBER_OF_AGGREGATES = 10000;
+
+struct ErrorRecord
+{
+    std::string userId = "";
+    std::string errorMessage = "";
+};
+
+class ErrorAggregator
+{
+public:
+    static ErrorAggregator* getInstance();
+
+    typedef std::function<void(const std::vector<ErrorRecord>&)> SendFunction;
+
+    void setLimits(const uint64_t windowMs,
+                   const uint32_t maxMessagesPerSecond,
+                   const SendFunction &send);
+    void add(std::vector<ErrorRecord> &readyToSend,
+             const std::string &userId,
+             const std::string &errorMessage);
+    void flush(std::vector<ErrorRecord> &readyToSend);
+
+    uint64_t getNumberOfAggregates();
+    uint64_t getNumberOfDropped();
+
+private:
+    ErrorAggregator();
+
+    typedef std::pair<std::string, std::string> AggregateKey;
+
+    struct Aggregate
+    {
+        std::chrono::steady_clock::time_point windowStart;
+        // false, if the first message of the time-window didn't get a token
+        bool firstSent = false;
+        uint64_t numberOfSuppressed = 0;
+    };
+
+    std::mutex m_lock;
+    std::chrono::milliseconds m_window = std::chrono::milliseconds(0);
+    uint32_t m_maxMessagesPerSecond = 0;
+    double m_tokens = 0.0;
+    std::chrono::steady_clock::time_point m_lastRefill;
+    std::map<AggregateKey, Aggregate> m_aggregates;
+    // aggregates in the order of their time-window, so the expired ones are at the front
+    std::deque<std::map<AggregateKey, Aggregate>::iterator> m_expiryOrder;
+    uint64_t m_numberOfDropped = 0;
+
+    bool m_active = false;
+    std::thread m_thread;
+    std::condition_variable m_cv;
+    SendFunction m_send;
+
+    bool takeToken(const std::chrono::steady_clock::time_point now);
+    void collectExpired(std::vector<ErrorRecord> &readyToSend,
+                        const std::chrono::steady_clock::time_point now,
+                        const bool force);
+    std::chrono::steady_clock::time_point getNextWakeUp(
+            const std::chrono::steady_clock::time_point now);
+    void run();
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_ERROR_AGGREGATOR_H
@@ -0,0 +1,140 @@
+/**
+ * @file        hanami_connection.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+
+#include <hanami_connection.h>
+
+#include <libKitsunemimiHanamiNetwork/hanami_messaging.h>
+#include <libKitsunemimiHanamiNetwork/hanami_messaging_client.h>
+
+using Kitsunemimi::Hanami::HanamiMessaging;
+using Kitsunemimi::Hanami::HanamiMessagingClient;
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ *
+ * @param client client of the hanami-messaging, or nullptr to use always the current
+ *               shiori-client of the hanami-messaging
+ */
+HanamiConnection::HanamiConnection(HanamiMessagingClient* client)
+{
+    m_client = client;
+}
+
+/**
+ * @brief destructor
+ */
+HanamiConnection::~HanamiConnection() {}
+
+/**
+ * @brief get the client, which is used by the connection
+ *
+ * @return client of the hanami-messaging, or nullptr if there is no client to shiori
+ */
+HanamiMessagingClient*
+HanamiConnection::getClient() const
+{
+    if(m_client != nullptr) {
+        return m_client;
+    }
+
+    return HanamiMessaging::getInstance()->shioriClient;
+}
+
+/**
+ * @brief trigger a sakura-file in shiori
+ *
+ * @param response reference for the response
+ * @param request request to send
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+HanamiConnection::triggerSakuraFile(Kitsunemimi::Hanami::ResponseMessage &response,
+                                    const Kitsunemimi::Hanami::RequestMessage &request,
+                                    Kitsunemimi::ErrorContainer &error)
+{
+    return getClient()->triggerSakuraFile(response, request, error);
+}
+
+/**
+ * @brief send a stream-message to shiori
+ *
+ * @param data pointer to the data to send
+ * @param dataSize number of bytes to send
+ * @param replyExpected true to let shiori send a reply
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+HanamiConnection::sendStreamMessage(const void* data,
+                                    const uint64_t dataSize,
+                                    const bool replyExpected,
+                                    Kitsunemimi::ErrorContainer &error)
+{
+    return getClient()->sendStreamMessage(data, dataSize, replyExpected, error);
+}
+
+/**
+ * @brief send a generic message to shiori without response
+ *
+ * @param subType type of the message
+ * @param data pointer to the data to send
+ * @param dataSize number of bytes to send
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+HanamiConnection::sendGenericMessage(const uint32_t subType,
+                                     const void* data,
+                                     const uint64_t dataSize,
+                                     Kitsunemimi::ErrorContainer &error)
+{
+    return getClient()->sendGenericMessage(subType, data, dataSize, error);
+}
+
+/**
+ * @brief send a generic request to shiori and wait for the response
+ *
+ * @param subType type of the message
+ * @param data pointer to the data to send
+ * @param dataSize number of bytes to send
+ * @param error reference for error-output
+ *
+ * @return buffer with the response, if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+HanamiConnection::sendGenericRequest(const uint32_t subType,
+                                     const void* data,
+                                     const uint64_t dataSize,
+                                     Kitsunemimi::ErrorContainer &error)
+{
+    return getClient()->sendGenericRequest(subType, data, dataSize, error);
+}
+
+}
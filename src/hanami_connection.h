@@ -0,0 +1,70 @@
+/**
+ * @file        hanami_connection.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_HANAMI_CONNECTION_H
+#define KITSUNEMIMI_HANAMI_SHIORI_HANAMI_CONNECTION_H
+
+#include <libShioriArchive/shiori_connection.h>
+
+namespace Kitsunemimi {
+namespace Hanami {
+class HanamiMessagingClient;
+}
+}
+
+namespace Shiori
+{
+
+class HanamiConnection
+        : public ShioriConnection
+{
+public:
+    HanamiConnection(Kitsunemimi::Hanami::HanamiMessagingClient* client);
+    ~HanamiConnection();
+
+    Kitsunemimi::Hanami::HanamiMessagingClient* getClient() const;
+
+    bool triggerSakuraFile(Kitsunemimi::Hanami::ResponseMessage &response,
+                           const Kitsunemimi::Hanami::RequestMessage &request,
+                           Kitsunemimi::ErrorContainer &error);
+    bool sendStreamMessage(const void* data,
+                           const uint64_t dataSize,
+                           const bool replyExpected,
+                           Kitsunemimi::ErrorContainer &error);
+    bool sendGenericMessage(const uint32_t subType,
+                            const void* data,
+                            const uint64_t dataSize,
+                            Kitsunemimi::ErrorContainer &error);
+    Kitsunemimi::DataBuffer* sendGenericRequest(const uint32_t subType,
+                                                const void* data,
+                                                const uint64_t dataSize,
+                                                Kitsunemimi::ErrorContainer &error);
+
+private:
+    // nullptr to use the current shiori-client of the hanami-messaging
+    Kitsunemimi::Hanami::HanamiMessagingClient* m_client = nullptr;
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_HANAMI_CONNECTION_H
@@ -0,0 +1,135 @@
+/**
+ * @file        json_helper.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <json_helper.h>
+
+#include <libKitsunemimiJson/json_item.h>
+
+namespace Shiori
+{
+
+/**
+ * @brief get the string-value of a field of a json-object
+ *
+ * @param item json-object
+ * @param key key of the field
+ *
+ * @return value of the field, or empty string if the field doesn't exist
+ */
+const std::string
+getJsonString(const Kitsunemimi::JsonItem &item,
+              const std::string &key)
+{
+    if(item.contains(key) == false) {
+        return "";
+    }
+
+    return item.get(key).getString();
+}
+
+/**
+ * @brief append a string as quoted and escaped json-value
+ *
+ * @param output string where the value should be appended
+ * @param value value to write
+ */
+void
+appendJsonString(std::string &output,
+                 const std::string &value)
+{
+    const char hex[] = "0123456789abcdef";
+
+    output.push_back('"');
+    for(const char c : value)
+    {
+        switch(c)
+        {
+            case '"':  output.append("\\\""); break;
+            case '\\': output.append("\\\\"); break;
+            case '\n': output.append("\\n");  break;
+            case '\r': output.append("\\r");  break;
+            case '\t': output.append("\\t");  break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20)
+                {
+                    output.append("\\u00");
+                    output.push_back(hex[(c >> 4) & 0xF]);
+                    output.push_back(hex[c & 0xF]);
+                }
+                else
+                {
+                    output.push_back(c);
+                }
+        }
+    }
+    output.push_back('"');
+}
+
+/**
+ * @brief append a key-value-pair with a string-value to a json-object. A separator is added,
+ *        if the object already contains other fields.
+ *
+ * @param output json-object, which is not closed yet
+ * @param key key of the field
+ * @param value value of the field
+ */
+void
+appendJsonField(std::string &output,
+                const std::string &key,
+                const std::string &value)
+{
+    if(output.size() > 0
+            && output.back() != '{')
+    {
+        output.push_back(',');
+    }
+
+    appendJsonString(output, key);
+    output.push_back(':');
+    appendJsonString(output, value);
+}
+
+/**
+ * @brief append a key-value-pair with a numeric value to a json-object. A separator is added,
+ *        if the object already contains other fields.
+ *
+ * @param output json-object, which is not closed yet
+ * @param key key of the field
+ * @param value value of the field
+ */
+void
+appendJsonField(std::string &output,
+                const std::string &key,
+                const uint64_t value)
+{
+    if(output.size() > 0
+            && output.back() != '{')
+    {
+        output.push_back(',');
+    }
+
+    appendJsonString(output, key);
+    output.push_back(':');
+    output.append(std::to_string(value));
+}
+
+}
@@ -0,0 +1,49 @@
+/**
+ * @file        json_helper.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_JSON_HELPER_H
+#define KITSUNEMIMI_HANAMI_SHIORI_JSON_HELPER_H
+
+#include <string>
+
+namespace Kitsunemimi {
+class JsonItem;
+}
+
+namespace Shiori
+{
+
+const std::string getJsonString(const Kitsunemimi::JsonItem &item,
+                                const std::string &key);
+
+void appendJsonString(std::string &output,
+                      const std::string &value);
+void appendJsonField(std::string &output,
+                     const std::string &key,
+                     const std::string &value);
+void appendJsonField(std::string &output,
+                     const std::string &key,
+                     const uint64_t value);
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_JSON_HELPER_H
@@ -0,0 +1,312 @@
+/**
+ * @file        metadata_cache.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <libShioriArchive/metadata_cache.h>
+
+#include <client_pool.h>
+#include <json_helper.h>
+
+#include <libKitsunemimiJson/json_item.h>
+
+#include <libKitsunemimiHanamiCommon/structs.h>
+#include <libKitsunemimiHanamiNetwork/hanami_messaging.h>
+#include <libKitsunemimiHanamiNetwork/hanami_messaging_client.h>
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ */
+MetadataCache::MetadataCache() {}
+
+/**
+ * @brief get instance of the cache
+ *
+ * @return pointer to the static instance
+ */
+MetadataCache*
+MetadataCache::getInstance()
+{
+    static MetadataCache* instance = new MetadataCache();
+    return instance;
+}
+
+/**
+ * @brief set time how long a successful response is kept. With a time of 0 nothing is kept,
+ *        but concurrent requests for the same object are still combined into one request.
+ *
+ * @param timeToLiveMs new time-to-live in milliseconds
+ */
+void
+MetadataCache::setTimeToLive(const uint64_t timeToLiveMs)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_timeToLive = std::chrono::milliseconds(timeToLiveMs);
+}
+
+/**
+ * @brief request information of an object from shiori. If there is already a request for the
+ *        same object in flight, the result of this request is used instead of sending a new one.
+ *
+ * @param responseContent reference for the output of the response of shiori
+ * @param endpoint endpoint within shiori, which provides the information
+ * @param uuid uuid of the requested object
+ * @param token access-token for shiori
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+MetadataCache::request(std::string &responseContent,
+                       const std::string &endpoint,
+                       const std::string &uuid,
+                       const std::string &token,
+                       Kitsunemimi::ErrorContainer &error)
+{
+    std::shared_future<FetchResult> result = getResult(endpoint, uuid, token);
+    const FetchResult &fetchResult = result.get();
+    if(fetchResult.success == false)
+    {
+        error.addMeesage(fetchResult.content);
+        return false;
+    }
+
+    responseContent = fetchResult.content;
+
+    return true;
+}
+
+/**
+ * @brief request information of an object from shiori as already parsed json. The response
+ *        is parsed only once, when it is received from shiori, and shared by all requesters.
+ *
+ * @param parsedContent reference for the output of the parsed response of shiori
+ * @param endpoint endpoint within shiori, which provides the information
+ * @param uuid uuid of the requested object
+ * @param token access-token for shiori
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+MetadataCache::request(std::shared_ptr<const Kitsunemimi::JsonItem> &parsedContent,
+                       const std::string &endpoint,
+                       const std::string &uuid,
+                       const std::string &token,
+                       Kitsunemimi::ErrorContainer &error)
+{
+    std::shared_future<FetchResult> result = getResult(endpoint, uuid, token);
+    const FetchResult &fetchResult = result.get();
+    if(fetchResult.success == false)
+    {
+        error.addMeesage(fetchResult.content);
+        return false;
+    }
+    if(fetchResult.parsed == nullptr)
+    {
+        error.addMeesage("Failed to parse response of shiori for '" + endpoint + "'");
+        return false;
+    }
+
+    parsedContent = fetchResult.parsed;
+
+    return true;
+}
+
+/**
+ * @brief get result of a request from the cache or send a new request, if not cached and
+ *        not already in flight
+ *
+ * @param endpoint endpoint within shiori, which provides the information
+ * @param uuid uuid of the requested object
+ * @param token access-token for shiori
+ *
+ * @return future with the result of the request
+ */
+std::shared_future<MetadataCache::FetchResult>
+MetadataCache::getResult(const std::string &endpoint,
+                         const std::string &uuid,
+                         const std::string &token)
+{
+    // the token is part of the key, because the access-rights depend on it
+    const std::string key = endpoint + "\n" + uuid + "\n" + token;
+    std::shared_future<FetchResult> result;
+    std::promise<FetchResult> promise;
+    bool isOwner = false;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        auto it = m_entries.find(key);
+        if(it != m_entries.end()
+                && it->second.completed
+                && it->second.validUntil <= std::chrono::steady_clock::now())
+        {
+            m_entries.erase(it);
+            it = m_entries.end();
+        }
+
+        if(it == m_entries.end())
+        {
+            removeExpiredEntries();
+
+            Entry entry;
+            entry.result = promise.get_future().share();
+            m_entries[key] = entry;
+            isOwner = true;
+        }
+        result = m_entries[key].result;
+    }
+
+    // only the first requester sends the request, all others wait for its result
+    if(isOwner)
+    {
+        promise.set_value(fetch(endpoint, uuid, token));
+
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        // responses, which could not be parsed, are not kept, so the next request retries it
+        auto it = m_entries.find(key);
+        if(result.get().success == false
+                || result.get().parsed == nullptr
+                || m_timeToLive.count() == 0)
+        {
+            m_entries.erase(it);
+        }
+        else
+        {
+            it->second.completed = true;
+            it->second.validUntil = std::chrono::steady_clock::now() + m_timeToLive;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief remove all entries, which are not in flight
+ */
+void
+MetadataCache::clear()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    auto it = m_entries.begin();
+    while(it != m_entries.end())
+    {
+        if(it->second.completed) {
+            it = m_entries.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+}
+
+/**
+ * @brief send request to shiori
+ *
+ * @param endpoint endpoint within shiori, which provides the information
+ * @param uuid uuid of the requested object
+ * @param token access-token for shiori
+ *
+ * @return result with the response-content or the error-message
+ */
+MetadataCache::FetchResult
+MetadataCache::fetch(const std::string &endpoint,
+                     const std::string &uuid,
+                     const std::string &token)
+{
+    FetchResult result;
+    Kitsunemimi::ErrorContainer error;
+
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
+    if(client == nullptr)
+    {
+        result.content = "Failed to get client to shiori";
+        return result;
+    }
+
+    Kitsunemimi::Hanami::ResponseMessage response;
+
+    // create request for remote-calls
+    Kitsunemimi::Hanami::RequestMessage request;
+    request.id = endpoint;
+    request.httpType = Kitsunemimi::Hanami::GET_TYPE;
+    request.inputValues.reserve(32 + uuid.size() + token.size());
+    request.inputValues.push_back('{');
+    appendJsonField(request.inputValues, "uuid", uuid);
+    appendJsonField(request.inputValues, "token", token);
+    request.inputValues.push_back('}');
+
+    // send request to the target
+    if(client->triggerSakuraFile(response, request, error) == false)
+    {
+        result.content = error.toString();
+        return result;
+    }
+
+    // check response
+    if(response.success == false)
+    {
+        result.content = response.responseContent;
+        return result;
+    }
+
+    result.success = true;
+    result.content = response.responseContent;
+
+    // parse response only once for all requesters of this result
+    std::shared_ptr<Kitsunemimi::JsonItem> parsed = std::make_shared<Kitsunemimi::JsonItem>();
+    if(parsed->parse(result.content, error)) {
+        result.parsed = parsed;
+    }
+
+    return result;
+}
+
+/**
+ * @brief remove all completed entries, which are expired
+ */
+void
+MetadataCache::removeExpiredEntries()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    auto it = m_entries.begin();
+    while(it != m_entries.end())
+    {
+        if(it->second.completed
+                && it->second.validUntil <= now)
+        {
+            it = m_entries.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+}
@@ -0,0 +1,189 @@
+/**
+ * @file        metrics.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <libShioriArchive/metrics.h>
+
+#include <metrics_collector.h>
+
+namespace Shiori
+{
+
+/**
+ * @brief add the lines of a counter for all operations in prometheus text-format
+ *
+ * @param output reference for the resulting text
+ * @param metrics collected metrics
+ * @param name name of the counter
+ * @param help description of the counter
+ * @param field pointer to the field of the metrics, which is exported
+ */
+static void
+addPrometheusCounter(std::string &output,
+                     const std::vector<OperationMetrics> &metrics,
+                     const std::string &name,
+                     const std::string &help,
+                     uint64_t OperationMetrics::*field)
+{
+    output += "# HELP " + name + " " + help + "\n";
+    output += "# TYPE " + name + " counter\n";
+
+    for(uint32_t op = 0; op < metrics.size(); op++)
+    {
+        const std::string operationName = getMetricOperationName(static_cast<MetricOperation>(op));
+        output += name + "{operation=\"" + operationName + "\"} "
+                  + std::to_string(metrics[op].*field) + "\n";
+    }
+}
+
+/**
+ * @brief get name of an operation, like it is used in the exported metrics
+ *
+ * @param operation operation
+ *
+ * @return name of the operation
+ */
+const std::string
+getMetricOperationName(const MetricOperation operation)
+{
+    switch(operation)
+    {
+        case GET_DATASET_DATA_OPERATION:         return "get_dataset_data";
+        case GET_DATASET_COLUMN_OPERATION:       return "get_dataset_column";
+        case GET_DATASET_INFORMATION_OPERATION:  return "get_dataset_information";
+        case GET_SNAPSHOT_DATA_OPERATION:        return "get_snapshot_data";
+        case GET_SNAPSHOT_MANIFEST_OPERATION:    return "get_snapshot_manifest";
+        case GET_SNAPSHOT_INFORMATION_OPERATION: return "get_snapshot_information";
+        case SNAPSHOT_INIT_OPERATION:            return "snapshot_init";
+        case SEND_DATA_OPERATION:                return "send_data";
+        case SEND_DATA_PIPELINED_OPERATION:      return "send_data_pipelined";
+        case RETRY_SEND_DATA_OPERATION:          return "retry_send_data";
+        case SNAPSHOT_FINALIZE_OPERATION:        return "snapshot_finalize";
+        case SEND_RESULTS_OPERATION:             return "send_results";
+        case SEND_ERROR_MESSAGE_OPERATION:       return "send_error_message";
+        case FLUSH_ERROR_MESSAGES_OPERATION:     return "flush_error_messages";
+        case SEND_AUDIT_MESSAGE_OPERATION:       return "send_audit_message";
+        case PREFETCH_DATASET_DATA_OPERATION:    return "prefetch_dataset_data";
+        case GET_DATASET_DATA_RANGE_OPERATION:   return "get_dataset_data_range";
+        case GET_DATASET_COLUMN_VIEW_OPERATION:  return "get_dataset_column_view";
+        case NUMBER_OF_METRIC_OPERATIONS:        break;
+    }
+
+    return "unknown";
+}
+
+/**
+ * @brief get the current metrics of all operations
+ *
+ * @param metrics reference for the resulting metrics, where the index is the operation
+ */
+void
+getMetrics(std::vector<OperationMetrics> &metrics)
+{
+    MetricsCollector::getInstance()->collect(metrics);
+}
+
+/**
+ * @brief get the current metrics of all operations in the text-format of prometheus
+ *
+ * @return metrics as text
+ */
+const std::string
+getMetricsAsPrometheus()
+{
+    std::vector<OperationMetrics> metrics;
+    MetricsCollector::getInstance()->collect(metrics);
+
+    std::string output = "";
+    addPrometheusCounter(output, metrics,
+                         "shiori_archive_operation_calls_total",
+                         "Number of calls of an operation",
+                         &OperationMetrics::numberOfCalls);
+    addPrometheusCounter(output, metrics,
+                         "shiori_archive_operation_failures_total",
+                         "Number of failed calls of an operation",
+                         &OperationMetrics::numberOfFailures);
+    addPrometheusCounter(output, metrics,
+                         "shiori_archive_operation_retries_total",
+                         "Number of retries within an operation",
+                         &OperationMetrics::numberOfRetries);
+    addPrometheusCounter(output, metrics,
+                         "shiori_archive_operation_sent_bytes_total",
+                         "Number of bytes sent to shiori",
+                         &OperationMetrics::bytesSent);
+    addPrometheusCounter(output, metrics,
+                         "shiori_archive_operation_received_bytes_total",
+                         "Number of bytes received from shiori",
+                         &OperationMetrics::bytesReceived);
+    addPrometheusCounter(output, metrics,
+                         "shiori_archive_operation_segments_total",
+                         "Number of segments sent to shiori",
+                         &OperationMetrics::numberOfSegments);
+
+    // latency-histogram with cumulative buckets
+    const std::string name = "shiori_archive_operation_latency_seconds";
+    output += "# HELP " + name + " Latency of the calls of an operation\n";
+    output += "# TYPE " + name + " histogram\n";
+    for(uint32_t op = 0; op < metrics.size(); op++)
+    {
+        const OperationMetrics* opMetrics = &metrics[op];
+        const std::string label = "operation=\""
+                                  + getMetricOperationName(static_cast<MetricOperation>(op))
+                                  + "\"";
+
+        uint64_t count = 0;
+        for(uint32_t bucket = 0; bucket < NUMBER_OF_LATENCY_BUCKETS; bucket++)
+        {
+            count += opMetrics->latencyBuckets[bucket];
+            std::string border = "+Inf";
+            if(bucket < NUMBER_OF_LATENCY_BUCKETS - 1)
+            {
+                border = std::to_string(LATENCY_BUCKET_BORDERS[bucket]);
+                border.erase(border.find_last_not_of('0') + 1);
+                if(border.back() == '.') {
+                    border += "0";
+                }
+            }
+            output += name + "_bucket{" + label + ",le=\"" + border + "\"} "
+                      + std::to_string(count) + "\n";
+        }
+
+        // write the sum with the full precision of the nanoseconds
+        std::string fraction = std::to_string(opMetrics->latencySumNs % 1000000000);
+        fraction.insert(0, 9 - fraction.size(), '0');
+        output += name + "_sum{" + label + "} "
+                  + std::to_string(opMetrics->latencySumNs / 1000000000) + "." + fraction + "\n";
+        output += name + "_count{" + label + "} " + std::to_string(count) + "\n";
+    }
+
+    return output;
+}
+
+/**
+ * @brief reset the metrics of all operations
+ */
+void
+resetMetrics()
+{
+    MetricsCollector::getInstance()->reset();
+}
+
+}
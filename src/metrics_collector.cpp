@@ -0,0 +1,251 @@
+/**
+ * @file        metrics_collector.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <metrics_collector.h>
+
+#include <algorithm>
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ */
+MetricsCollector::MetricsCollector() {}
+
+/**
+ * @brief get instance of the collector
+ *
+ * @return pointer to the static instance
+ */
+MetricsCollector*
+MetricsCollector::getInstance()
+{
+    static MetricsCollector* instance = new MetricsCollector();
+    return instance;
+}
+
+/**
+ * @brief destructor of the registration of a thread, which moves the counters of the finished
+ *        thread into the collector
+ */
+MetricsCollector::ThreadRegistration::~ThreadRegistration()
+{
+    if(metrics != nullptr) {
+        MetricsCollector::getInstance()->retire(metrics);
+    }
+}
+
+/**
+ * @brief add a value to a counter of an operation
+ *
+ * @param operation measured operation
+ * @param field counter to increase
+ * @param value value to add
+ */
+void
+MetricsCollector::add(const MetricOperation operation,
+                      const MetricField field,
+                      const uint64_t value)
+{
+    // only the own thread writes into the counters, so no atomic read-modify-write is necessary
+    std::atomic<uint64_t>* counter = &getThreadMetrics()->values[operation][field];
+    counter->store(counter->load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief add a finished call of an operation
+ *
+ * @param operation measured operation
+ * @param durationNs duration of the call in nanoseconds
+ * @param failed true, if the call failed
+ */
+void
+MetricsCollector::addLatency(const MetricOperation operation,
+                             const uint64_t durationNs,
+                             const bool failed)
+{
+    const double durationSec = static_cast<double>(durationNs) / 1000000000.0;
+    uint32_t bucket = 0;
+    while(bucket < NUMBER_OF_LATENCY_BUCKETS - 1
+          && durationSec > LATENCY_BUCKET_BORDERS[bucket])
+    {
+        bucket++;
+    }
+
+    add(operation, CALLS_FIELD, 1);
+    add(operation, LATENCY_SUM_FIELD, durationNs);
+    add(operation, static_cast<MetricField>(LATENCY_BUCKET_FIELD + bucket), 1);
+    if(failed) {
+        add(operation, FAILURES_FIELD, 1);
+    }
+}
+
+/**
+ * @brief collect the counters of all threads
+ *
+ * @param metrics reference for the resulting metrics, one entry per operation
+ */
+void
+MetricsCollector::collect(std::vector<OperationMetrics> &metrics)
+{
+    uint64_t values[NUMBER_OF_METRIC_OPERATIONS][NUMBER_OF_METRIC_FIELDS] = {};
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        sum(values);
+    }
+
+    metrics.clear();
+    metrics.resize(NUMBER_OF_METRIC_OPERATIONS);
+    for(uint32_t op = 0; op < NUMBER_OF_METRIC_OPERATIONS; op++)
+    {
+        OperationMetrics* result = &metrics[op];
+        result->numberOfCalls = values[op][CALLS_FIELD];
+        result->numberOfFailures = values[op][FAILURES_FIELD];
+        result->numberOfRetries = values[op][RETRIES_FIELD];
+        result->bytesSent = values[op][BYTES_SENT_FIELD];
+        result->bytesReceived = values[op][BYTES_RECEIVED_FIELD];
+        result->numberOfSegments = values[op][SEGMENTS_FIELD];
+        result->latencySumNs = values[op][LATENCY_SUM_FIELD];
+        for(uint32_t bucket = 0; bucket < NUMBER_OF_LATENCY_BUCKETS; bucket++) {
+            result->latencyBuckets[bucket] = values[op][LATENCY_BUCKET_FIELD + bucket];
+        }
+    }
+}
+
+/**
+ * @brief reset all counters. The counters of the threads are not touched, because they are
+ *        written without lock, so the current values are stored as new baseline instead.
+ */
+void
+MetricsCollector::reset()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    uint64_t values[NUMBER_OF_METRIC_OPERATIONS][NUMBER_OF_METRIC_FIELDS] = {};
+    sum(values);
+    for(uint32_t op = 0; op < NUMBER_OF_METRIC_OPERATIONS; op++)
+    {
+        for(uint32_t field = 0; field < NUMBER_OF_METRIC_FIELDS; field++) {
+            m_baseline[op][field] += values[op][field];
+        }
+    }
+}
+
+/**
+ * @brief get counters of the current thread and register them at the first call
+ *
+ * @return pointer to the counters of the current thread
+ */
+MetricsCollector::ThreadMetrics*
+MetricsCollector::getThreadMetrics()
+{
+    thread_local ThreadRegistration registration;
+    if(registration.metrics != nullptr) {
+        return registration.metrics;
+    }
+
+    ThreadMetrics* metrics = new ThreadMetrics();
+    for(uint32_t op = 0; op < NUMBER_OF_METRIC_OPERATIONS; op++)
+    {
+        for(uint32_t field = 0; field < NUMBER_OF_METRIC_FIELDS; field++) {
+            metrics->values[op][field].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_threadMetrics.push_back(metrics);
+    }
+    registration.metrics = metrics;
+
+    return metrics;
+}
+
+/**
+ * @brief move the counters of a finished thread into the collector
+ *
+ * @param metrics counters of the finished thread
+ */
+void
+MetricsCollector::retire(ThreadMetrics* metrics)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for(uint32_t op = 0; op < NUMBER_OF_METRIC_OPERATIONS; op++)
+    {
+        for(uint32_t field = 0; field < NUMBER_OF_METRIC_FIELDS; field++) {
+            m_retired[op][field] += metrics->values[op][field].load(std::memory_order_relaxed);
+        }
+    }
+
+    m_threadMetrics.erase(std::remove(m_threadMetrics.begin(), m_threadMetrics.end(), metrics),
+                          m_threadMetrics.end());
+    delete metrics;
+}
+
+/**
+ * @brief sum up the counters of all threads. Must be called while holding the lock.
+ *
+ * @param values array for the resulting sums
+ */
+void
+MetricsCollector::sum(uint64_t values[NUMBER_OF_METRIC_OPERATIONS][NUMBER_OF_METRIC_FIELDS])
+{
+    for(uint32_t op = 0; op < NUMBER_OF_METRIC_OPERATIONS; op++)
+    {
+        for(uint32_t field = 0; field < NUMBER_OF_METRIC_FIELDS; field++)
+        {
+            uint64_t value = m_retired[op][field];
+            for(const ThreadMetrics* metrics : m_threadMetrics) {
+                value += metrics->values[op][field].load(std::memory_order_relaxed);
+            }
+            values[op][field] = value - m_baseline[op][field];
+        }
+    }
+}
+
+/**
+ * @brief constructor, which starts the time-measurement of a call
+ *
+ * @param operation measured operation
+ */
+MetricScope::MetricScope(const MetricOperation operation)
+{
+    m_operation = operation;
+    m_start = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief destructor, which adds the call to the metrics. Calls, which were not marked as
+ *        successful by finish, are counted as failed.
+ */
+MetricScope::~MetricScope()
+{
+    const std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - m_start;
+    MetricsCollector::getInstance()->addLatency(m_operation,
+                                                static_cast<uint64_t>(duration.count()),
+                                                m_success == false);
+}
+
+}
@@ -0,0 +1,119 @@
+/**
+ * @file        metrics_collector.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_METRICS_COLLECTOR_H
+#define KITSUNEMIMI_HANAMI_SHIORI_METRICS_COLLECTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <libShioriArchive/metrics.h>
+
+namespace Shiori
+{
+
+enum MetricField
+{
+    CALLS_FIELD = 0,
+    FAILURES_FIELD = 1,
+    RETRIES_FIELD = 2,
+    BYTES_SENT_FIELD = 3,
+    BYTES_RECEIVED_FIELD = 4,
+    SEGMENTS_FIELD = 5,
+    LATENCY_SUM_FIELD = 6,
+    LATENCY_BUCKET_FIELD = 7,
+
+    NUMBER_OF_METRIC_FIELDS = LATENCY_BUCKET_FIELD + NUMBER_OF_LATENCY_BUCKETS,
+};
+
+class MetricsCollector
+{
+public:
+    static MetricsCollector* getInstance();
+
+    void add(const MetricOperation operation,
+             const MetricField field,
+             const uint64_t value);
+    void addLatency(const MetricOperation operation,
+                    const uint64_t durationNs,
+                    const bool failed);
+
+    void collect(std::vector<OperationMetrics> &metrics);
+    void reset();
+
+private:
+    MetricsCollector();
+
+    // counters of a single thread, which are only written by their own thread
+    struct ThreadMetrics
+    {
+        std::atomic<uint64_t> values[NUMBER_OF_METRIC_OPERATIONS][NUMBER_OF_METRIC_FIELDS];
+    };
+
+    struct ThreadRegistration
+    {
+        ThreadMetrics* metrics = nullptr;
+        ~ThreadRegistration();
+    };
+
+    std::mutex m_lock;
+    std::vector<ThreadMetrics*> m_threadMetrics;
+    // values of already finished threads and values at the time of the last reset
+    uint64_t m_retired[NUMBER_OF_METRIC_OPERATIONS][NUMBER_OF_METRIC_FIELDS] = {};
+    uint64_t m_baseline[NUMBER_OF_METRIC_OPERATIONS][NUMBER_OF_METRIC_FIELDS] = {};
+
+    ThreadMetrics* getThreadMetrics();
+    void retire(ThreadMetrics* metrics);
+    void sum(uint64_t values[NUMBER_OF_METRIC_OPERATIONS][NUMBER_OF_METRIC_FIELDS]);
+};
+
+class MetricScope
+{
+public:
+    MetricScope(const MetricOperation operation);
+    ~MetricScope();
+
+    /**
+     * @brief mark the operation as successful, if the result is valid
+     *
+     * @param result result of the operation, which is true or a valid pointer on success
+     *
+     * @return the unchanged result
+     */
+    template<typename T>
+    T finish(T result)
+    {
+        m_success = static_cast<bool>(result);
+        return result;
+    }
+
+private:
+    MetricOperation m_operation;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_success = false;
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_METRICS_COLLECTOR_H
@@ -22,6 +22,15 @@
 
 #include <libShioriArchive/other.h>
 
+#include <audit_queue.h>
+#include <buffer_pool.h>
+#include <client_pool.h>
+#include <error_aggregator.h>
+#include <json_helper.h>
+#include <metrics_collector.h>
+
+#include <algorithm>
+
 #include <libKitsunemimiCommon/buffer/data_buffer.h>
 #include <libKitsunemimiCommon/logger.h>
 #include <libKitsunemimiCrypto/common.h>
@@ -34,113 +43,599 @@
 #include <../../libKitsunemimiHanamiMessages/protobuffers/shiori_messages.proto3.pb.h>
 #include <../../libKitsunemimiHanamiMessages/message_sub_types.h>
 
-using Kitsunemimi::Hanami::HanamiMessaging;
 using Kitsunemimi::Hanami::HanamiMessagingClient;
 using Kitsunemimi::Hanami::SupportedComponents;
 
 namespace Shiori
 {
 
+// maximum capacity of the results, which is kept by the reused result-message of a thread
+const uint64_t MAX_REUSED_RESULT_SIZE = 1024 * 1024;
+
+// characters of the base64-encoding of binary results
+const char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
 /**
- * @brief send list with request-results to shiori
+ * @brief get the result-message of the current thread. The message is reused for all results,
+ *        which are sent by the thread, so the strings of the message are not allocated again
+ *        for each call.
  *
  * @param uuid uuid of the request-task
  * @param name name of the request-task
- * @param results data-array with results
+ * @param userId id of the user who owns the request-task
+ * @param projectId id of the project of the request-task
+ *
+ * @return reference to the prepared message
+ */
+static ResultPush_Message&
+getResultMessage(const std::string &uuid,
+                 const std::string &name,
+                 const std::string &userId,
+                 const std::string &projectId)
+{
+    thread_local ResultPush_Message msg;
+    msg.set_uuid(uuid);
+    msg.set_name(name);
+    msg.set_userid(userId);
+    msg.set_projectid(projectId);
+
+    return msg;
+}
+
+/**
+ * @brief release the results of a reused result-message, if they are too big to be kept
+ *
+ * @param msg message with the results
+ */
+static void
+releaseResults(ResultPush_Message &msg)
+{
+    std::string* results = msg.mutable_results();
+    if(results->capacity() > MAX_REUSED_RESULT_SIZE) {
+        std::string().swap(*results);
+    }
+}
+
+/**
+ * @brief serialize and send a result-message to shiori
+ *
+ * @param msg message to send
  * @param error reference for error-output
  *
  * @return true, if successful, else false
  */
-bool
-sendResults(const std::string &uuid,
-            const std::string &name,
-            const std::string &userId,
-            const std::string &projectId,
-            const Kitsunemimi::DataArray &results,
-            Kitsunemimi::ErrorContainer &error)
+static bool
+sendResultMessage(ResultPush_Message &msg,
+                  Kitsunemimi::ErrorContainer &error)
 {
     // get client
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
     if(client == nullptr)
     {
         error.addMeesage("Failed to get client for connection to shiori");
+        releaseResults(msg);
         return false;
     }
 
-    // create message
-    ResultPush_Message msg;
-    msg.set_uuid(uuid);
-    msg.set_name(name);
-    msg.set_userid(userId);
-    msg.set_projectid(projectId);
-    msg.set_results(results.toString());
-
     // serialize message
-    const uint64_t msgSize = msg.ByteSizeLong();
-    uint8_t* buffer = new uint8_t[msgSize];
-    if(msg.SerializeToArray(buffer, msgSize) == false)
+    PooledBuffer buffer;
+    uint64_t msgSize = 0;
+    const uint8_t* serialized = serializeMessage(buffer, msgSize, msg, error);
+    releaseResults(msg);
+    if(serialized == nullptr)
     {
-        error.addMeesage("Failed to serialize error-message to shiori");
-        delete[] buffer;
+        error.addMeesage("Failed to serialize result-message to shiori");
         return false;
     }
 
     // send message
+    MetricsCollector::getInstance()->add(SEND_RESULTS_OPERATION, BYTES_SENT_FIELD, msgSize);
     Kitsunemimi::DataBuffer* ret = client->sendGenericRequest(SHIORI_RESULT_PUSH_MESSAGE_TYPE,
-                                                              buffer,
+                                                              serialized,
                                                               msgSize,
                                                               error);
     if(ret == nullptr)
     {
         error.addMeesage("Failed to send result-message to shiori");
-        delete[] buffer;
         return false;
     }
 
     delete ret;
-    delete[] buffer;
 
     return true;
 }
 
 /**
- * @brief send error-message to shiori
+ * @brief append data base64-encoded to a string
  *
- * @param userId id of the user where the error belongs to
- * @param errorMessage error-message to send to shiori
+ * @param output string where the encoded data should be appended
+ * @param data pointer to the data to encode
+ * @param dataSize number of bytes to encode
+ */
+static void
+appendBase64(std::string &output,
+             const uint8_t* data,
+             const uint64_t dataSize)
+{
+    const uint64_t start = output.size();
+    output.resize(start + ((dataSize + 2) / 3) * 4);
+    char* target = &output[start];
+
+    uint64_t i = 0;
+    for(; i + 3 <= dataSize; i += 3)
+    {
+        const uint32_t block = (static_cast<uint32_t>(data[i]) << 16)
+                               | (static_cast<uint32_t>(data[i + 1]) << 8)
+                               | static_cast<uint32_t>(data[i + 2]);
+        *target++ = BASE64_CHARS[(block >> 18) & 0x3F];
+        *target++ = BASE64_CHARS[(block >> 12) & 0x3F];
+        *target++ = BASE64_CHARS[(block >> 6) & 0x3F];
+        *target++ = BASE64_CHARS[block & 0x3F];
+    }
+
+    // pad the last incomplete block
+    const uint64_t rest = dataSize - i;
+    if(rest > 0)
+    {
+        uint32_t block = static_cast<uint32_t>(data[i]) << 16;
+        if(rest == 2) {
+            block |= static_cast<uint32_t>(data[i + 1]) << 8;
+        }
+        *target++ = BASE64_CHARS[(block >> 18) & 0x3F];
+        *target++ = BASE64_CHARS[(block >> 12) & 0x3F];
+        *target++ = rest == 2 ? BASE64_CHARS[(block >> 6) & 0x3F] : '=';
+        *target++ = '=';
+    }
+}
+
+/**
+ * @brief append numeric results in binary form to a json-object. The result-field of the
+ *        message is a string, which has to be valid utf8, so the raw little-endian values are
+ *        base64-encoded and written together with their type and number.
+ *
+ * @param output json-object, which is not closed yet
+ * @param type name of the type of the values
+ * @param values pointer to the values
+ * @param numberOfValues number of values
+ * @param valueSize size of a single value in bytes
+ */
+static void
+appendBinaryResults(std::string &output,
+                    const std::string &type,
+                    const void* values,
+                    const uint64_t numberOfValues,
+                    const uint64_t valueSize)
+{
+    const uint64_t dataSize = numberOfValues * valueSize;
+    output.reserve(output.size() + 128 + ((dataSize + 2) / 3) * 4);
+
+    appendJsonField(output, "type", type);
+    appendJsonField(output, "encoding", "base64");
+    appendJsonField(output, "count", numberOfValues);
+    output.append(",\"data\":\"");
+    appendBase64(output, static_cast<const uint8_t*>(values), dataSize);
+    output.append("\"");
+}
+
+/**
+ * @brief write numeric results in binary form as json-object into the result-field of a message
+ *
+ * @param msg message with the result-field
+ * @param type name of the type of the values
+ * @param values pointer to the values
+ * @param numberOfValues number of values
+ * @param valueSize size of a single value in bytes
+ */
+static void
+writeBinaryResults(ResultPush_Message &msg,
+                   const std::string &type,
+                   const void* values,
+                   const uint64_t numberOfValues,
+                   const uint64_t valueSize)
+{
+    std::string* output = msg.mutable_results();
+    output->clear();
+    output->push_back('{');
+    appendBinaryResults(*output, type, values, numberOfValues, valueSize);
+    output->push_back('}');
+}
+
+/**
+ * @brief constructor
+ *
+ * @param uuid uuid of the request-task
+ * @param name name of the request-task
+ * @param userId id of the user who owns the request-task
+ * @param projectId id of the project of the request-task
+ * @param batchSize maximum size in bytes of the values, which are sent together in one part
+ */
+ResultStream::ResultStream(const std::string &uuid,
+                           const std::string &name,
+                           const std::string &userId,
+                           const std::string &projectId,
+                           const uint64_t batchSize)
+{
+    m_uuid = uuid;
+    m_name = name;
+    m_userId = userId;
+    m_projectId = projectId;
+    // a part must have space for at least one value of each type
+    m_batchSize = std::max(batchSize, static_cast<uint64_t>(sizeof(int64_t)));
+}
+
+/**
+ * @brief append values of any type to the current batch and send the batch as part, every
+ *        time it is full
+ *
+ * @param type name of the type of the values
+ * @param values pointer to the values
+ * @param numberOfValues number of values
+ * @param valueSize size of a single value in bytes
  * @param error reference for error-output
  *
  * @return true, if successful, else false
  */
 bool
-sendErrorMessage(const std::string &userId,
-                 const std::string &errorMessage,
-                 Kitsunemimi::ErrorContainer &error)
+ResultStream::appendValues(const std::string &type,
+                           const void* values,
+                           const uint64_t numberOfValues,
+                           const uint64_t valueSize,
+                           Kitsunemimi::ErrorContainer &error)
 {
-    // get client
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
-    if(client == nullptr)
+    if(m_closed)
     {
-        error.addMeesage("Failed to get client for connection to shiori");
+        error.addMeesage("Result-stream of task '" + m_uuid + "' is already closed");
         return false;
     }
+    if(m_failed)
+    {
+        error.addMeesage("Result-stream of task '" + m_uuid + "' failed before");
+        return false;
+    }
+
+    // all values of a part have the same type
+    if(m_batchType != type)
+    {
+        if(sendPart(false, error) == false) {
+            return false;
+        }
+        m_batchType = type;
+    }
+
+    const uint8_t* u8Values = static_cast<const uint8_t*>(values);
+    const uint64_t valuesPerPart = m_batchSize / valueSize;
+    uint64_t pos = 0;
+    while(pos < numberOfValues)
+    {
+        const uint64_t freeValues = valuesPerPart - (m_batch.size() / valueSize);
+        const uint64_t count = std::min(freeValues, numberOfValues - pos);
+        m_batch.append(reinterpret_cast<const char*>(&u8Values[pos * valueSize]),
+                       count * valueSize);
+        pos += count;
+        m_numberOfValues += count;
+
+        if(m_batch.size() / valueSize == valuesPerPart
+                && sendPart(false, error) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief send the values of the current batch as next part to shiori. Shiori stores the results
+ *        of a task under its uuid, so each part is sent as result of its own key, which is the
+ *        uuid of the task with the suffix "_part_" and the number of the part. The results of
+ *        the part are a json-object with the fields "part" and "last" and the binary values
+ *        like in sendResults. Readers get the number of parts from the results of the task
+ *        itself, which are sent by close(), and append the values of the parts in the order of
+ *        their numbers. While the task runs, the parts can be read in the same order, until a
+ *        part is missing or has the last-flag.
+ *
+ * @param isLast true, if this is the last part of the stream
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ResultStream::sendPart(const bool isLast,
+                       Kitsunemimi::ErrorContainer &error)
+{
+    // empty batches are only sent to mark the end of the stream
+    if(m_batch.size() == 0
+            && isLast == false)
+    {
+        return true;
+    }
+
+    MetricScope metric(SEND_RESULTS_OPERATION);
+
+    uint64_t valueSize = sizeof(float);
+    if(m_batchType == "int64") {
+        valueSize = sizeof(int64_t);
+    }
 
     // create message
-    ErrorLog_Message msg;
+    const std::string partKey = m_uuid + "_part_" + std::to_string(m_numberOfParts);
+    ResultPush_Message &msg = getResultMessage(partKey, m_name, m_userId, m_projectId);
+    std::string* output = msg.mutable_results();
+    output->clear();
+    output->push_back('{');
+    appendJsonField(*output, "part", m_numberOfParts);
+    output->append(isLast ? ",\"last\":true" : ",\"last\":false");
+    appendBinaryResults(*output,
+                        m_batchType,
+                        m_batch.data(),
+                        m_batch.size() / valueSize,
+                        valueSize);
+    output->push_back('}');
+
+    // a failed part would leave a gap in the numbers of the parts, so the stream can not be
+    // continued after a failure. The batch is not filled anymore, so the memory stays bounded.
+    if(sendResultMessage(msg, error) == false)
+    {
+        m_failed = true;
+        error.addMeesage("Failed to send part '"
+                         + std::to_string(m_numberOfParts)
+                         + "' of result-stream of task '"
+                         + m_uuid
+                         + "'");
+        return false;
+    }
+
+    m_batch.clear();
+    m_numberOfParts++;
+
+    return metric.finish(true);
+}
+
+/**
+ * @brief append results to the stream. The values are copied, so the caller can reuse its
+ *        buffer for the next results. Every time the values reach the batch-size, they are
+ *        sent as next part to shiori.
+ *
+ * @param values pointer to the values
+ * @param numberOfValues number of values
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ResultStream::append(const float* values,
+                     const uint64_t numberOfValues,
+                     Kitsunemimi::ErrorContainer &error)
+{
+    return appendValues("float32", values, numberOfValues, sizeof(float), error);
+}
+
+/**
+ * @brief append results to the stream. The values are copied, so the caller can reuse its
+ *        buffer for the next results. Every time the values reach the batch-size, they are
+ *        sent as next part to shiori.
+ *
+ * @param values pointer to the values
+ * @param numberOfValues number of values
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ResultStream::append(const int64_t* values,
+                     const uint64_t numberOfValues,
+                     Kitsunemimi::ErrorContainer &error)
+{
+    return appendValues("int64", values, numberOfValues, sizeof(int64_t), error);
+}
+
+/**
+ * @brief get number of appended values
+ *
+ * @return number of values
+ */
+uint64_t
+ResultStream::getNumberOfValues() const
+{
+    return m_numberOfValues;
+}
+
+/**
+ * @brief get number of parts, which were already sent to shiori
+ *
+ * @return number of parts
+ */
+uint64_t
+ResultStream::getNumberOfParts() const
+{
+    return m_numberOfParts;
+}
+
+/**
+ * @brief close the stream and send the remaining results as last part to shiori. The last
+ *        part is also sent, if it is empty, so the end of the stream is visible in shiori.
+ *        Afterwards the results of the task itself are sent as json-object with the number
+ *        of parts and values, so readers know which parts belong to the results.
+ *
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ResultStream::close(Kitsunemimi::ErrorContainer &error)
+{
+    if(m_closed)
+    {
+        error.addMeesage("Result-stream of task '" + m_uuid + "' is already closed");
+        return false;
+    }
+    if(m_failed)
+    {
+        error.addMeesage("Result-stream of task '" + m_uuid + "' failed before");
+        return false;
+    }
+    m_closed = true;
+
+    if(sendPart(true, error) == false) {
+        return false;
+    }
+
+    MetricScope metric(SEND_RESULTS_OPERATION);
+
+    ResultPush_Message &msg = getResultMessage(m_uuid, m_name, m_userId, m_projectId);
+    std::string* output = msg.mutable_results();
+    output->clear();
+    output->push_back('{');
+    appendJsonField(*output, "parts", m_numberOfParts);
+    appendJsonField(*output, "count", m_numberOfValues);
+    output->push_back('}');
+
+    if(sendResultMessage(msg, error) == false)
+    {
+        m_failed = true;
+        error.addMeesage("Failed to send results of result-stream of task '" + m_uuid + "'");
+        return false;
+    }
+
+    return metric.finish(true);
+}
+
+/**
+ * @brief send list with request-results to shiori
+ *
+ * @param uuid uuid of the request-task
+ * @param name name of the request-task
+ * @param userId id of the user who owns the request-task
+ * @param projectId id of the project of the request-task
+ * @param results data-array with results
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+sendResults(const std::string &uuid,
+            const std::string &name,
+            const std::string &userId,
+            const std::string &projectId,
+            const Kitsunemimi::DataArray &results,
+            Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(SEND_RESULTS_OPERATION);
+
+    // create message
+    ResultPush_Message &msg = getResultMessage(uuid, name, userId, projectId);
+    msg.set_results(results.toString());
+
+    return metric.finish(sendResultMessage(msg, error));
+}
+
+/**
+ * @brief send list of numeric request-results to shiori. The values are written in binary form
+ *        directly into the message, without building a data-array and its string-representation
+ *        first. The result is a json-object with the fields "type" with value "float32",
+ *        "encoding" with value "base64", "count" with the number of values and "data" with
+ *        the base64-encoded little-endian values.
+ *
+ * @param uuid uuid of the request-task
+ * @param name name of the request-task
+ * @param userId id of the user who owns the request-task
+ * @param projectId id of the project of the request-task
+ * @param results list with results
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+sendResults(const std::string &uuid,
+            const std::string &name,
+            const std::string &userId,
+            const std::string &projectId,
+            const std::vector<float> &results,
+            Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(SEND_RESULTS_OPERATION);
+
+    // create message
+    ResultPush_Message &msg = getResultMessage(uuid, name, userId, projectId);
+    writeBinaryResults(msg, "float32", results.data(), results.size(), sizeof(float));
+
+    return metric.finish(sendResultMessage(msg, error));
+}
+
+/**
+ * @brief send list of numeric request-results to shiori. The values are written in binary form
+ *        directly into the message, without building a data-array and its string-representation
+ *        first. The result is a json-object with the fields "type" with value "int64",
+ *        "encoding" with value "base64", "count" with the number of values and "data" with
+ *        the base64-encoded little-endian values.
+ *
+ * @param uuid uuid of the request-task
+ * @param name name of the request-task
+ * @param userId id of the user who owns the request-task
+ * @param projectId id of the project of the request-task
+ * @param results list with results
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+sendResults(const std::string &uuid,
+            const std::string &name,
+            const std::string &userId,
+            const std::string &projectId,
+            const std::vector<int64_t> &results,
+            Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(SEND_RESULTS_OPERATION);
+
+    // create message
+    ResultPush_Message &msg = getResultMessage(uuid, name, userId, projectId);
+    writeBinaryResults(msg, "int64", results.data(), results.size(), sizeof(int64_t));
+
+    return metric.finish(sendResultMessage(msg, error));
+}
+
+/**
+ * @brief serialize and send a single error-message to shiori
+ *
+ * @param client client for the connection to shiori
+ * @param msg reused message, which is overwritten with the new content
+ * @param userId id of the user where the error belongs to
+ * @param errorMessage error-message to send to shiori
+ * @param operation operation, which is measured by the metrics
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+static bool
+sendErrorLogMessage(ShioriConnection* client,
+                    ErrorLog_Message &msg,
+                    const std::string &userId,
+                    const std::string &errorMessage,
+                    const MetricOperation operation,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    // fill message
     msg.set_userid(userId);
     msg.set_errormsg(errorMessage);
 
     // serialize message
-    uint8_t buffer[96*1024];
-    const uint64_t msgSize = msg.ByteSizeLong();
-    if(msg.SerializeToArray(buffer, msgSize) == false)
+    PooledBuffer buffer;
+    uint64_t msgSize = 0;
+    const uint8_t* serialized = serializeMessage(buffer, msgSize, msg, error);
+    if(serialized == nullptr)
     {
         error.addMeesage("Failed to serialize error-message to shiori");
         return false;
     }
 
     // send message
-    if(client->sendGenericMessage(SHIORI_ERROR_LOG_MESSAGE_TYPE, buffer, msgSize, error) == false)
+    MetricsCollector::getInstance()->add(operation, BYTES_SENT_FIELD, msgSize);
+    if(client->sendGenericMessage(SHIORI_ERROR_LOG_MESSAGE_TYPE,
+                                  serialized,
+                                  msgSize,
+                                  error) == false)
     {
         error.addMeesage("Failed to send error-message to shiori");
         return false;
@@ -149,6 +644,154 @@ sendErrorMessage(const std::string &userId,
     return true;
 }
 
+/**
+ * @brief send all error-messages, which were released by the aggregator
+ *
+ * @param client client for the connection to shiori
+ * @param readyToSend messages to send
+ * @param operation operation, which is measured by the metrics
+ * @param error reference for error-output
+ *
+ * @return true, if all messages were sent successfully, else false
+ */
+static bool
+sendErrorRecords(ShioriConnection* client,
+                 const std::vector<ErrorRecord> &readyToSend,
+                 const MetricOperation operation,
+                 Kitsunemimi::ErrorContainer &error)
+{
+    // message is reused for all error-messages, which are sent by the thread
+    thread_local ErrorLog_Message msg;
+
+    bool success = true;
+    for(const ErrorRecord &record : readyToSend)
+    {
+        if(sendErrorLogMessage(client,
+                               msg,
+                               record.userId,
+                               record.errorMessage,
+                               operation,
+                               error) == false)
+        {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+/**
+ * @brief send error-messages, whose time-window has ended, from the background-thread of the
+ *        error-aggregator
+ *
+ * @param readyToSend messages to send
+ */
+static void
+sendExpiredErrorRecords(const std::vector<ErrorRecord> &readyToSend)
+{
+    Kitsunemimi::ErrorContainer error;
+
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
+    if(client == nullptr)
+    {
+        error.addMeesage("Failed to get client for connection to shiori, so "
+                         + std::to_string(readyToSend.size())
+                         + " counted error-messages are dropped");
+        LOG_ERROR(error);
+        return;
+    }
+
+    if(sendErrorRecords(client, readyToSend, FLUSH_ERROR_MESSAGES_OPERATION, error) == false) {
+        LOG_ERROR(error);
+    }
+}
+
+/**
+ * @brief send error-message to shiori. Depending on the configured limits, identical messages
+ *        are combined into one counted message and the number of messages per second is limited.
+ *
+ * @param userId id of the user where the error belongs to
+ * @param errorMessage error-message to send to shiori
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+sendErrorMessage(const std::string &userId,
+                 const std::string &errorMessage,
+                 Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(SEND_ERROR_MESSAGE_OPERATION);
+
+    // get client
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
+    if(client == nullptr)
+    {
+        error.addMeesage("Failed to get client for connection to shiori");
+        return false;
+    }
+
+    std::vector<ErrorRecord> readyToSend;
+    ErrorAggregator::getInstance()->add(readyToSend, userId, errorMessage);
+
+    return metric.finish(sendErrorRecords(client,
+                                          readyToSend,
+                                          SEND_ERROR_MESSAGE_OPERATION,
+                                          error));
+}
+
+/**
+ * @brief set limits for error-messages. A value of 0 disables the corresponding limit. Without
+ *        time-window, messages above the rate-limit are dropped. With time-window, they are
+ *        counted and sent as one message by a background-thread at the end of the time-window.
+ *        At most 10000 different messages are counted at the same time, all others are handled
+ *        like without time-window.
+ *
+ * @param windowMs time-window in milliseconds, in which identical messages of the same user
+ *                 are combined into one counted message
+ * @param maxMessagesPerSecond maximum number of error-messages per second
+ */
+void
+setErrorMessageLimits(const uint64_t windowMs,
+                      const uint32_t maxMessagesPerSecond)
+{
+    ErrorAggregator::getInstance()->setLimits(windowMs,
+                                              maxMessagesPerSecond,
+                                              sendExpiredErrorRecords);
+}
+
+/**
+ * @brief send all counted error-messages, without waiting for the end of their time-window
+ *
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+flushErrorMessages(Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(FLUSH_ERROR_MESSAGES_OPERATION);
+
+    // get client
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
+    if(client == nullptr)
+    {
+        error.addMeesage("Failed to get client for connection to shiori");
+        return false;
+    }
+
+    std::vector<ErrorRecord> readyToSend;
+    ErrorAggregator::getInstance()->flush(readyToSend);
+
+    return metric.finish(sendErrorRecords(client,
+                                          readyToSend,
+                                          FLUSH_ERROR_MESSAGES_OPERATION,
+                                          error));
+}
+
 /**
  * @brief send audit-log-entry to shiori
  *
@@ -167,6 +810,8 @@ sendAuditMessage(const std::string &targetComponent,
                  const Kitsunemimi::Hanami::HttpRequestType requestType,
                  Kitsunemimi::ErrorContainer &error)
 {
+    MetricScope metric(SEND_AUDIT_MESSAGE_OPERATION);
+
     // check if shiori is supported
     if(SupportedComponents::getInstance()->support[Kitsunemimi::Hanami::SHIORI] == false) {
         return false;
@@ -192,39 +837,160 @@ sendAuditMessage(const std::string &targetComponent,
 
     LOG_DEBUG("process uri: \'" + targetEndpoint + "\' with type '" + httpType + "'");
 
+    // hand over to the background-thread, if active, else send directly
+    const AuditPushResult pushResult = AuditQueue::getInstance()->push(targetComponent,
+                                                                       targetEndpoint,
+                                                                       userId,
+                                                                       httpType);
+    if(pushResult == AUDIT_ENTRY_QUEUED) {
+        return metric.finish(true);
+    }
+    if(pushResult == AUDIT_QUEUE_FULL)
+    {
+        error.addMeesage("Failed to queue audit-message, because the queue is full");
+        return false;
+    }
+
     // get client
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
     if(client == nullptr)
     {
         error.addMeesage("Failed to get client for connection to shiori");
         return false;
     }
 
-    // create message
-    AuditLog_Message msg;
+    // create message, which is reused for all audit-messages, which are sent by the thread
+    thread_local AuditLog_Message msg;
     msg.set_userid(userId);
     msg.set_type(httpType);
     msg.set_component(targetComponent);
     msg.set_endpoint(targetEndpoint);
 
     // serialize message
-    uint8_t buffer[96*1024];
-    const uint64_t msgSize = msg.ByteSizeLong();
-    if(msg.SerializeToArray(buffer, msgSize) == false)
+    PooledBuffer buffer;
+    uint64_t msgSize = 0;
+    const uint8_t* serialized = serializeMessage(buffer, msgSize, msg, error);
+    if(serialized == nullptr)
     {
         error.addMeesage("Failed to serialize audit-message to shiori");
         return false;
     }
 
     // send message
-    if(client->sendGenericMessage(SHIORI_AUDIT_LOG_MESSAGE_TYPE, buffer, msgSize, error) == false)
+    MetricsCollector::getInstance()->add(SEND_AUDIT_MESSAGE_OPERATION, BYTES_SENT_FIELD, msgSize);
+    if(client->sendGenericMessage(SHIORI_AUDIT_LOG_MESSAGE_TYPE,
+                                  serialized,
+                                  msgSize,
+                                  error) == false)
     {
         error.addMeesage("Failed to send audit-message to shiori");
         LOG_ERROR(error);
         return false;
     }
 
-    return true;
+    return metric.finish(true);
+}
+
+/**
+ * @brief start background-thread for audit-log-entries. While active, sendAuditMessage only
+ *        queues the entries and the background-thread sends them to shiori. The batch-size
+ *        only controls, how often the thread wakes up. Each entry is still sent as its own
+ *        message, because shiori has no message for multiple audit-entries.
+ *
+ * @param maxBatchSize number of queued entries, which trigger a send before the interval ends
+ * @param flushIntervalMs maximum time in milliseconds, how long an entry is queued
+ *
+ * @return false, if already active, else true
+ */
+bool
+startAuditQueue(const uint32_t maxBatchSize,
+                const uint32_t flushIntervalMs)
+{
+    return AuditQueue::getInstance()->start(maxBatchSize, flushIntervalMs);
+}
+
+/**
+ * @brief stop background-thread for audit-log-entries after all queued entries were sent. After
+ *        this, sendAuditMessage sends the entries directly again.
+ */
+void
+stopAuditQueue()
+{
+    AuditQueue::getInstance()->stop();
+}
+
+/**
+ * @brief set the maximum number of bytes, which can be allocated at the same time for the
+ *        buffers of serialized messages and snapshot-segments. By default there is no limit.
+ *        With a limit, every message, which doesn't fit into the remaining memory, fails. This
+ *        includes the results of sendResults, which are serialized as one message, and the
+ *        segments of snapshot-uploads, so the limit has to be above the biggest result-message
+ *        plus the segments of all parallel uploads.
+ *
+ * @param limit new limit in bytes
+ */
+void
+setBufferPoolLimit(const uint64_t limit)
+{
+    BufferPool::getInstance()->setLimit(limit);
+}
+
+/**
+ * @brief get the number of bytes, which are currently allocated for used and free buffers of
+ *        serialized messages and snapshot-segments
+ *
+ * @return number of allocated bytes
+ */
+uint64_t
+getBufferPoolSize()
+{
+    return BufferPool::getInstance()->getAllocatedSize();
+}
+
+/**
+ * @brief add a client with an own connection to shiori to the pool of clients. As long as no
+ *        client was added, all requests use the default client of the messaging. After the
+ *        first client was added, only the clients of the pool are used, so the default client
+ *        has to be added too, if it should be used further. The requests are distributed over
+ *        the clients, but all segments of a single upload are sent over the same client, so
+ *        the last segment of the upload can not overtake the other segments.
+ *
+ * @param client client with an own connection to shiori
+ *
+ * @return false, if client is invalid, already in the pool or the pool is full, else true
+ */
+bool
+addShioriClient(HanamiMessagingClient* client)
+{
+    return ShioriClientPool::getInstance()->addClient(client);
+}
+
+/**
+ * @brief add an own implementation of a connection to shiori to the pool of clients, for example
+ *        an in-process endpoint to run tests and benchmarks without a running shiori. It is
+ *        handled like a client, which was added with addShioriClient.
+ *
+ * @param connection connection to shiori, which must exist as long as the library is used
+ *
+ * @return false, if connection is invalid, already in the pool or the pool is full, else true
+ */
+bool
+addShioriConnection(ShioriConnection* connection)
+{
+    return ShioriClientPool::getInstance()->addConnection(connection);
+}
+
+/**
+ * @brief set how the client for a request is selected from the pool of clients
+ *
+ * @param selection ROUND_ROBIN_SELECTION to use the clients one after another, or
+ *                  LEAST_LOADED_SELECTION to use the client with the fewest running requests
+ */
+void
+setShioriClientSelection(const ClientSelection selection)
+{
+    ShioriClientPool::getInstance()->setSelection(selection);
 }
 
 }
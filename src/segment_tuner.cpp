@@ -0,0 +1,165 @@
+/**
+ * @file        segment_tuner.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <segment_tuner.h>
+
+#include <algorithm>
+
+namespace Shiori
+{
+
+// number of segments, which are measured, before the segment-size is adjusted
+const uint64_t MEASUREMENT_WINDOW = 16;
+
+// a change of the throughput below this factor is handled as noise
+const double THROUGHPUT_TOLERANCE = 0.05;
+
+/**
+ * @brief constructor
+ */
+SegmentTuner::SegmentTuner() {}
+
+/**
+ * @brief get instance of the tuner
+ *
+ * @return pointer to the static instance
+ */
+SegmentTuner*
+SegmentTuner::getInstance()
+{
+    static SegmentTuner* instance = new SegmentTuner();
+    return instance;
+}
+
+/**
+ * @brief configure segment-size
+ *
+ * @param initialSize segment-size to start with
+ * @param minSize minimal segment-size in adaptive mode
+ * @param maxSize maximal segment-size in adaptive mode, which must leave space for the
+ *                header-fields within a single stream-message
+ * @param adaptive true to adjust the segment-size based on the measured throughput
+ *
+ * @return false, if the sizes are invalid, else true
+ */
+bool
+SegmentTuner::configure(const uint64_t initialSize,
+                        const uint64_t minSize,
+                        const uint64_t maxSize,
+                        const bool adaptive)
+{
+    if(minSize == 0
+            || minSize > maxSize
+            || maxSize > MAX_STREAM_MESSAGE_SIZE - SEGMENT_HEADER_RESERVE
+            || initialSize < minSize
+            || initialSize > maxSize)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_segmentSize = initialSize;
+    m_minSize = minSize;
+    m_maxSize = maxSize;
+    m_adaptive = adaptive;
+
+    m_numberOfMeasurements = 0;
+    m_bytes = 0;
+    m_durationNs = 0;
+    m_lastThroughput = 0.0;
+    m_growing = true;
+
+    return true;
+}
+
+/**
+ * @brief get current segment-size
+ *
+ * @return segment-size in bytes
+ */
+uint64_t
+SegmentTuner::getSegmentSize()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_segmentSize;
+}
+
+/**
+ * @brief get maximum segment-size, which is necessary for the size of the send-buffers
+ *
+ * @return maximum segment-size in bytes
+ */
+uint64_t
+SegmentTuner::getMaxSegmentSize()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_maxSize;
+}
+
+/**
+ * @brief add measurement of a sent segment. After each window of measurements, the segment-size
+ *        is doubled or halved. The direction is kept as long as the throughput increases and
+ *        reversed, when it decreases.
+ *
+ * @param segmentSize size of the sent segment
+ * @param durationNs time in nanoseconds to send the segment
+ */
+void
+SegmentTuner::addMeasurement(const uint64_t segmentSize,
+                             const uint64_t durationNs)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_adaptive == false) {
+        return;
+    }
+
+    m_numberOfMeasurements++;
+    m_bytes += segmentSize;
+    m_durationNs += std::max(durationNs, static_cast<uint64_t>(1));
+    if(m_numberOfMeasurements < MEASUREMENT_WINDOW) {
+        return;
+    }
+
+    const double throughput = static_cast<double>(m_bytes) / static_cast<double>(m_durationNs);
+    m_numberOfMeasurements = 0;
+    m_bytes = 0;
+    m_durationNs = 0;
+
+    // reverse direction, if the last change made it worse
+    if(m_lastThroughput > 0.0
+            && throughput < m_lastThroughput * (1.0 - THROUGHPUT_TOLERANCE))
+    {
+        m_growing = !m_growing;
+    }
+    m_lastThroughput = throughput;
+
+    if(m_growing) {
+        m_segmentSize = std::min(m_segmentSize * 2, m_maxSize);
+    }
+    else {
+        m_segmentSize = std::max(m_segmentSize / 2, m_minSize);
+    }
+}
+
+}
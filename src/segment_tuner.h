@@ -0,0 +1,72 @@
+/**
+ * @file        segment_tuner.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef KITSUNEMIMI_HANAMI_SHIORI_SEGMENT_TUNER_H
+#define KITSUNEMIMI_HANAMI_SHIORI_SEGMENT_TUNER_H
+
+#include <stdint.h>
+#include <mutex>
+
+namespace Shiori
+{
+
+// additional space in the send-buffer for the header-fields of a segment
+const uint64_t SEGMENT_HEADER_RESERVE = 4 * 1024;
+
+// maximum size of a single stream-message of the messaging to shiori
+const uint64_t MAX_STREAM_MESSAGE_SIZE = 128 * 1024;
+
+class SegmentTuner
+{
+public:
+    static SegmentTuner* getInstance();
+
+    bool configure(const uint64_t initialSize,
+                   const uint64_t minSize,
+                   const uint64_t maxSize,
+                   const bool adaptive);
+
+    uint64_t getSegmentSize();
+    uint64_t getMaxSegmentSize();
+    void addMeasurement(const uint64_t segmentSize, const uint64_t durationNs);
+
+private:
+    SegmentTuner();
+
+    std::mutex m_lock;
+    uint64_t m_segmentSize = 96 * 1024;
+    uint64_t m_minSize = 96 * 1024;
+    uint64_t m_maxSize = 96 * 1024;
+    bool m_adaptive = false;
+
+    // measurements of the current window
+    uint64_t m_numberOfMeasurements = 0;
+    uint64_t m_bytes = 0;
+    uint64_t m_durationNs = 0;
+
+    double m_lastThroughput = 0.0;
+    bool m_growing = true;
+};
+
+}
+
+#endif // KITSUNEMIMI_HANAMI_SHIORI_SEGMENT_TUNER_H
@@ -0,0 +1,552 @@
+/**
+ * @file        snapshot_compression.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <libShioriArchive/snapshot_compression.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+namespace Shiori
+{
+
+// header at the beginning of a compressed snapshot, followed by the frames
+struct CompressedSnapshotHeader
+{
+    uint64_t magic = 0;
+    uint32_t compression = NO_COMPRESSION;
+    uint32_t frameSize = 0;
+    uint64_t rawSize = 0;
+    uint64_t numberOfFrames = 0;
+};
+
+// header of a single frame, which contains up to frameSize bytes of the original snapshot
+struct FrameHeader
+{
+    uint32_t rawSize = 0;
+    uint32_t storedSize = 0;
+    uint32_t isCompressed = 0;
+    uint32_t padding = 0;
+};
+
+// position of a frame within the compressed and the original snapshot
+struct FramePosition
+{
+    FrameHeader header;
+    uint64_t inputPos = 0;
+    uint64_t targetPos = 0;
+};
+
+const uint64_t COMPRESSED_SNAPSHOT_MAGIC = 0x31504d434f494853;  // "SHIOCMP1"
+const uint32_t COMPRESSION_FRAME_SIZE = 1024*1024;
+const int ZSTD_COMPRESSION_LEVEL = 3;
+
+/**
+ * @brief get name of a compression-type, like it is written into the snapshot-header
+ *
+ * @param compression compression-type
+ *
+ * @return name of the compression
+ */
+const std::string
+getCompressionName(const SnapshotCompression compression)
+{
+    if(compression == LZ4_COMPRESSION) {
+        return "lz4";
+    }
+    if(compression == ZSTD_COMPRESSION) {
+        return "zstd";
+    }
+
+    return "none";
+}
+
+/**
+ * @brief get compression-type by its name, like it is written into the snapshot-header
+ *
+ * @param compression reference for the resulting compression-type
+ * @param name name of the compression
+ *
+ * @return false, if the name is unknown, else true
+ */
+bool
+getCompressionType(SnapshotCompression &compression,
+                   const std::string &name)
+{
+    if(name == "lz4")
+    {
+        compression = LZ4_COMPRESSION;
+        return true;
+    }
+    if(name == "zstd")
+    {
+        compression = ZSTD_COMPRESSION;
+        return true;
+    }
+    if(name == "none"
+            || name == "")
+    {
+        compression = NO_COMPRESSION;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief create new data-buffer, which is big enough for the given number of bytes
+ *
+ * @param size number of bytes
+ *
+ * @return pointer to new data-buffer
+ */
+static Kitsunemimi::DataBuffer*
+createBuffer(const uint64_t size)
+{
+    const uint64_t numberOfBlocks = (size / 4096) + 1;
+    return new Kitsunemimi::DataBuffer(numberOfBlocks);
+}
+
+/**
+ * @brief compress a single frame
+ *
+ * @param target target-buffer
+ * @param targetSize size of the target-buffer
+ * @param source data to compress
+ * @param sourceSize number of bytes to compress
+ * @param compression compression-type
+ *
+ * @return number of compressed bytes, or 0 if compression failed
+ */
+static uint64_t
+compressFrame(uint8_t* target,
+              const uint64_t targetSize,
+              const uint8_t* source,
+              const uint64_t sourceSize,
+              const SnapshotCompression compression)
+{
+    if(compression == LZ4_COMPRESSION)
+    {
+        const int ret = LZ4_compress_default(reinterpret_cast<const char*>(source),
+                                             reinterpret_cast<char*>(target),
+                                             static_cast<int>(sourceSize),
+                                             static_cast<int>(targetSize));
+        return ret > 0 ? static_cast<uint64_t>(ret) : 0;
+    }
+
+    if(compression == ZSTD_COMPRESSION)
+    {
+        const size_t ret = ZSTD_compress(target,
+                                         targetSize,
+                                         source,
+                                         sourceSize,
+                                         ZSTD_COMPRESSION_LEVEL);
+        return ZSTD_isError(ret) ? 0 : ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief decompress a single frame
+ *
+ * @param target target-buffer
+ * @param targetSize expected number of decompressed bytes
+ * @param source compressed data
+ * @param sourceSize number of compressed bytes
+ * @param compression compression-type
+ *
+ * @return true, if successful, else false
+ */
+static bool
+decompressFrame(uint8_t* target,
+                const uint64_t targetSize,
+                const uint8_t* source,
+                const uint64_t sourceSize,
+                const SnapshotCompression compression)
+{
+    if(compression == LZ4_COMPRESSION)
+    {
+        const int ret = LZ4_decompress_safe(reinterpret_cast<const char*>(source),
+                                            reinterpret_cast<char*>(target),
+                                            static_cast<int>(sourceSize),
+                                            static_cast<int>(targetSize));
+        return ret >= 0 && static_cast<uint64_t>(ret) == targetSize;
+    }
+
+    if(compression == ZSTD_COMPRESSION)
+    {
+        const size_t ret = ZSTD_decompress(target, targetSize, source, sourceSize);
+        return ZSTD_isError(ret) == false && ret == targetSize;
+    }
+
+    return false;
+}
+
+/**
+ * @brief compress a snapshot. The snapshot is split into frames, which are compressed
+ *        independently. Frames, which can not be compressed, are stored uncompressed.
+ *
+ * @param input data of the snapshot
+ * @param compression compression-type
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the compressed snapshot, if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+compressSnapshot(const Kitsunemimi::DataBuffer &input,
+                 const SnapshotCompression compression,
+                 Kitsunemimi::ErrorContainer &error)
+{
+    if(compression != LZ4_COMPRESSION
+            && compression != ZSTD_COMPRESSION)
+    {
+        error.addMeesage("Invalid compression-type for snapshot");
+        return nullptr;
+    }
+
+    const uint8_t* u8Input = static_cast<const uint8_t*>(input.data);
+    const uint64_t rawSize = input.usedBufferSize;
+    const uint64_t numberOfFrames = (rawSize + COMPRESSION_FRAME_SIZE - 1) / COMPRESSION_FRAME_SIZE;
+
+    // in worst case, all frames are stored uncompressed
+    const uint64_t maxSize = sizeof(CompressedSnapshotHeader)
+                             + numberOfFrames * sizeof(FrameHeader)
+                             + rawSize;
+    Kitsunemimi::DataBuffer* result = createBuffer(maxSize);
+    uint8_t* u8Result = static_cast<uint8_t*>(result->data);
+
+    CompressedSnapshotHeader header;
+    header.magic = COMPRESSED_SNAPSHOT_MAGIC;
+    header.compression = compression;
+    header.frameSize = COMPRESSION_FRAME_SIZE;
+    header.rawSize = rawSize;
+    header.numberOfFrames = numberOfFrames;
+    memcpy(u8Result, &header, sizeof(CompressedSnapshotHeader));
+    uint64_t pos = sizeof(CompressedSnapshotHeader);
+
+    for(uint64_t i = 0; i < numberOfFrames; i++)
+    {
+        const uint64_t offset = i * COMPRESSION_FRAME_SIZE;
+        const uint64_t frameRawSize = std::min(static_cast<uint64_t>(COMPRESSION_FRAME_SIZE),
+                                               rawSize - offset);
+
+        FrameHeader frameHeader;
+        frameHeader.rawSize = static_cast<uint32_t>(frameRawSize);
+        uint8_t* frameData = &u8Result[pos + sizeof(FrameHeader)];
+
+        // the compressed frame must be smaller than the raw frame, else it is stored raw
+        const uint64_t compressedSize = compressFrame(frameData,
+                                                      frameRawSize,
+                                                      &u8Input[offset],
+                                                      frameRawSize,
+                                                      compression);
+        if(compressedSize > 0
+                && compressedSize < frameRawSize)
+        {
+            frameHeader.storedSize = static_cast<uint32_t>(compressedSize);
+            frameHeader.isCompressed = 1;
+        }
+        else
+        {
+            memcpy(frameData, &u8Input[offset], frameRawSize);
+            frameHeader.storedSize = static_cast<uint32_t>(frameRawSize);
+            frameHeader.isCompressed = 0;
+        }
+
+        memcpy(&u8Result[pos], &frameHeader, sizeof(FrameHeader));
+        pos += sizeof(FrameHeader) + frameHeader.storedSize;
+    }
+
+    result->usedBufferSize = pos;
+
+    return result;
+}
+
+/**
+ * @brief check if a buffer contains a compressed snapshot
+ *
+ * @param input buffer to check
+ *
+ * @return true, if compressed, else false
+ */
+bool
+isCompressedSnapshot(const Kitsunemimi::DataBuffer &input)
+{
+    if(input.usedBufferSize < sizeof(CompressedSnapshotHeader)) {
+        return false;
+    }
+
+    uint64_t magic = 0;
+    memcpy(&magic, input.data, sizeof(uint64_t));
+
+    return magic == COMPRESSED_SNAPSHOT_MAGIC;
+}
+
+/**
+ * @brief read the header of a compressed snapshot and check it against the size of the
+ *        buffer, before any value of the header is used for an allocation
+ *
+ * @param header reference for the resulting header
+ * @param input buffer with the compressed snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if the header is valid, else false
+ */
+static bool
+readHeader(CompressedSnapshotHeader &header,
+           const Kitsunemimi::DataBuffer &input,
+           Kitsunemimi::ErrorContainer &error)
+{
+    if(isCompressedSnapshot(input) == false)
+    {
+        error.addMeesage("Snapshot is not compressed");
+        return false;
+    }
+
+    memcpy(&header, input.data, sizeof(CompressedSnapshotHeader));
+
+    if(header.compression != LZ4_COMPRESSION
+            && header.compression != ZSTD_COMPRESSION)
+    {
+        error.addMeesage("Compressed snapshot has unknown compression-type '"
+                         + std::to_string(header.compression) + "'");
+        return false;
+    }
+    if(header.frameSize == 0
+            || header.frameSize > COMPRESSION_FRAME_SIZE)
+    {
+        error.addMeesage("Compressed snapshot has invalid frame-size '"
+                         + std::to_string(header.frameSize) + "'");
+        return false;
+    }
+
+    // each frame needs at least its frame-header within the input and the original snapshot
+    // is split into frames of the frame-size, so the number of frames is limited by the input
+    // and the raw size by the number of frames
+    const uint64_t payloadSize = input.usedBufferSize - sizeof(CompressedSnapshotHeader);
+    const uint64_t expectedFrames = (header.rawSize / header.frameSize)
+                                    + (header.rawSize % header.frameSize != 0);
+    if(header.numberOfFrames > payloadSize / sizeof(FrameHeader)
+            || header.numberOfFrames != expectedFrames)
+    {
+        error.addMeesage("Compressed snapshot has invalid number of frames '"
+                         + std::to_string(header.numberOfFrames) + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get size of the original snapshot
+ *
+ * @param size reference for the size of the original snapshot
+ * @param input buffer with the compressed snapshot
+ * @param error reference for error-output
+ *
+ * @return false, if the buffer doesn't contain a valid compressed snapshot, else true
+ */
+bool
+getDecompressedSize(uint64_t &size,
+                    const Kitsunemimi::DataBuffer &input,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    CompressedSnapshotHeader header;
+    if(readHeader(header, input, error) == false) {
+        return false;
+    }
+
+    size = header.rawSize;
+
+    return true;
+}
+
+/**
+ * @brief decompress a snapshot into an existing buffer. The frames are decompressed by
+ *        multiple threads in parallel.
+ *
+ * @param target pointer to the target-buffer
+ * @param targetSize size of the target-buffer, which must be at least the size of the
+ *                   original snapshot
+ * @param input buffer with the compressed snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+decompressSnapshot(uint8_t* target,
+                   const uint64_t targetSize,
+                   const Kitsunemimi::DataBuffer &input,
+                   Kitsunemimi::ErrorContainer &error)
+{
+    CompressedSnapshotHeader header;
+    if(readHeader(header, input, error) == false) {
+        return false;
+    }
+
+    const uint8_t* u8Input = static_cast<const uint8_t*>(input.data);
+    const uint64_t inputSize = input.usedBufferSize;
+
+    if(header.rawSize > targetSize)
+    {
+        error.addMeesage("Target-buffer is too small for the decompressed snapshot");
+        return false;
+    }
+
+    // collect positions of all frames and check them against the borders of the buffers
+    std::vector<FramePosition> frames;
+    frames.reserve(header.numberOfFrames);
+    uint64_t pos = sizeof(CompressedSnapshotHeader);
+    uint64_t targetPos = 0;
+    for(uint64_t i = 0; i < header.numberOfFrames; i++)
+    {
+        FramePosition frame;
+        if(pos + sizeof(FrameHeader) > inputSize)
+        {
+            error.addMeesage("Compressed snapshot is incomplete");
+            return false;
+        }
+        memcpy(&frame.header, &u8Input[pos], sizeof(FrameHeader));
+        pos += sizeof(FrameHeader);
+        if(pos + frame.header.storedSize > inputSize
+                || frame.header.rawSize > header.frameSize
+                || (frame.header.isCompressed == 0
+                    && frame.header.storedSize != frame.header.rawSize)
+                || targetPos + frame.header.rawSize > header.rawSize)
+        {
+            error.addMeesage("Compressed snapshot is incomplete");
+            return false;
+        }
+
+        frame.inputPos = pos;
+        frame.targetPos = targetPos;
+        frames.push_back(frame);
+
+        pos += frame.header.storedSize;
+        targetPos += frame.header.rawSize;
+    }
+
+    if(targetPos != header.rawSize)
+    {
+        error.addMeesage("Compressed snapshot is incomplete");
+        return false;
+    }
+
+    // decompress frames
+    std::atomic<uint64_t> nextFrame(0);
+    std::atomic<int64_t> failedFrame(-1);
+    const SnapshotCompression compression = static_cast<SnapshotCompression>(header.compression);
+
+    auto worker = [&]()
+    {
+        while(failedFrame == -1)
+        {
+            const uint64_t i = nextFrame.fetch_add(1);
+            if(i >= frames.size()) {
+                return;
+            }
+
+            const FramePosition* frame = &frames[i];
+            if(frame->header.isCompressed == 0)
+            {
+                memcpy(&target[frame->targetPos],
+                       &u8Input[frame->inputPos],
+                       frame->header.rawSize);
+            }
+            else if(decompressFrame(&target[frame->targetPos],
+                                    frame->header.rawSize,
+                                    &u8Input[frame->inputPos],
+                                    frame->header.storedSize,
+                                    compression) == false)
+            {
+                failedFrame = static_cast<int64_t>(i);
+            }
+        }
+    };
+
+    const uint64_t numberOfThreads = std::min(
+                static_cast<uint64_t>(std::max(std::thread::hardware_concurrency(), 1u)),
+                static_cast<uint64_t>(frames.size()));
+    std::vector<std::thread> threads;
+    for(uint64_t i = 1; i < numberOfThreads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    if(failedFrame != -1)
+    {
+        error.addMeesage("Failed to decompress frame '" + std::to_string(failedFrame)
+                         + "' of snapshot");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief decompress a snapshot
+ *
+ * @param input buffer with the compressed snapshot
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the original snapshot, if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+decompressSnapshot(const Kitsunemimi::DataBuffer &input,
+                   Kitsunemimi::ErrorContainer &error)
+{
+    uint64_t rawSize = 0;
+    if(getDecompressedSize(rawSize, input, error) == false) {
+        return nullptr;
+    }
+
+    Kitsunemimi::DataBuffer* result = createBuffer(rawSize);
+    if(result->data == nullptr)
+    {
+        error.addMeesage("Failed to allocate '" + std::to_string(rawSize)
+                         + "' bytes for the decompressed snapshot");
+        delete result;
+        return nullptr;
+    }
+    if(decompressSnapshot(static_cast<uint8_t*>(result->data), rawSize, input, error) == false)
+    {
+        delete result;
+        return nullptr;
+    }
+
+    result->usedBufferSize = rawSize;
+
+    return result;
+}
+
+}
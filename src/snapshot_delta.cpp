@@ -0,0 +1,685 @@
+/**
+ * @file        snapshot_delta.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <libShioriArchive/snapshot_delta.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#include <openssl/sha.h>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+namespace Shiori
+{
+
+// header at the beginning of a delta-snapshot, followed by the location of the parent
+// and the operations to rebuild the snapshot
+struct DeltaSnapshotHeader
+{
+    uint64_t magic = 0;
+    uint64_t rawSize = 0;
+    uint64_t parentSize = 0;
+    uint32_t locationSize = 0;
+    // encoding of the stored parent, because the parent is requested only by its location
+    uint8_t parentCompression = NO_COMPRESSION;
+    uint8_t parentIsDelta = 0;
+    uint16_t padding = 0;
+    uint64_t numberOfOperations = 0;
+};
+
+enum DeltaOperationType
+{
+    // copy bytes from the parent-snapshot
+    COPY_OPERATION = 0,
+    // bytes are stored directly behind the operation
+    DATA_OPERATION = 1,
+};
+
+struct DeltaOperation
+{
+    uint32_t type = COPY_OPERATION;
+    uint32_t padding = 0;
+    uint64_t position = 0;
+    uint64_t size = 0;
+};
+
+const uint64_t DELTA_SNAPSHOT_MAGIC = 0x31544c444f494853;  // "SHIODLT1"
+
+// borders of the content-defined chunks
+const uint64_t MIN_CHUNK_SIZE = 2 * 1024;
+const uint64_t MAX_CHUNK_SIZE = 64 * 1024;
+// a border is found, if the upper 13 bits of the hash are zero, so ~8 KiB on average
+const uint64_t CHUNK_BORDER_SHIFT = 64 - 13;
+
+// below this size the hashes of the chunks are calculated by a single thread
+const uint64_t PARALLEL_HASH_LIMIT = 4 * 1024 * 1024;
+
+/**
+ * @brief get table with random values for the gear-hash. The table is generated with a fixed
+ *        seed, because the chunk-borders must be the same for all versions of the library.
+ *
+ * @return pointer to the table
+ */
+static const uint64_t*
+getGearTable()
+{
+    static const std::vector<uint64_t> table = []()
+    {
+        std::vector<uint64_t> values(256);
+        uint64_t state = 0x5348494f52494745;
+        for(uint64_t i = 0; i < 256; i++)
+        {
+            // splitmix64
+            state += 0x9e3779b97f4a7c15;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            values[i] = z ^ (z >> 31);
+        }
+        return values;
+    }();
+
+    return &table[0];
+}
+
+/**
+ * @brief search the end of the next chunk. The border depends only on the content, so an
+ *        insertion or deletion of bytes moves only the borders of the affected chunks.
+ *
+ * @param data pointer to the data
+ * @param size number of bytes behind the pointer
+ *
+ * @return size of the next chunk
+ */
+static uint64_t
+findChunkBorder(const uint8_t* data,
+                const uint64_t size)
+{
+    if(size <= MIN_CHUNK_SIZE) {
+        return size;
+    }
+
+    const uint64_t* gear = getGearTable();
+    const uint64_t end = std::min(size, MAX_CHUNK_SIZE);
+    uint64_t hash = 0;
+
+    for(uint64_t i = MIN_CHUNK_SIZE; i < end; i++)
+    {
+        hash = (hash << 1) + gear[data[i]];
+        if((hash >> CHUNK_BORDER_SHIFT) == 0) {
+            return i + 1;
+        }
+    }
+
+    return end;
+}
+
+/**
+ * @brief calculate the sha256-hashes of a range of chunks
+ *
+ * @param chunks list of chunks
+ * @param data pointer to the data of the chunks
+ * @param begin index of the first chunk
+ * @param end index behind the last chunk
+ */
+static void
+hashChunks(std::vector<SnapshotChunk> &chunks,
+           const uint8_t* data,
+           const uint64_t begin,
+           const uint64_t end)
+{
+    for(uint64_t i = begin; i < end; i++)
+    {
+        SnapshotChunk* chunk = &chunks[i];
+        SHA256(&data[chunk->position], chunk->size, chunk->hash);
+    }
+}
+
+/**
+ * @brief split a snapshot into content-defined chunks and calculate the hash of each chunk
+ *
+ * @param manifest reference for the resulting list of chunks
+ * @param input data of the snapshot
+ */
+void
+createSnapshotManifest(SnapshotManifest &manifest,
+                       const Kitsunemimi::DataBuffer &input)
+{
+    const uint8_t* u8Input = static_cast<const uint8_t*>(input.data);
+    const uint64_t inputSize = input.usedBufferSize;
+
+    manifest.totalSize = inputSize;
+    manifest.chainLength = 0;
+    manifest.chunks.clear();
+
+    // search chunk-borders
+    uint64_t pos = 0;
+    while(pos < inputSize)
+    {
+        SnapshotChunk chunk;
+        chunk.position = pos;
+        chunk.size = findChunkBorder(&u8Input[pos], inputSize - pos);
+        manifest.chunks.push_back(chunk);
+        pos += chunk.size;
+    }
+
+    // hash chunks, for bigger snapshots split over multiple threads
+    const uint64_t numberOfChunks = manifest.chunks.size();
+    uint64_t numberOfThreads = 1;
+    if(inputSize >= PARALLEL_HASH_LIMIT) {
+        numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    numberOfThreads = std::min(numberOfThreads, std::max(numberOfChunks, static_cast<uint64_t>(1)));
+
+    if(numberOfThreads == 1)
+    {
+        hashChunks(manifest.chunks, u8Input, 0, numberOfChunks);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    const uint64_t chunksPerThread = (numberOfChunks + numberOfThreads - 1) / numberOfThreads;
+    for(uint64_t i = 0; i < numberOfThreads; i++)
+    {
+        const uint64_t begin = i * chunksPerThread;
+        const uint64_t end = std::min(begin + chunksPerThread, numberOfChunks);
+        if(begin >= end) {
+            break;
+        }
+        threads.emplace_back(hashChunks, std::ref(manifest.chunks), u8Input, begin, end);
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief add a new operation to the delta-snapshot. A copy-operation is merged with the
+ *        previous one, if both cover consecutive bytes of the parent.
+ *
+ * @param operations list of operations
+ * @param type type of the new operation
+ * @param position position in the parent for copy-operations or in the input for
+ *                 data-operations
+ * @param size number of bytes
+ */
+static void
+addOperation(std::vector<DeltaOperation> &operations,
+             const DeltaOperationType type,
+             const uint64_t position,
+             const uint64_t size)
+{
+    if(operations.size() > 0)
+    {
+        DeltaOperation* last = &operations.back();
+        if(last->type == type
+                && last->position + last->size == position)
+        {
+            last->size += size;
+            return;
+        }
+    }
+
+    DeltaOperation operation;
+    operation.type = type;
+    operation.position = position;
+    operation.size = size;
+    operations.push_back(operation);
+}
+
+/**
+ * @brief check if the next snapshot has to be uploaded as full snapshot, because the chain of
+ *        delta-snapshots behind the parent has already reached the maximum length
+ *
+ * @param parentManifest manifest of the parent-snapshot
+ *
+ * @return true, if a full snapshot is necessary, else false
+ */
+bool
+needsFullSnapshot(const SnapshotManifest &parentManifest)
+{
+    return parentManifest.chainLength >= MAX_DELTA_CHAIN_LENGTH;
+}
+
+/**
+ * @brief create a delta-snapshot, which contains only the chunks, which don't exist within the
+ *        parent-snapshot, and references to the parent for all other chunks
+ *
+ * @param manifest reference for the manifest of the input, which can be used as parent-manifest
+ *                 for the next delta-snapshot, after its location and encoding are set
+ * @param input data of the new snapshot
+ * @param parentManifest manifest of the parent-snapshot, which is already stored in shiori
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the delta-snapshot, if successful, else nullptr, which is
+ *         also the case, if the chain behind the parent is too long for another delta
+ */
+Kitsunemimi::DataBuffer*
+createDeltaSnapshot(SnapshotManifest &manifest,
+                    const Kitsunemimi::DataBuffer &input,
+                    const SnapshotManifest &parentManifest,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    if(parentManifest.location == "")
+    {
+        error.addMeesage("Manifest of the parent-snapshot has no location");
+        error.addSolution("Set the location of the parent-snapshot within shiori "
+                          "in the manifest");
+        return nullptr;
+    }
+    if(needsFullSnapshot(parentManifest))
+    {
+        error.addMeesage("Chain of delta-snapshots behind the parent has already the maximum "
+                         "length of '" + std::to_string(MAX_DELTA_CHAIN_LENGTH) + "'");
+        error.addSolution("Upload the snapshot as full snapshot, which can be used as new "
+                          "parent for the next delta-snapshots");
+        return nullptr;
+    }
+
+    const uint8_t* u8Input = static_cast<const uint8_t*>(input.data);
+    createSnapshotManifest(manifest, input);
+    manifest.chainLength = parentManifest.chainLength + 1;
+
+    // index chunks of the parent by the beginning of their hash
+    std::unordered_map<uint64_t, const SnapshotChunk*> parentChunks;
+    parentChunks.reserve(parentManifest.chunks.size());
+    for(const SnapshotChunk &chunk : parentManifest.chunks)
+    {
+        uint64_t key = 0;
+        memcpy(&key, chunk.hash, sizeof(uint64_t));
+        parentChunks.emplace(key, &chunk);
+    }
+
+    // compare chunks with the parent
+    std::vector<DeltaOperation> operations;
+    uint64_t dataSize = 0;
+    for(const SnapshotChunk &chunk : manifest.chunks)
+    {
+        uint64_t key = 0;
+        memcpy(&key, chunk.hash, sizeof(uint64_t));
+        const auto it = parentChunks.find(key);
+
+        if(it != parentChunks.end()
+                && it->second->size == chunk.size
+                && memcmp(it->second->hash, chunk.hash, sizeof(chunk.hash)) == 0)
+        {
+            addOperation(operations, COPY_OPERATION, it->second->position, chunk.size);
+        }
+        else
+        {
+            addOperation(operations, DATA_OPERATION, chunk.position, chunk.size);
+            dataSize += chunk.size;
+        }
+    }
+
+    // create delta-snapshot
+    const uint64_t deltaSize = sizeof(DeltaSnapshotHeader)
+                               + parentManifest.location.size()
+                               + operations.size() * sizeof(DeltaOperation)
+                               + dataSize;
+    Kitsunemimi::DataBuffer* result = new Kitsunemimi::DataBuffer((deltaSize / 4096) + 1);
+    uint8_t* u8Result = static_cast<uint8_t*>(result->data);
+
+    DeltaSnapshotHeader header;
+    header.magic = DELTA_SNAPSHOT_MAGIC;
+    header.rawSize = input.usedBufferSize;
+    header.parentSize = parentManifest.totalSize;
+    header.locationSize = static_cast<uint32_t>(parentManifest.location.size());
+    header.parentCompression = static_cast<uint8_t>(parentManifest.encoding.compression);
+    header.parentIsDelta = parentManifest.encoding.isDelta;
+    header.numberOfOperations = operations.size();
+    memcpy(u8Result, &header, sizeof(DeltaSnapshotHeader));
+    uint64_t pos = sizeof(DeltaSnapshotHeader);
+
+    memcpy(&u8Result[pos], parentManifest.location.c_str(), header.locationSize);
+    pos += header.locationSize;
+
+    for(const DeltaOperation &operation : operations)
+    {
+        memcpy(&u8Result[pos], &operation, sizeof(DeltaOperation));
+        pos += sizeof(DeltaOperation);
+
+        if(operation.type == DATA_OPERATION)
+        {
+            memcpy(&u8Result[pos], &u8Input[operation.position], operation.size);
+            pos += operation.size;
+        }
+    }
+
+    result->usedBufferSize = pos;
+
+    return result;
+}
+
+/**
+ * @brief check if a buffer contains a delta-snapshot
+ *
+ * @param input buffer to check
+ *
+ * @return true, if delta-snapshot, else false
+ */
+bool
+isDeltaSnapshot(const Kitsunemimi::DataBuffer &input)
+{
+    if(input.usedBufferSize < sizeof(DeltaSnapshotHeader)) {
+        return false;
+    }
+
+    uint64_t magic = 0;
+    memcpy(&magic, input.data, sizeof(uint64_t));
+
+    return magic == DELTA_SNAPSHOT_MAGIC;
+}
+
+/**
+ * @brief read the header of a delta-snapshot and check it together with all operations against
+ *        the size of the buffer and the parent, before any value of the header is used for an
+ *        allocation. The operations are only read here and not applied.
+ *
+ * @param header reference for the resulting header
+ * @param input buffer with the delta-snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if the header and the operations are valid, else false
+ */
+static bool
+readDeltaHeader(DeltaSnapshotHeader &header,
+                const Kitsunemimi::DataBuffer &input,
+                Kitsunemimi::ErrorContainer &error)
+{
+    if(isDeltaSnapshot(input) == false)
+    {
+        error.addMeesage("Snapshot is not a delta-snapshot");
+        return false;
+    }
+
+    const uint8_t* u8Input = static_cast<const uint8_t*>(input.data);
+    const uint64_t inputSize = input.usedBufferSize;
+    memcpy(&header, u8Input, sizeof(DeltaSnapshotHeader));
+
+    if(header.locationSize > inputSize - sizeof(DeltaSnapshotHeader)
+            || header.parentCompression > ZSTD_COMPRESSION)
+    {
+        error.addMeesage("Delta-snapshot has invalid parent-information");
+        return false;
+    }
+
+    // each operation needs at least its own header within the input
+    uint64_t pos = sizeof(DeltaSnapshotHeader) + header.locationSize;
+    if(header.numberOfOperations > (inputSize - pos) / sizeof(DeltaOperation))
+    {
+        error.addMeesage("Delta-snapshot has invalid number of operations '"
+                         + std::to_string(header.numberOfOperations) + "'");
+        return false;
+    }
+
+    // the operations must exactly fill the raw size, where each operation has to stay within
+    // the parent or the input
+    uint64_t rawSize = 0;
+    for(uint64_t i = 0; i < header.numberOfOperations; i++)
+    {
+        DeltaOperation operation;
+        if(sizeof(DeltaOperation) > inputSize - pos)
+        {
+            error.addMeesage("Delta-snapshot is incomplete");
+            return false;
+        }
+        memcpy(&operation, &u8Input[pos], sizeof(DeltaOperation));
+        pos += sizeof(DeltaOperation);
+
+        if(operation.type == COPY_OPERATION)
+        {
+            if(operation.position > header.parentSize
+                    || operation.size > header.parentSize - operation.position)
+            {
+                error.addMeesage("Delta-snapshot references data outside of the parent");
+                return false;
+            }
+        }
+        else if(operation.type == DATA_OPERATION)
+        {
+            if(operation.size > inputSize - pos)
+            {
+                error.addMeesage("Delta-snapshot is incomplete");
+                return false;
+            }
+            pos += operation.size;
+        }
+        else
+        {
+            error.addMeesage("Delta-snapshot has unknown operation-type '"
+                             + std::to_string(operation.type) + "'");
+            return false;
+        }
+
+        if(operation.size > header.rawSize - rawSize)
+        {
+            error.addMeesage("Operations of the delta-snapshot exceed its size");
+            return false;
+        }
+        rawSize += operation.size;
+    }
+
+    if(rawSize != header.rawSize)
+    {
+        error.addMeesage("Delta-snapshot is incomplete");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get size of the snapshot, which is rebuilt out of a delta-snapshot
+ *
+ * @param size reference for the size of the rebuilt snapshot
+ * @param input buffer with the delta-snapshot
+ * @param error reference for error-output
+ *
+ * @return false, if the buffer doesn't contain a valid delta-snapshot, else true
+ */
+bool
+getDeltaSnapshotSize(uint64_t &size,
+                     const Kitsunemimi::DataBuffer &input,
+                     Kitsunemimi::ErrorContainer &error)
+{
+    DeltaSnapshotHeader header;
+    if(readDeltaHeader(header, input, error) == false) {
+        return false;
+    }
+
+    size = header.rawSize;
+
+    return true;
+}
+
+/**
+ * @brief get location, encoding and size of the parent-snapshot of a delta-snapshot
+ *
+ * @param location reference for the resulting location
+ * @param encoding reference for the resulting encoding of the stored parent
+ * @param parentSize reference for the size of the restored parent
+ * @param input buffer with the delta-snapshot
+ *
+ * @return false, if input is not a valid delta-snapshot, else true
+ */
+bool
+getDeltaParent(std::string &location,
+               SnapshotEncoding &encoding,
+               uint64_t &parentSize,
+               const Kitsunemimi::DataBuffer &input)
+{
+    if(isDeltaSnapshot(input) == false) {
+        return false;
+    }
+
+    const uint8_t* u8Input = static_cast<const uint8_t*>(input.data);
+    DeltaSnapshotHeader header;
+    memcpy(&header, u8Input, sizeof(DeltaSnapshotHeader));
+    if(sizeof(DeltaSnapshotHeader) + header.locationSize > input.usedBufferSize
+            || header.parentCompression > ZSTD_COMPRESSION)
+    {
+        return false;
+    }
+
+    encoding.compression = static_cast<SnapshotCompression>(header.parentCompression);
+    encoding.isDelta = header.parentIsDelta != 0;
+    parentSize = header.parentSize;
+
+    const uint64_t pos = sizeof(DeltaSnapshotHeader);
+    location = std::string(reinterpret_cast<const char*>(&u8Input[pos]), header.locationSize);
+
+    return true;
+}
+
+/**
+ * @brief rebuild the original snapshot out of a delta-snapshot and its parent into an
+ *        existing buffer
+ *
+ * @param target pointer to the target-buffer
+ * @param targetSize size of the target-buffer, which must be at least the size of the
+ *                   rebuilt snapshot
+ * @param delta buffer with the delta-snapshot
+ * @param parent buffer with the complete data of the parent-snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+applyDeltaSnapshot(uint8_t* target,
+                   const uint64_t targetSize,
+                   const Kitsunemimi::DataBuffer &delta,
+                   const Kitsunemimi::DataBuffer &parent,
+                   Kitsunemimi::ErrorContainer &error)
+{
+    DeltaSnapshotHeader header;
+    if(readDeltaHeader(header, delta, error) == false) {
+        return false;
+    }
+
+    const uint8_t* u8Delta = static_cast<const uint8_t*>(delta.data);
+    const uint8_t* u8Parent = static_cast<const uint8_t*>(parent.data);
+    const uint64_t deltaSize = delta.usedBufferSize;
+
+    if(header.parentSize != parent.usedBufferSize)
+    {
+        error.addMeesage("Size of the parent doesn't match the parent of the delta-snapshot");
+        return false;
+    }
+    if(header.rawSize > targetSize)
+    {
+        error.addMeesage("Target-buffer is too small for the rebuilt snapshot");
+        return false;
+    }
+
+    uint64_t pos = sizeof(DeltaSnapshotHeader) + header.locationSize;
+    uint64_t targetPos = 0;
+    for(uint64_t i = 0; i < header.numberOfOperations; i++)
+    {
+        // check operation against the borders of the buffers
+        DeltaOperation operation;
+        if(sizeof(DeltaOperation) > deltaSize - pos)
+        {
+            error.addMeesage("Delta-snapshot is incomplete");
+            return false;
+        }
+        memcpy(&operation, &u8Delta[pos], sizeof(DeltaOperation));
+        pos += sizeof(DeltaOperation);
+        if(operation.size > header.rawSize - targetPos)
+        {
+            error.addMeesage("Delta-snapshot is incomplete");
+            return false;
+        }
+
+        if(operation.type == COPY_OPERATION)
+        {
+            if(operation.position > parent.usedBufferSize
+                    || operation.size > parent.usedBufferSize - operation.position)
+            {
+                error.addMeesage("Delta-snapshot references data outside of the parent");
+                return false;
+            }
+            memcpy(&target[targetPos], &u8Parent[operation.position], operation.size);
+        }
+        else
+        {
+            if(operation.size > deltaSize - pos)
+            {
+                error.addMeesage("Delta-snapshot is incomplete");
+                return false;
+            }
+            memcpy(&target[targetPos], &u8Delta[pos], operation.size);
+            pos += operation.size;
+        }
+
+        targetPos += operation.size;
+    }
+
+    if(targetPos != header.rawSize)
+    {
+        error.addMeesage("Delta-snapshot is incomplete");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief rebuild the original snapshot out of a delta-snapshot and its parent
+ *
+ * @param delta buffer with the delta-snapshot
+ * @param parent buffer with the complete data of the parent-snapshot
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the original snapshot, if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+applyDeltaSnapshot(const Kitsunemimi::DataBuffer &delta,
+                   const Kitsunemimi::DataBuffer &parent,
+                   Kitsunemimi::ErrorContainer &error)
+{
+    // the raw size is checked against the operations, before it is used for the allocation
+    uint64_t rawSize = 0;
+    if(getDeltaSnapshotSize(rawSize, delta, error) == false) {
+        return nullptr;
+    }
+
+    Kitsunemimi::DataBuffer* result = new Kitsunemimi::DataBuffer((rawSize / 4096) + 1);
+    if(applyDeltaSnapshot(static_cast<uint8_t*>(result->data),
+                          rawSize,
+                          delta,
+                          parent,
+                          error) == false)
+    {
+        delete result;
+        return nullptr;
+    }
+
+    result->usedBufferSize = rawSize;
+
+    return result;
+}
+
+}
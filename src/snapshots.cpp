@@ -21,6 +21,25 @@
  */
 
 #include <libShioriArchive/snapshots.h>
+#include <libShioriArchive/metadata_cache.h>
+
+#include <buffer_pool.h>
+#include <client_pool.h>
+#include <crc32c.h>
+#include <json_helper.h>
+#include <metrics_collector.h>
+#include <segment_tuner.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <libKitsunemimiCommon/buffer/data_buffer.h>
 #include <libKitsunemimiJson/json_item.h>
@@ -32,45 +51,597 @@
 #include <../../libKitsunemimiHanamiMessages/protobuffers/shiori_messages.proto3.pb.h>
 #include <../../libKitsunemimiHanamiMessages/message_sub_types.h>
 
-using Kitsunemimi::Hanami::HanamiMessaging;
-using Kitsunemimi::Hanami::HanamiMessagingClient;
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 using Kitsunemimi::Hanami::SupportedComponents;
+using google::protobuf::internal::WireFormatLite;
+using google::protobuf::io::CodedOutputStream;
 
 namespace Shiori
 {
 
+// below this size a snapshot is copied into the target by a single thread
+const uint64_t PARALLEL_COPY_LIMIT = 16 * 1024 * 1024;
+
 /**
- * @brief get data of a snapshot from shiori
+ * @brief request the stored data of a snapshot from shiori, without decompressing it
  *
  * @param location file-location of the snapshot within shiori
  * @param error reference for error-output
  *
- * @return pointer to buffer with the data of the snapshot, if successful, else nullptr
+ * @return pointer to buffer with the stored data, if successful, else nullptr
  */
-Kitsunemimi::DataBuffer*
-getSnapshotData(const std::string &location,
+static Kitsunemimi::DataBuffer*
+requestSnapshot(const std::string &location,
                 Kitsunemimi::ErrorContainer &error)
 {
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
+    if(client == nullptr)
+    {
+        error.addMeesage("Failed to get client to shiori");
+        error.addSolution("Check if shiori is correctly configured");
+        return nullptr;
+    }
 
     // create message
     ClusterSnapshotPull_Message msg;
     msg.set_location(location);
 
     // serialize message
-    uint8_t buffer[96*1024];
-    const uint64_t msgSize = msg.ByteSizeLong();
-    if(msg.SerializeToArray(buffer, msgSize) == false)
-    {
-        error.addMeesage("Failed to serialize message");
+    PooledBuffer buffer;
+    uint64_t msgSize = 0;
+    const uint8_t* serialized = serializeMessage(buffer, msgSize, msg, error);
+    if(serialized == nullptr) {
         return nullptr;
     }
 
     // send message
-    return client->sendGenericRequest(SHIORI_CLUSTER_SNAPSHOT_PULL_MESSAGE_TYPE,
-                                      buffer,
-                                      msgSize,
-                                      error);
+    MetricsCollector* metrics = MetricsCollector::getInstance();
+    metrics->add(GET_SNAPSHOT_DATA_OPERATION, BYTES_SENT_FIELD, msgSize);
+    Kitsunemimi::DataBuffer* data = client->sendGenericRequest(
+                SHIORI_CLUSTER_SNAPSHOT_PULL_MESSAGE_TYPE,
+                serialized,
+                msgSize,
+                error);
+    if(data != nullptr) {
+        metrics->add(GET_SNAPSHOT_DATA_OPERATION, BYTES_RECEIVED_FIELD, data->usedBufferSize);
+    }
+
+    return data;
+}
+
+/**
+ * @brief get data of a snapshot from shiori, like it is stored in shiori. Compressed snapshots
+ *        and delta-snapshots are not restored.
+ *
+ * @param location file-location of the snapshot within shiori
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the stored data, if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+getSnapshotData(const std::string &location,
+                Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_SNAPSHOT_DATA_OPERATION);
+    return metric.finish(requestSnapshot(location, error));
+}
+
+/**
+ * @brief get encoding of the stored data of a snapshot out of the header, which was recorded,
+ *        when the snapshot was initialized
+ *
+ * @param encoding reference for the resulting encoding
+ * @param snapshot information of the snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getSnapshotEncoding(SnapshotEncoding &encoding,
+                    const SnapshotInformation &snapshot,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    encoding = SnapshotEncoding();
+    if(snapshot.header == "") {
+        return true;
+    }
+
+    Kitsunemimi::JsonItem parsedHeader;
+    if(parsedHeader.parse(snapshot.header, error) == false)
+    {
+        error.addMeesage("Failed to parse header of snapshot '" + snapshot.uuid + "'");
+        return false;
+    }
+
+    const std::string compressionName = getJsonString(parsedHeader, "compression");
+    if(getCompressionType(encoding.compression, compressionName) == false)
+    {
+        error.addMeesage("Snapshot '" + snapshot.uuid + "' has unknown compression '"
+                         + compressionName + "'");
+        error.addSolution("Update the library to a version, which supports this compression");
+        return false;
+    }
+
+    if(parsedHeader.contains("delta")) {
+        encoding.isDelta = parsedHeader.get("delta").getBool();
+    }
+
+    return true;
+}
+
+/**
+ * @brief get data of a snapshot from shiori and restore it with the help of its recorded
+ *        encoding. Compressed snapshots are decompressed and delta-snapshots are rebuilt with
+ *        the help of their parent.
+ *
+ * @param chainLength reference for the number of delta-snapshots from this snapshot back to
+ *                    the last full snapshot
+ * @param location file-location of the snapshot within shiori
+ * @param encoding encoding of the stored data
+ * @param depth number of delta-snapshots, which were already resolved before this one
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the data of the snapshot, if successful, else nullptr
+ */
+static Kitsunemimi::DataBuffer*
+getSnapshotData(uint32_t &chainLength,
+                const std::string &location,
+                const SnapshotEncoding &encoding,
+                const uint32_t depth,
+                Kitsunemimi::ErrorContainer &error);
+
+/**
+ * @brief get the restored data of the parent of a delta-snapshot
+ *
+ * @param chainLength reference for the number of delta-snapshots from the parent back to
+ *                    the last full snapshot
+ * @param delta buffer with the delta-snapshot
+ * @param location file-location of the delta-snapshot within shiori
+ * @param depth number of delta-snapshots, which were already resolved before this one
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the data of the parent, if successful, else nullptr
+ */
+static Kitsunemimi::DataBuffer*
+getDeltaParentData(uint32_t &chainLength,
+                   const Kitsunemimi::DataBuffer &delta,
+                   const std::string &location,
+                   const uint32_t depth,
+                   Kitsunemimi::ErrorContainer &error)
+{
+    std::string parentLocation = "";
+    SnapshotEncoding parentEncoding;
+    uint64_t parentSize = 0;
+    if(getDeltaParent(parentLocation, parentEncoding, parentSize, delta) == false)
+    {
+        error.addMeesage("Delta-snapshot with location '" + location + "' is broken");
+        error.addSolution("Check if the header of the snapshot matches its stored data");
+        return nullptr;
+    }
+    if(depth >= MAX_DELTA_CHAIN_LENGTH)
+    {
+        error.addMeesage("Too many delta-snapshots in a row, while requesting snapshot '"
+                         + location + "'");
+        return nullptr;
+    }
+
+    // a delta-snapshot can only be restored, as long as its parent exists unchanged in shiori
+    Kitsunemimi::DataBuffer* parent = getSnapshotData(chainLength,
+                                                      parentLocation,
+                                                      parentEncoding,
+                                                      depth + 1,
+                                                      error);
+    if(parent == nullptr
+            || parent->usedBufferSize != parentSize)
+    {
+        error.addMeesage("Parent-snapshot with location '" + parentLocation
+                         + "' of delta-snapshot '" + location
+                         + "' doesn't exist anymore or was changed");
+        error.addSolution("Keep the parent of a delta-snapshot in shiori, as long as the "
+                          "delta-snapshot is used");
+        delete parent;
+        return nullptr;
+    }
+
+    return parent;
+}
+
+static Kitsunemimi::DataBuffer*
+getSnapshotData(uint32_t &chainLength,
+                const std::string &location,
+                const SnapshotEncoding &encoding,
+                const uint32_t depth,
+                Kitsunemimi::ErrorContainer &error)
+{
+    Kitsunemimi::DataBuffer* data = requestSnapshot(location, error);
+    if(data == nullptr) {
+        return nullptr;
+    }
+
+    // decompress snapshot, if it was compressed before upload
+    if(encoding.compression != NO_COMPRESSION)
+    {
+        Kitsunemimi::DataBuffer* decompressed = decompressSnapshot(*data, error);
+        delete data;
+        if(decompressed == nullptr)
+        {
+            error.addMeesage("Failed to decompress snapshot '" + location + "'");
+            return nullptr;
+        }
+        data = decompressed;
+    }
+
+    if(encoding.isDelta == false)
+    {
+        chainLength = 0;
+        return data;
+    }
+
+    // rebuild delta-snapshot
+    Kitsunemimi::DataBuffer* parent = getDeltaParentData(chainLength,
+                                                         *data,
+                                                         location,
+                                                         depth,
+                                                         error);
+    if(parent == nullptr)
+    {
+        delete data;
+        return nullptr;
+    }
+    chainLength++;
+
+    Kitsunemimi::DataBuffer* result = applyDeltaSnapshot(*data, *parent, error);
+    delete data;
+    delete parent;
+
+    return result;
+}
+
+/**
+ * @brief get data of a snapshot from shiori. Compressed snapshots are decompressed and
+ *        delta-snapshots are rebuilt with the help of their parent, like it is recorded
+ *        in the header of the snapshot.
+ *
+ * @param snapshot information of the snapshot
+ * @param error reference for error-output
+ *
+ * @return pointer to buffer with the data of the snapshot, if successful, else nullptr
+ */
+Kitsunemimi::DataBuffer*
+getSnapshotData(const SnapshotInformation &snapshot,
+                Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_SNAPSHOT_DATA_OPERATION);
+
+    SnapshotEncoding encoding;
+    if(getSnapshotEncoding(encoding, snapshot, error) == false) {
+        return nullptr;
+    }
+
+    uint32_t chainLength = 0;
+    return metric.finish(getSnapshotData(chainLength, snapshot.location, encoding, 0, error));
+}
+
+/**
+ * @brief copy a big memory-region with multiple threads
+ *
+ * @param target pointer to the target
+ * @param source pointer to the source
+ * @param size number of bytes to copy
+ */
+static void
+copyParallel(uint8_t* target,
+             const uint8_t* source,
+             const uint64_t size)
+{
+    uint64_t numberOfThreads = 1;
+    if(size >= PARALLEL_COPY_LIMIT) {
+        numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    const uint64_t sizePerThread = (size + numberOfThreads - 1) / numberOfThreads;
+    std::vector<std::thread> threads;
+    for(uint64_t i = 1; i < numberOfThreads; i++)
+    {
+        const uint64_t begin = i * sizePerThread;
+        if(begin >= size) {
+            break;
+        }
+        const uint64_t partSize = std::min(sizePerThread, size - begin);
+        threads.emplace_back([=]() { memcpy(&target[begin], &source[begin], partSize); });
+    }
+
+    memcpy(target, source, std::min(sizePerThread, size));
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief restore a snapshot into a target-memory. Shiori sends the stored data as one response,
+ *        which is always received into a buffer of the messaging-client. Compressed snapshots
+ *        are decompressed out of this buffer into the target and delta-snapshots are rebuilt
+ *        into the target. Uncompressed snapshots are copied once into the target.
+ *
+ * @param snapshotSize reference for the size of the restored snapshot
+ * @param getTarget callback, which returns a pointer to a memory of at least the given size,
+ *                  or nullptr if no memory of this size is available
+ * @param location file-location of the snapshot within shiori
+ * @param encoding encoding of the stored data
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+static bool
+restoreSnapshot(uint64_t &snapshotSize,
+                const std::function<uint8_t*(const uint64_t)> &getTarget,
+                const std::string &location,
+                const SnapshotEncoding &encoding,
+                Kitsunemimi::ErrorContainer &error)
+{
+    Kitsunemimi::DataBuffer* data = requestSnapshot(location, error);
+    if(data == nullptr) {
+        return false;
+    }
+
+    if(encoding.isDelta == false)
+    {
+        uint64_t size = data->usedBufferSize;
+        if(encoding.compression != NO_COMPRESSION
+                && getDecompressedSize(size, *data, error) == false)
+        {
+            error.addMeesage("Failed to decompress snapshot '" + location + "'");
+            delete data;
+            return false;
+        }
+
+        uint8_t* target = getTarget(size);
+        if(target == nullptr)
+        {
+            error.addMeesage("Failed to get target-memory for snapshot '" + location + "'");
+            delete data;
+            return false;
+        }
+
+        // decompress or copy the received data into the target
+        bool success = true;
+        if(encoding.compression != NO_COMPRESSION) {
+            success = decompressSnapshot(target, size, *data, error);
+        }
+        else {
+            copyParallel(target, static_cast<const uint8_t*>(data->data), size);
+        }
+        delete data;
+        if(success == false)
+        {
+            error.addMeesage("Failed to decompress snapshot '" + location + "'");
+            return false;
+        }
+
+        snapshotSize = size;
+
+        return true;
+    }
+
+    // a compressed delta-snapshot is decompressed into a temporary buffer, because only the
+    // rebuilt snapshot is written into the target
+    if(encoding.compression != NO_COMPRESSION)
+    {
+        Kitsunemimi::DataBuffer* decompressed = decompressSnapshot(*data, error);
+        delete data;
+        if(decompressed == nullptr)
+        {
+            error.addMeesage("Failed to decompress snapshot '" + location + "'");
+            return false;
+        }
+        data = decompressed;
+    }
+
+    // rebuild delta-snapshot with the help of its parent
+    uint32_t chainLength = 0;
+    Kitsunemimi::DataBuffer* parent = getDeltaParentData(chainLength,
+                                                         *data,
+                                                         location,
+                                                         0,
+                                                         error);
+    if(parent == nullptr)
+    {
+        delete data;
+        return false;
+    }
+
+    // the size is validated against the content of the delta-snapshot, before the target
+    // is requested with it
+    uint64_t size = 0;
+    bool success = getDeltaSnapshotSize(size, *data, error);
+    if(success)
+    {
+        uint8_t* target = getTarget(size);
+        success = target != nullptr
+                  && applyDeltaSnapshot(target, size, *data, *parent, error);
+    }
+    delete data;
+    delete parent;
+    if(success == false)
+    {
+        error.addMeesage("Failed to rebuild delta-snapshot '" + location + "'");
+        return false;
+    }
+
+    snapshotSize = size;
+
+    return true;
+}
+
+/**
+ * @brief get data of a snapshot from shiori and write it into a buffer of the caller. The
+ *        received data of an uncompressed snapshot is copied once into the buffer, because
+ *        the response of shiori can't be received into an external buffer.
+ *
+ * @param target pointer to the target-buffer
+ * @param snapshotSize reference for the size of the snapshot
+ * @param targetSize size of the target-buffer
+ * @param snapshot information of the snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getSnapshotData(void* target,
+                uint64_t &snapshotSize,
+                const uint64_t targetSize,
+                const SnapshotInformation &snapshot,
+                Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_SNAPSHOT_DATA_OPERATION);
+
+    SnapshotEncoding encoding;
+    if(getSnapshotEncoding(encoding, snapshot, error) == false) {
+        return false;
+    }
+
+    bool tooSmall = false;
+    auto getTarget = [&](const uint64_t size) -> uint8_t*
+    {
+        if(size > targetSize)
+        {
+            tooSmall = true;
+            snapshotSize = size;
+            return nullptr;
+        }
+        return static_cast<uint8_t*>(target);
+    };
+
+    if(restoreSnapshot(snapshotSize, getTarget, snapshot.location, encoding, error) == false)
+    {
+        if(tooSmall)
+        {
+            error.addMeesage("Target-buffer with size '" + std::to_string(targetSize)
+                             + "' is too small for snapshot with size '"
+                             + std::to_string(snapshotSize) + "'");
+            error.addSolution("Use a target-buffer with at least the size of the snapshot");
+        }
+        return false;
+    }
+
+    return metric.finish(true);
+}
+
+/**
+ * @brief get data of a snapshot from shiori and write it into a memory-mapped file. The
+ *        received data of an uncompressed snapshot is copied once into the file.
+ *
+ * @param snapshotSize reference for the size of the snapshot
+ * @param filePath path of the file, which is created or overwritten
+ * @param snapshot information of the snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getSnapshotDataToFile(uint64_t &snapshotSize,
+                      const std::string &filePath,
+                      const SnapshotInformation &snapshot,
+                      Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_SNAPSHOT_DATA_OPERATION);
+
+    SnapshotEncoding encoding;
+    if(getSnapshotEncoding(encoding, snapshot, error) == false) {
+        return false;
+    }
+
+    const int fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        error.addMeesage("Failed to open file '" + filePath + "'");
+        error.addSolution("Check if the directory exists and is writable");
+        return false;
+    }
+
+    uint8_t* mapped = nullptr;
+    uint64_t mappedSize = 0;
+    auto getTarget = [&](const uint64_t size) -> uint8_t*
+    {
+        if(ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            return nullptr;
+        }
+
+        // a mapping with size 0 is not allowed, but the empty mapping is never accessed
+        mappedSize = std::max(size, static_cast<uint64_t>(1));
+        void* ptr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(ptr == MAP_FAILED)
+        {
+            error.addMeesage("Failed to map file '" + filePath + "' into memory");
+            return nullptr;
+        }
+
+        mapped = static_cast<uint8_t*>(ptr);
+        return mapped;
+    };
+
+    const bool success = restoreSnapshot(snapshotSize,
+                                         getTarget,
+                                         snapshot.location,
+                                         encoding,
+                                         error);
+
+    if(mapped != nullptr) {
+        munmap(mapped, mappedSize);
+    }
+    close(fd);
+
+    if(success == false)
+    {
+        unlink(filePath.c_str());
+        return false;
+    }
+
+    return metric.finish(true);
+}
+
+/**
+ * @brief get manifest of a snapshot, which is already stored in shiori, to use it as parent
+ *        for a delta-snapshot
+ *
+ * @param manifest reference for the resulting manifest
+ * @param snapshot information of the snapshot
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getSnapshotManifest(SnapshotManifest &manifest,
+                    const SnapshotInformation &snapshot,
+                    Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_SNAPSHOT_MANIFEST_OPERATION);
+
+    SnapshotEncoding encoding;
+    if(getSnapshotEncoding(encoding, snapshot, error) == false) {
+        return false;
+    }
+
+    uint32_t chainLength = 0;
+    Kitsunemimi::DataBuffer* data = getSnapshotData(chainLength,
+                                                    snapshot.location,
+                                                    encoding,
+                                                    0,
+                                                    error);
+    if(data == nullptr) {
+        return false;
+    }
+
+    createSnapshotManifest(manifest, *data);
+    manifest.location = snapshot.location;
+    manifest.encoding = encoding;
+    manifest.chainLength = chainLength;
+    delete data;
+
+    return metric.finish(true);
 }
 
 /**
@@ -89,38 +660,65 @@ getSnapshotInformation(Kitsunemimi::JsonItem &result,
                        const std::string &token,
                        Kitsunemimi::ErrorContainer &error)
 {
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
-    if(client == nullptr) {
+    MetricScope metric(GET_SNAPSHOT_INFORMATION_OPERATION);
+
+    // request information of the snapshot from shiori
+    std::shared_ptr<const Kitsunemimi::JsonItem> parsedContent;
+    if(MetadataCache::getInstance()->request(parsedContent,
+                                             "v1/cluster_snapshot",
+                                             snapshotUuid,
+                                             token,
+                                             error) == false)
+    {
         return false;
     }
 
-    Kitsunemimi::Hanami::ResponseMessage response;
+    result = *parsedContent;
 
-    // create request for remote-calls
-    Kitsunemimi::Hanami::RequestMessage request;
-    request.id = "v1/cluster_snapshot";
-    request.httpType = Kitsunemimi::Hanami::GET_TYPE;
-    request.inputValues = "{\"uuid\" : \"" + snapshotUuid + "\","
-                          "\"token\":\"" + token + "\"}";
+    return metric.finish(true);
+}
 
-    // send request to the target
-    if(client->triggerSakuraFile(response, request, error) == false) {
-        return false;
-    }
+/**
+ * @brief get information of a specific snapshot from shiori as typed struct
+ *
+ * @param result reference for the output of the information
+ * @param snapshotUuid uuid of the requested snapshot
+ * @param token access-token for shiori
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getSnapshotInformation(SnapshotInformation &result,
+                       const std::string &snapshotUuid,
+                       const std::string &token,
+                       Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(GET_SNAPSHOT_INFORMATION_OPERATION);
 
-    // check response
-    if(response.success == false)
+    // request information of the snapshot from shiori
+    std::shared_ptr<const Kitsunemimi::JsonItem> parsedContent;
+    if(MetadataCache::getInstance()->request(parsedContent,
+                                             "v1/cluster_snapshot",
+                                             snapshotUuid,
+                                             token,
+                                             error) == false)
     {
-        error.addMeesage(response.responseContent);
         return false;
     }
 
-    // parse result
-    if(result.parse(response.responseContent, error) == false) {
-        return false;
+    result.uuid = getJsonString(*parsedContent, "uuid");
+    result.name = getJsonString(*parsedContent, "name");
+    result.location = getJsonString(*parsedContent, "location");
+    result.projectId = getJsonString(*parsedContent, "project_id");
+    result.ownerId = getJsonString(*parsedContent, "owner_id");
+    result.visibility = getJsonString(*parsedContent, "visibility");
+    result.header = "";
+    if(parsedContent->contains("header")) {
+        result.header = parsedContent->get("header").toString();
     }
 
-    return true;
+    return metric.finish(true);
 }
 
 /**
@@ -134,6 +732,8 @@ getSnapshotInformation(Kitsunemimi::JsonItem &result,
  * @param totalSize total size of the snapshot
  * @param headerMessage header-message with meta-information of the snapshot
  * @param token access-token for shiori
+ * @param encoding encoding of the uploaded data, which is written into the header, so the
+ *                 snapshot can be restored later
  * @param error reference for error-output
  *
  * @return true, if successful, else false
@@ -147,10 +747,14 @@ runSnapshotInitProcess(std::string &fileUuid,
                        const uint64_t totalSize,
                        const std::string &headerMessage,
                        const std::string &token,
+                       const SnapshotEncoding &encoding,
                        Kitsunemimi::ErrorContainer &error)
 {
+    MetricScope metric(SNAPSHOT_INIT_OPERATION);
+
     // get internal client for interaction with shiori
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
     if(client == nullptr)
     {
         error.addMeesage("Failed to get client to shiori");
@@ -158,29 +762,50 @@ runSnapshotInitProcess(std::string &fileUuid,
         return false;
     }
 
+    // write encoding into the header, so it is stored together with the snapshot
+    std::string header = headerMessage;
+    if(encoding.compression != NO_COMPRESSION
+            || encoding.isDelta)
+    {
+        Kitsunemimi::JsonItem parsedHeader;
+        if(parsedHeader.parse(headerMessage, error) == false)
+        {
+            error.addMeesage("Failed to parse header of the snapshot");
+            return false;
+        }
+        if(encoding.compression != NO_COMPRESSION)
+        {
+            const Kitsunemimi::JsonItem compressionName(getCompressionName(encoding.compression));
+            parsedHeader.insert("compression", compressionName, true);
+        }
+        if(encoding.isDelta) {
+            parsedHeader.insert("delta", Kitsunemimi::JsonItem(true), true);
+        }
+        header = parsedHeader.toString();
+    }
+
     // create request
     Kitsunemimi::Hanami::RequestMessage requestMsg;
     requestMsg.id = "v1/cluster_snapshot";
     requestMsg.httpType = Kitsunemimi::Hanami::HttpRequestType::POST_TYPE;
-    requestMsg.inputValues = "";
-    requestMsg.inputValues.append("{\"user_id\":\"");
-    requestMsg.inputValues.append(userId);
-    requestMsg.inputValues.append("\",\"token\":\"");
-    requestMsg.inputValues.append(token);
-    requestMsg.inputValues.append("\",\"uuid\":\"");
-    requestMsg.inputValues.append(snapshotUuid);
-    requestMsg.inputValues.append("\",\"header\":");
-    requestMsg.inputValues.append(headerMessage);
-    requestMsg.inputValues.append(",\"project_id\":\"");
-    requestMsg.inputValues.append(projectId);
-    requestMsg.inputValues.append("\",\"name\":\"");
-    requestMsg.inputValues.append(snapshotName);
-    requestMsg.inputValues.append("\",\"input_data_size\":");
-    requestMsg.inputValues.append(std::to_string(totalSize));
-    requestMsg.inputValues.append("}");
+    std::string* input = &requestMsg.inputValues;
+    input->clear();
+    input->reserve(256 + header.size() + token.size());
+    input->push_back('{');
+    appendJsonField(*input, "user_id", userId);
+    appendJsonField(*input, "token", token);
+    appendJsonField(*input, "uuid", snapshotUuid);
+    input->append(",\"header\":");
+    input->append(header);
+    appendJsonField(*input, "project_id", projectId);
+    appendJsonField(*input, "name", snapshotName);
+    appendJsonField(*input, "input_data_size", totalSize);
+    input->push_back('}');
 
     // trigger initializing of snapshot
     Kitsunemimi::Hanami::ResponseMessage response;
+    MetricsCollector* metrics = MetricsCollector::getInstance();
+    metrics->add(SNAPSHOT_INIT_OPERATION, BYTES_SENT_FIELD, requestMsg.inputValues.size());
     if(client->triggerSakuraFile(response, requestMsg, error) == false)
     {
         error.addMeesage("Failed to trigger blossom in shiori to initialize "
@@ -188,6 +813,10 @@ runSnapshotInitProcess(std::string &fileUuid,
         return false;
     }
 
+    metrics->add(SNAPSHOT_INIT_OPERATION,
+                 BYTES_RECEIVED_FIELD,
+                 response.responseContent.size());
+
     // check response
     if(response.success == false)
     {
@@ -208,6 +837,135 @@ runSnapshotInitProcess(std::string &fileUuid,
     }
     fileUuid = parsedResponse.get("uuid_input_file").getString();
 
+    return metric.finish(true);
+}
+
+/**
+ * @brief initialize the transfer of an uncompressed full cluster-snapshot to shiori
+ *
+ * @param fileUuid uuid of the temporary file of the snapshot in shiori
+ * @param snapshotUuid uuid of the new snapshot, which should be the same like the task-uuid
+ * @param snapshotName name of the new snapshot
+ * @param userId id of the user who owns the snapshot
+ * @param projectId id of the project in with the snapshot was created
+ * @param totalSize total size of the snapshot
+ * @param headerMessage header-message with meta-information of the snapshot
+ * @param token access-token for shiori
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+runSnapshotInitProcess(std::string &fileUuid,
+                       const std::string &snapshotUuid,
+                       const std::string &snapshotName,
+                       const std::string &userId,
+                       const std::string &projectId,
+                       const uint64_t totalSize,
+                       const std::string &headerMessage,
+                       const std::string &token,
+                       Kitsunemimi::ErrorContainer &error)
+{
+    return runSnapshotInitProcess(fileUuid,
+                                  snapshotUuid,
+                                  snapshotName,
+                                  userId,
+                                  projectId,
+                                  totalSize,
+                                  headerMessage,
+                                  token,
+                                  SnapshotEncoding(),
+                                  error);
+}
+
+/**
+ * @brief prepare the message for the upload of a snapshot. The message is reused for all
+ *        segments of the upload, so the uuids are only copied once and not for each segment.
+ *
+ * @param message message to prepare
+ * @param uuid uuid of the snapshot
+ * @param fileUuid uuid of the temporary file in shiori for identification
+ */
+static void
+initUploadMessage(FileUpload_Message &message,
+                  const std::string &uuid,
+                  const std::string &fileUuid)
+{
+    message.set_fileuuid(fileUuid);
+    message.set_datasetuuid(uuid);
+    message.set_type(UploadDataType::CLUSTER_SNAPSHOT_TYPE);
+}
+
+/**
+ * @brief serialize and send a single segment of a snapshot to shiori
+ *
+ * @param lease lease of the connection to shiori, which serializes the stream-messages
+ * @param u8Data pointer to the complete local data
+ * @param offset offset of the segment within the local data
+ * @param segmentSize number of bytes of the segment
+ * @param targetPos byte-position within the snapshot where the segment belongs to
+ * @param isLast true, if this is the last segment of the upload
+ * @param message prepared message of the upload, which is reused for all segments
+ * @param sendBuffer buffer for the serialized message
+ * @param sendBufferSize size of the buffer for the serialized message
+ * @param operation operation, which is measured by the metrics
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+static bool
+sendSegment(ClientLease &lease,
+            const uint8_t* u8Data,
+            const uint64_t offset,
+            const uint64_t segmentSize,
+            const uint64_t targetPos,
+            const bool isLast,
+            FileUpload_Message &message,
+            uint8_t* sendBuffer,
+            const uint64_t sendBufferSize,
+            const MetricOperation operation,
+            Kitsunemimi::ErrorContainer &error)
+{
+    // only the scalar fields change between the segments, so setting them doesn't allocate
+    message.set_islast(isLast);
+    message.set_position(targetPos);
+
+    // serialize only the header-fields of the message, because the data-field doesn't have
+    // to be copied into the message first, but can be appended directly from the local data.
+    // Protobuf accepts fields in any order, so the result is a valid FileUpload_Message.
+    const uint64_t headerSize = message.ByteSizeLong();
+    if(headerSize + 16 + segmentSize > sendBufferSize)
+    {
+        error.addMeesage("Segment with position '"
+                         + std::to_string(offset)
+                         + "' is too big for the send-buffer");
+        return false;
+    }
+    uint8_t* target = message.SerializeWithCachedSizesToArray(sendBuffer);
+    target = WireFormatLite::WriteTagToArray(FileUpload_Message::kDataFieldNumber,
+                                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                                             target);
+    target = CodedOutputStream::WriteVarint64ToArray(segmentSize, target);
+    memcpy(target, &u8Data[offset], segmentSize);
+    const uint64_t msgSize = static_cast<uint64_t>(target - sendBuffer) + segmentSize;
+
+    // send segment
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if(lease.sendStreamMessage(sendBuffer, msgSize, false, error) == false)
+    {
+        error.addMeesage("Failed to send part with position '"
+                         + std::to_string(offset)
+                         + "' to shiori");
+        return false;
+    }
+    const std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - start;
+    SegmentTuner::getInstance()->addMeasurement(segmentSize,
+                                                static_cast<uint64_t>(duration.count()));
+
+    MetricsCollector* metrics = MetricsCollector::getInstance();
+    metrics->add(operation, BYTES_SENT_FIELD, msgSize);
+    metrics->add(operation, SEGMENTS_FIELD, 1);
+
     return true;
 }
 
@@ -229,9 +987,11 @@ sendData(const Kitsunemimi::DataBuffer* data,
          const std::string &fileUuid,
          Kitsunemimi::ErrorContainer &error)
 {
+    MetricScope metric(SEND_DATA_OPERATION);
+
     // get internal client for interaction with shiori
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
-    if(client == nullptr)
+    ClientLease lease;
+    if(lease.getClient() == nullptr)
     {
         error.addMeesage("Failed to get client to shiori");
         error.addSolution("Check if shiori is correctly configured");
@@ -241,58 +1001,382 @@ sendData(const Kitsunemimi::DataBuffer* data,
     const uint64_t dataSize = data->usedBufferSize;
     const uint8_t* u8Data = static_cast<const uint8_t*>(data->data);
 
-    uint8_t sendBuffer[128*1024];
+    SegmentTuner* tuner = SegmentTuner::getInstance();
+    const uint64_t sendBufferSize = tuner->getMaxSegmentSize() + SEGMENT_HEADER_RESERVE;
+    PooledBuffer sendBuffer;
+    uint8_t* buffer = sendBuffer.get(sendBufferSize, error);
+    if(buffer == nullptr) {
+        return false;
+    }
+    FileUpload_Message message;
+    initUploadMessage(message, uuid, fileUuid);
     uint64_t i = 0;
-    uint64_t pos = 0;
-
-    // prepare buffer
-    uint64_t segmentSize = 96 * 1024;
+    uint64_t segmentSize = 0;
 
     do
     {
-        pos = i + targetPos;
+        // the segment-size can change between the segments in adaptive mode
+        segmentSize = tuner->getSegmentSize();
+
+        // check the size for the last segment, which is also marked, if it has the full size
+        if(dataSize - i < segmentSize) {
+            segmentSize = dataSize - i;
+        }
+        const bool isLast = i + segmentSize == dataSize;
+
+        if(sendSegment(lease,
+                       u8Data,
+                       i,
+                       segmentSize,
+                       i + targetPos,
+                       isLast,
+                       message,
+                       buffer,
+                       sendBufferSize,
+                       SEND_DATA_OPERATION,
+                       error) == false)
+        {
+            return false;
+        }
 
+        i += segmentSize;
+    }
+    while(i < dataSize);
+
+    targetPos += i;
+
+    return metric.finish(true);
+}
+
+/**
+ * @brief send all not yet sent segments with multiple threads at the same time. Because the
+ *        position of each segment is explicit, the segments can arrive in any order. Only the
+ *        last segment is held back, until all other segments were sent. Shiori doesn't confirm
+ *        single segments, so a successful call only means, that all segments were written to
+ *        the connection. All segments are sent over the same connection, because only there
+ *        the last segment can not overtake the other segments. The threads serialize their
+ *        segments in parallel, but the lease of the connection sends one message at a time.
+ *
+ * @param u8Data pointer to the complete local data
+ * @param dataSize size of the complete local data
+ * @param uuid uuid of the snapshot
+ * @param fileUuid uuid of the temporary file in shiori for identification
+ * @param numberOfWorkers number of threads, which send segments at the same time
+ * @param segmentStates states of all segments of the local data
+ * @param operation operation, which is measured by the metrics
+ * @param error reference for error-output
+ *
+ * @return true, if all segments were sent, else false
+ */
+static bool
+sendSegmentsPipelined(const uint8_t* u8Data,
+                      const uint64_t dataSize,
+                      const std::string &uuid,
+                      const std::string &fileUuid,
+                      const uint32_t numberOfWorkers,
+                      std::vector<SegmentState> &segmentStates,
+                      const MetricOperation operation,
+                      Kitsunemimi::ErrorContainer &error)
+{
+    const uint64_t startPos = segmentStates[0].position;
+    const uint64_t lastSegment = segmentStates.size() - 1;
+
+    // collect segments to send, except the last one
+    std::vector<uint64_t> openSegments;
+    for(uint64_t i = 0; i < lastSegment; i++)
+    {
+        segmentStates[i].errorMessage = "";
+        if(segmentStates[i].sent == false) {
+            openSegments.push_back(i);
+        }
+    }
+
+    // send segments with multiple workers, where each worker sends one segment at a time
+    std::atomic<uint64_t> nextSegment = {0};
+    std::atomic<bool> abort = {false};
+    const uint64_t numberOfThreads = std::min(static_cast<uint64_t>(std::max(numberOfWorkers, 1u)),
+                                              static_cast<uint64_t>(openSegments.size()));
+
+    uint64_t sendBufferSize = SegmentTuner::getInstance()->getMaxSegmentSize();
+    for(const SegmentState &segmentState : segmentStates) {
+        sendBufferSize = std::max(sendBufferSize, segmentState.size);
+    }
+    sendBufferSize += SEGMENT_HEADER_RESERVE;
+
+    ClientLease lease;
+    if(lease.getClient() == nullptr)
+    {
+        error.addMeesage("Failed to get client to shiori");
+        error.addSolution("Check if shiori is correctly configured");
+        return false;
+    }
+
+    auto worker = [&]()
+    {
+        // each worker uses its own buffer and message, because the serialization caches
+        // the size of the message
+        PooledBuffer sendBuffer;
+        Kitsunemimi::ErrorContainer setupError;
+        uint8_t* buffer = sendBuffer.get(sendBufferSize, setupError);
         FileUpload_Message message;
-        message.set_fileuuid(fileUuid);
-        message.set_datasetuuid(uuid);
-        message.set_type(UploadDataType::CLUSTER_SNAPSHOT_TYPE);
-        message.set_islast(false);
-
-        // check the size for the last segment
-        segmentSize = 96 * 1024;
-        if(dataSize - i < segmentSize)
+        initUploadMessage(message, uuid, fileUuid);
+        while(abort == false)
         {
-            segmentSize = dataSize - i;
-            message.set_islast(true);
+            const uint64_t pos = nextSegment.fetch_add(1);
+            if(pos >= openSegments.size()) {
+                return;
+            }
+
+            SegmentState* state = &segmentStates[openSegments[pos]];
+            if(buffer == nullptr)
+            {
+                state->errorMessage = setupError.toString();
+                abort = true;
+                return;
+            }
+
+            Kitsunemimi::ErrorContainer segmentError;
+            state->sent = sendSegment(lease,
+                                      u8Data,
+                                      state->position - startPos,
+                                      state->size,
+                                      state->position,
+                                      false,
+                                      message,
+                                      buffer,
+                                      sendBufferSize,
+                                      operation,
+                                      segmentError);
+            if(state->sent == false)
+            {
+                state->errorMessage = segmentError.toString();
+                abort = true;
+            }
         }
+    };
 
-        // read segment of the local file
-        message.set_position(pos);
-        message.set_data(static_cast<const void*>(&u8Data[i]), segmentSize);
+    std::vector<std::thread> threads;
+    for(uint64_t i = 0; i < numberOfThreads; i++) {
+        threads.emplace_back(worker);
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
 
-        const uint64_t msgSize = message.ByteSizeLong();
-        if(message.SerializeToArray(sendBuffer, msgSize) == false)
+    // check results of the workers
+    if(abort)
+    {
+        for(const SegmentState &state : segmentStates)
         {
-            error.addMeesage("Failed to serialize learn-message");
-            return false;
+            if(state.errorMessage.size() > 0) {
+                error.addMeesage(state.errorMessage);
+            }
         }
+        error.addMeesage("Failed to send snapshot-data with pipelined upload to shiori");
+        return false;
+    }
 
-        // send segment
-        if(client->sendStreamMessage(sendBuffer, msgSize, false, error) == false)
+    // send last segment after all other segments were sent
+    SegmentState* state = &segmentStates[lastSegment];
+    if(state->sent) {
+        return true;
+    }
+    // the segment is also the last one, if the data is an exact multiple of the segment-size
+    const bool isLast = state->position + state->size == startPos + dataSize;
+    PooledBuffer sendBuffer;
+    uint8_t* buffer = sendBuffer.get(sendBufferSize, error);
+    if(buffer == nullptr) {
+        return false;
+    }
+    FileUpload_Message message;
+    initUploadMessage(message, uuid, fileUuid);
+    Kitsunemimi::ErrorContainer segmentError;
+    state->sent = sendSegment(lease,
+                              u8Data,
+                              state->position - startPos,
+                              state->size,
+                              state->position,
+                              isLast,
+                              message,
+                              buffer,
+                              sendBufferSize,
+                              operation,
+                              segmentError);
+    if(state->sent == false)
+    {
+        state->errorMessage = segmentError.toString();
+        error.addMeesage(state->errorMessage);
+        error.addMeesage("Failed to send snapshot-data with pipelined upload to shiori");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief send data of the snapshot to shiori with multiple threads, which serialize and send
+ *        the segments at the same time. Shiori doesn't confirm single segments, so the upload
+ *        is only confirmed by runSnapshotFinalizeProcess. If the upload fails, the
+ *        segment-states can be used to retry the upload with retrySendData.
+ *
+ * @param data buffer with data to send
+ * @param targetPos byte-position within the snapshot where the data belongs to
+ * @param uuid uuid of the snapshot
+ * @param fileUuid uuid of the temporary file in shiori for identification
+ * @param numberOfWorkers number of threads, which send segments at the same time
+ * @param segmentStates reference for the output of the state of each segment
+ * @param error reference for error-output
+ *
+ * @return true, if all segments were sent, else false
+ */
+bool
+sendDataPipelined(const Kitsunemimi::DataBuffer* data,
+                  uint64_t &targetPos,
+                  const std::string &uuid,
+                  const std::string &fileUuid,
+                  const uint32_t numberOfWorkers,
+                  std::vector<SegmentState> &segmentStates,
+                  Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(SEND_DATA_PIPELINED_OPERATION);
+
+    const uint64_t dataSize = data->usedBufferSize;
+    const uint8_t* u8Data = static_cast<const uint8_t*>(data->data);
+    // the segment-size is fixed for the whole call, so the segment-states can be used for retry
+    const uint64_t segmentSize = SegmentTuner::getInstance()->getSegmentSize();
+
+    // split data into segments
+    uint64_t numberOfSegments = dataSize / segmentSize;
+    if(dataSize % segmentSize != 0 || numberOfSegments == 0) {
+        numberOfSegments++;
+    }
+
+    segmentStates.clear();
+    segmentStates.resize(numberOfSegments);
+    for(uint64_t i = 0; i < numberOfSegments; i++)
+    {
+        const uint64_t offset = i * segmentSize;
+        segmentStates[i].position = targetPos + offset;
+        segmentStates[i].size = std::min(segmentSize, dataSize - offset);
+        segmentStates[i].checksum = calculateCrc32c(&u8Data[offset], segmentStates[i].size);
+    }
+
+    if(sendSegmentsPipelined(u8Data,
+                             dataSize,
+                             uuid,
+                             fileUuid,
+                             numberOfWorkers,
+                             segmentStates,
+                             SEND_DATA_PIPELINED_OPERATION,
+                             error) == false)
+    {
+        return false;
+    }
+
+    targetPos += dataSize;
+
+    return metric.finish(true);
+}
+
+/**
+ * @brief retry a failed pipelined upload completely into the same temporary file in shiori,
+ *        without a new initialization of the upload. Stream-messages are not confirmed by
+ *        shiori and the protocol has no request for the stored parts of a temporary file, so
+ *        it can't be told, which segments arrived. Because of this, all segments are sent
+ *        again and not only the failed ones. Before that, the checksums of the segments are
+ *        compared with the given data, to ensure that segments, which are already stored by
+ *        shiori, are overwritten with the same data.
+ *
+ * @param data buffer with the same data like in the failed upload
+ * @param targetPos byte-position within the snapshot where the data belongs to
+ * @param uuid uuid of the snapshot
+ * @param fileUuid uuid of the temporary file in shiori for identification
+ * @param numberOfWorkers number of threads, which send segments at the same time
+ * @param segmentStates states of the segments of the failed upload, which are updated
+ * @param error reference for error-output
+ *
+ * @return true, if all segments were sent, else false
+ */
+bool
+retrySendData(const Kitsunemimi::DataBuffer* data,
+              uint64_t &targetPos,
+              const std::string &uuid,
+              const std::string &fileUuid,
+              const uint32_t numberOfWorkers,
+              std::vector<SegmentState> &segmentStates,
+              Kitsunemimi::ErrorContainer &error)
+{
+    MetricScope metric(RETRY_SEND_DATA_OPERATION);
+
+    const uint64_t dataSize = data->usedBufferSize;
+    const uint8_t* u8Data = static_cast<const uint8_t*>(data->data);
+
+    // check if the states belong to the given data
+    if(segmentStates.size() == 0
+            || segmentStates[0].position != targetPos
+            || segmentStates.back().position + segmentStates.back().size != targetPos + dataSize)
+    {
+        error.addMeesage("Segment-states don't match the data to retry the upload");
+        return false;
+    }
+    for(const SegmentState &state : segmentStates)
+    {
+        if(calculateCrc32c(&u8Data[state.position - targetPos], state.size) != state.checksum)
         {
-            error.addMeesage("Failed to send part with position '"
-                             + std::to_string(i)
-                             + "' to shiori");
+            error.addMeesage("Checksum of segment with position '"
+                             + std::to_string(state.position)
+                             + "' doesn't match the data to retry the upload");
             return false;
         }
+    }
 
-        i += segmentSize;
+    // only shiori could tell, which segments are really stored, so every segment is sent again
+    for(SegmentState &state : segmentStates) {
+        state.sent = false;
     }
-    while(i < dataSize);
+    MetricsCollector::getInstance()->add(RETRY_SEND_DATA_OPERATION,
+                                         RETRIES_FIELD,
+                                         segmentStates.size());
 
-    targetPos += i;
+    LOG_DEBUG("Retry upload of snapshot '" + uuid + "' at position "
+              + std::to_string(targetPos));
 
-    return true;
+    if(sendSegmentsPipelined(u8Data,
+                             dataSize,
+                             uuid,
+                             fileUuid,
+                             numberOfWorkers,
+                             segmentStates,
+                             RETRY_SEND_DATA_OPERATION,
+                             error) == false)
+    {
+        return false;
+    }
+
+    targetPos += dataSize;
+
+    return metric.finish(true);
+}
+
+/**
+ * @brief configure the size of the segments for the upload of snapshots
+ *
+ * @param initialSize segment-size to start with
+ * @param minSize minimal segment-size in adaptive mode
+ * @param maxSize maximal segment-size in adaptive mode, which must not be bigger than
+ *                124 KiB, so each segment fits together with its header-fields into a
+ *                single stream-message to shiori
+ * @param adaptive true to adjust the segment-size at runtime, based on the measured throughput
+ *
+ * @return false, if the sizes are invalid, else true
+ */
+bool
+configureSegmentSize(const uint64_t initialSize,
+                     const uint64_t minSize,
+                     const uint64_t maxSize,
+                     const bool adaptive)
+{
+    return SegmentTuner::getInstance()->configure(initialSize, minSize, maxSize, adaptive);
 }
 
 /**
@@ -315,8 +1399,11 @@ runSnapshotFinalizeProcess(const std::string &snapshotUuid,
                            const std::string &projectId,
                            Kitsunemimi::ErrorContainer &error)
 {
+    MetricScope metric(SNAPSHOT_FINALIZE_OPERATION);
+
     // get internal client for interaction with shiori
-    HanamiMessagingClient* client = HanamiMessaging::getInstance()->shioriClient;
+    ClientLease lease;
+    ShioriConnection* client = lease.getClient();
     if(client == nullptr)
     {
         error.addMeesage("Failed to get client to shiori");
@@ -328,21 +1415,21 @@ runSnapshotFinalizeProcess(const std::string &snapshotUuid,
     Kitsunemimi::Hanami::RequestMessage requestMsg;
     requestMsg.id = "v1/cluster_snapshot";
     requestMsg.httpType = Kitsunemimi::Hanami::HttpRequestType::PUT_TYPE;
-    requestMsg.inputValues = "";
-    requestMsg.inputValues.append("{\"user_id\":\"");
-    requestMsg.inputValues.append(userId);
-    requestMsg.inputValues.append("\",\"token\":\"");
-    requestMsg.inputValues.append(token);
-    requestMsg.inputValues.append("\",\"project_id\":\"");
-    requestMsg.inputValues.append(projectId);
-    requestMsg.inputValues.append("\",\"uuid\":\"");
-    requestMsg.inputValues.append(snapshotUuid);
-    requestMsg.inputValues.append("\",\"uuid_input_file\":\"");
-    requestMsg.inputValues.append(fileUuid);
-    requestMsg.inputValues.append("\"}");
+    std::string* input = &requestMsg.inputValues;
+    input->clear();
+    input->reserve(192 + token.size());
+    input->push_back('{');
+    appendJsonField(*input, "user_id", userId);
+    appendJsonField(*input, "token", token);
+    appendJsonField(*input, "project_id", projectId);
+    appendJsonField(*input, "uuid", snapshotUuid);
+    appendJsonField(*input, "uuid_input_file", fileUuid);
+    input->push_back('}');
 
     // trigger finalizing of snapshot
     Kitsunemimi::Hanami::ResponseMessage response;
+    MetricsCollector* metrics = MetricsCollector::getInstance();
+    metrics->add(SNAPSHOT_FINALIZE_OPERATION, BYTES_SENT_FIELD, requestMsg.inputValues.size());
     if(client->triggerSakuraFile(response, requestMsg, error) == false)
     {
         error.addMeesage("Failed to trigger blossom in shiori to finalize "
@@ -350,6 +1437,10 @@ runSnapshotFinalizeProcess(const std::string &snapshotUuid,
         return false;
     }
 
+    metrics->add(SNAPSHOT_FINALIZE_OPERATION,
+                 BYTES_RECEIVED_FIELD,
+                 response.responseContent.size());
+
     // check response
     if(response.success == false)
     {
@@ -369,7 +1460,7 @@ runSnapshotFinalizeProcess(const std::string &snapshotUuid,
         return false;
     }
 
-    return true;
+    return metric.finish(true);
 }
 
 }
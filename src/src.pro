@@ -55,20 +55,57 @@ LIBS += -L../../libKitsunemimiHanamiNetwork/src/debug -lKitsunemimiHanamiNetwork
 LIBS += -L../../libKitsunemimiHanamiNetwork/src/release -lKitsunemimiHanamiNetwork
 INCLUDEPATH += ../../libKitsunemimiHanamiNetwork/include
 
-LIBS += -lssl -lcryptopp -lcrypto
+LIBS += -lssl -lcryptopp -lcrypto -llz4 -lzstd
 
 INCLUDEPATH += $$PWD \
                $$PWD/../include
 
 HEADERS += \
+    ../include/libShioriArchive/async.h \
+    ../include/libShioriArchive/column_cache.h \
+    ../include/libShioriArchive/column_view.h \
     ../include/libShioriArchive/datasets.h \
+    ../include/libShioriArchive/metadata_cache.h \
+    ../include/libShioriArchive/metrics.h \
     ../include/libShioriArchive/other.h \
+    ../include/libShioriArchive/shiori_connection.h \
+    ../include/libShioriArchive/snapshot_compression.h \
+    ../include/libShioriArchive/snapshot_delta.h \
     ../include/libShioriArchive/snapshots.h \
+    async_worker.h \
+    audit_queue.h \
+    buffer_pool.h \
+    client_pool.h \
+    crc32c.h \
+    dataset_prefetcher.h \
+    error_aggregator.h \
+    hanami_connection.h \
+    json_helper.h \
+    metrics_collector.h \
+    segment_tuner.h \
     ../../libKitsunemimiHanamiMessages/hanami_messages/shiori_messages.h
 
 SOURCES += \
+    async.cpp \
+    async_worker.cpp \
+    audit_queue.cpp \
+    buffer_pool.cpp \
+    client_pool.cpp \
+    column_cache.cpp \
+    column_view.cpp \
+    crc32c.cpp \
+    dataset_prefetcher.cpp \
     datasets.cpp \
+    error_aggregator.cpp \
+    hanami_connection.cpp \
+    json_helper.cpp \
+    metadata_cache.cpp \
+    metrics.cpp \
+    metrics_collector.cpp \
     other.cpp \
+    segment_tuner.cpp \
+    snapshot_compression.cpp \
+    snapshot_delta.cpp \
     snapshots.cpp
 
 SHIORI_PROTO_BUFFER = ../../libKitsunemimiHanamiMessages/protobuffers/shiori_messages.proto3
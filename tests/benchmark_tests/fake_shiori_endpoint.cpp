@@ -0,0 +1,291 @@
+/**
+ * @file        fake_shiori_endpoint.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+
+#include <fake_shiori_endpoint.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+#include <../../libKitsunemimiHanamiMessages/protobuffers/shiori_messages.proto3.pb.h>
+
+namespace Shiori
+{
+
+/**
+ * @brief constructor
+ *
+ * @param latencyUs time in microseconds, which each message takes
+ */
+FakeShioriEndpoint::FakeShioriEndpoint(const uint64_t latencyUs)
+{
+    m_latencyUs = latencyUs;
+    m_requestResponse = new Kitsunemimi::DataBuffer(1);
+}
+
+/**
+ * @brief destructor
+ */
+FakeShioriEndpoint::~FakeShioriEndpoint()
+{
+    delete m_requestResponse;
+}
+
+/**
+ * @brief set the response for get-requests of information of an object
+ *
+ * @param endpoint endpoint within shiori, like "v1/cluster_snapshot"
+ * @param content json-content of the response
+ */
+void
+FakeShioriEndpoint::setInformation(const std::string &endpoint,
+                                   const std::string &content)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_information[endpoint] = content;
+}
+
+/**
+ * @brief set the response for all generic requests, like the pull of a snapshot or the
+ *        request of a data-set column
+ *
+ * @param response data, which is returned by each request
+ */
+void
+FakeShioriEndpoint::setRequestResponse(const Kitsunemimi::DataBuffer &response)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    delete m_requestResponse;
+    m_requestResponse = new Kitsunemimi::DataBuffer((response.usedBufferSize / 4096) + 1);
+    memcpy(m_requestResponse->data, response.data, response.usedBufferSize);
+    m_requestResponse->usedBufferSize = response.usedBufferSize;
+}
+
+/**
+ * @brief get number of all messages and requests, which were received by the endpoint
+ *
+ * @return number of messages
+ */
+uint64_t
+FakeShioriEndpoint::getNumberOfMessages() const
+{
+    return m_numberOfMessages;
+}
+
+/**
+ * @brief get the simulated latency of each message
+ *
+ * @return latency in microseconds
+ */
+uint64_t
+FakeShioriEndpoint::getLatency() const
+{
+    return m_latencyUs;
+}
+
+/**
+ * @brief start or stop the recording of the received segments of snapshot-uploads. Each start
+ *        drops the segments and the maximum number of parallel stream-messages, which were
+ *        recorded before.
+ *
+ * @param record true to record the segments
+ */
+void
+FakeShioriEndpoint::recordUploads(const bool record)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_recordUploads = record;
+    if(record)
+    {
+        m_uploadedSegments.clear();
+        m_maxParallelStreamMessages = 0;
+    }
+}
+
+/**
+ * @brief get the recorded segments of snapshot-uploads
+ *
+ * @return copy of the segments in the order of their arrival
+ */
+std::vector<UploadedSegment>
+FakeShioriEndpoint::getUploadedSegments()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_uploadedSegments;
+}
+
+/**
+ * @brief get the maximum number of stream-messages, which were received at the same time,
+ *        since the last start of the recording
+ *
+ * @return number of stream-messages
+ */
+uint64_t
+FakeShioriEndpoint::getMaxParallelStreamMessages() const
+{
+    return m_maxParallelStreamMessages;
+}
+
+/**
+ * @brief answer a request to a sakura-file. Post-requests initialize a snapshot-upload, put-
+ *        requests finalize it and get-requests return the information set for the endpoint.
+ *
+ * @param response reference for the response
+ * @param request received request
+ *
+ * @return true
+ */
+bool
+FakeShioriEndpoint::triggerSakuraFile(Kitsunemimi::Hanami::ResponseMessage &response,
+                                      const Kitsunemimi::Hanami::RequestMessage &request,
+                                      Kitsunemimi::ErrorContainer &)
+{
+    waitLatency();
+
+    response.success = true;
+    if(request.httpType == Kitsunemimi::Hanami::POST_TYPE)
+    {
+        response.responseContent = "{\"uuid_input_file\":\"fake-input-file\"}";
+        return true;
+    }
+    if(request.httpType != Kitsunemimi::Hanami::GET_TYPE)
+    {
+        response.responseContent = "{}";
+        return true;
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    const auto it = m_information.find(request.id);
+    if(it == m_information.end())
+    {
+        response.success = false;
+        response.responseContent = "unknown endpoint '" + request.id + "'";
+        return true;
+    }
+    response.responseContent = it->second;
+
+    return true;
+}
+
+/**
+ * @brief receive a segment of a snapshot-upload and record it, if enabled
+ *
+ * @param data pointer to the serialized upload-message
+ * @param dataSize size of the serialized upload-message
+ * @param error reference for error-output
+ *
+ * @return false, if a recorded message is invalid, else true
+ */
+bool
+FakeShioriEndpoint::sendStreamMessage(const void* data,
+                                      const uint64_t dataSize,
+                                      const bool,
+                                      Kitsunemimi::ErrorContainer &error)
+{
+    const uint64_t parallel = ++m_parallelStreamMessages;
+    uint64_t maxParallel = m_maxParallelStreamMessages;
+    while(parallel > maxParallel
+          && m_maxParallelStreamMessages.compare_exchange_weak(maxParallel, parallel) == false)
+    {}
+
+    waitLatency();
+
+    bool success = true;
+    std::lock_guard<std::mutex> guard(m_lock);
+    if(m_recordUploads)
+    {
+        FileUpload_Message message;
+        if(message.ParseFromArray(data, static_cast<int>(dataSize)))
+        {
+            UploadedSegment segment;
+            segment.position = message.position();
+            segment.isLast = message.islast();
+            segment.data = message.data();
+            m_uploadedSegments.push_back(segment);
+        }
+        else
+        {
+            error.addMeesage("Fake-endpoint received invalid upload-message");
+            success = false;
+        }
+    }
+    m_parallelStreamMessages--;
+
+    return success;
+}
+
+/**
+ * @brief receive a message without response, like audit- and error-messages
+ *
+ * @return true
+ */
+bool
+FakeShioriEndpoint::sendGenericMessage(const uint32_t,
+                                       const void*,
+                                       const uint64_t,
+                                       Kitsunemimi::ErrorContainer &)
+{
+    waitLatency();
+    return true;
+}
+
+/**
+ * @brief answer a generic request with a copy of the data set by setRequestResponse, like
+ *        the network-layer returns a new buffer for each response
+ *
+ * @return buffer with the response
+ */
+Kitsunemimi::DataBuffer*
+FakeShioriEndpoint::sendGenericRequest(const uint32_t,
+                                       const void*,
+                                       const uint64_t,
+                                       Kitsunemimi::ErrorContainer &)
+{
+    waitLatency();
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    const uint64_t size = m_requestResponse->usedBufferSize;
+    Kitsunemimi::DataBuffer* result = new Kitsunemimi::DataBuffer((size / 4096) + 1);
+    memcpy(result->data, m_requestResponse->data, size);
+    result->usedBufferSize = size;
+
+    return result;
+}
+
+/**
+ * @brief count the message and wait for the simulated latency
+ */
+void
+FakeShioriEndpoint::waitLatency()
+{
+    m_numberOfMessages++;
+    if(m_latencyUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(m_latencyUs));
+    }
+}
+
+}
@@ -0,0 +1,100 @@
+/**
+ * @file        fake_shiori_endpoint.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+
+#ifndef FAKE_SHIORI_ENDPOINT_H
+#define FAKE_SHIORI_ENDPOINT_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <libShioriArchive/shiori_connection.h>
+
+namespace Shiori
+{
+
+struct UploadedSegment
+{
+    uint64_t position = 0;
+    bool isLast = false;
+    std::string data = "";
+};
+
+// in-process replacement of shiori, which answers all requests of the library without network
+// and waits a fixed time for each message to simulate the latency of the connection
+class FakeShioriEndpoint
+        : public ShioriConnection
+{
+public:
+    FakeShioriEndpoint(const uint64_t latencyUs);
+    ~FakeShioriEndpoint();
+
+    void setInformation(const std::string &endpoint, const std::string &content);
+    void setRequestResponse(const Kitsunemimi::DataBuffer &response);
+
+    uint64_t getNumberOfMessages() const;
+    uint64_t getLatency() const;
+
+    void recordUploads(const bool record);
+    std::vector<UploadedSegment> getUploadedSegments();
+    uint64_t getMaxParallelStreamMessages() const;
+
+    bool triggerSakuraFile(Kitsunemimi::Hanami::ResponseMessage &response,
+                           const Kitsunemimi::Hanami::RequestMessage &request,
+                           Kitsunemimi::ErrorContainer &error);
+    bool sendStreamMessage(const void* data,
+                           const uint64_t dataSize,
+                           const bool replyExpected,
+                           Kitsunemimi::ErrorContainer &error);
+    bool sendGenericMessage(const uint32_t subType,
+                            const void* data,
+                            const uint64_t dataSize,
+                            Kitsunemimi::ErrorContainer &error);
+    Kitsunemimi::DataBuffer* sendGenericRequest(const uint32_t subType,
+                                                const void* data,
+                                                const uint64_t dataSize,
+                                                Kitsunemimi::ErrorContainer &error);
+
+private:
+    uint64_t m_latencyUs = 0;
+    std::atomic<uint64_t> m_numberOfMessages = {0};
+
+    std::mutex m_lock;
+    std::map<std::string, std::string> m_information;
+    Kitsunemimi::DataBuffer* m_requestResponse = nullptr;
+
+    // received segments of snapshot-uploads in the order of their arrival, which are only
+    // recorded on demand, because the benchmarks upload a lot of data
+    bool m_recordUploads = false;
+    std::vector<UploadedSegment> m_uploadedSegments;
+    std::atomic<uint64_t> m_parallelStreamMessages = {0};
+    std::atomic<uint64_t> m_maxParallelStreamMessages = {0};
+
+    void waitLatency();
+};
+
+}
+
+#endif // FAKE_SHIORI_ENDPOINT_H
@@ -0,0 +1,52 @@
+/**
+ * @file        main.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <shiori_benchmark.h>
+
+#include <fstream>
+#include <iostream>
+
+/**
+ * @brief run all benchmarks and write the results as json to stdout and optionally
+ *        into a file, to compare them between releases
+ */
+int main(int argc, char *argv[])
+{
+    Shiori::ShioriBenchmark benchmark;
+    benchmark.runAll();
+
+    const std::string result = benchmark.toJson();
+    std::cout << result << std::endl;
+
+    if(argc > 1)
+    {
+        std::ofstream outputFile(argv[1]);
+        outputFile << result << std::endl;
+        if(outputFile.good() == false)
+        {
+            std::cerr << "Failed to write results into file '" << argv[1] << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,709 @@
+/**
+ * @file        shiori_benchmark.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2022 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <shiori_benchmark.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+#include <libKitsunemimiHanamiCommon/component_support.h>
+
+#include <libShioriArchive/column_cache.h>
+#include <libShioriArchive/column_view.h>
+#include <libShioriArchive/datasets.h>
+#include <libShioriArchive/metadata_cache.h>
+#include <libShioriArchive/other.h>
+#include <libShioriArchive/snapshot_compression.h>
+#include <libShioriArchive/snapshot_delta.h>
+#include <libShioriArchive/snapshots.h>
+
+using Kitsunemimi::Hanami::SupportedComponents;
+
+namespace Shiori
+{
+
+// amount of data, which is processed by each benchmark with a payload
+const uint64_t BYTES_PER_BENCHMARK = 256 * 1024 * 1024;
+const uint64_t NUMBER_OF_CACHED_COLUMNS = 64;
+const uint64_t CACHED_COLUMN_SIZE = 1024 * 1024;
+const uint64_t CACHE_REQUESTS_PER_THREAD = 2000;
+const uint64_t AUDIT_MESSAGES_PER_THREAD = 100000;
+const uint64_t DIRECT_AUDIT_MESSAGES_PER_THREAD = 2000;
+const uint64_t ERROR_MESSAGES_PER_THREAD = 100000;
+
+// amount of data, which is transferred over the fake endpoint by each network-benchmark
+const uint64_t BYTES_PER_NETWORK_BENCHMARK = 64 * 1024 * 1024;
+const uint64_t FAKE_ENDPOINT_LATENCY_US = 50;
+const uint32_t NUMBER_OF_UPLOAD_WORKERS = 4;
+const uint64_t NETWORK_REQUESTS_PER_THREAD = 500;
+
+/**
+ * @brief constructor
+ */
+ShioriBenchmark::ShioriBenchmark()
+{
+    m_payloadSizes = {64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024};
+    m_threadCounts = {1, 2, 4, 8};
+
+    // all requests of the library are answered in-process by the fake endpoint. It is never
+    // deleted, because the pool of clients has no way to remove it again.
+    m_endpoint = new FakeShioriEndpoint(FAKE_ENDPOINT_LATENCY_US);
+    m_endpoint->setInformation("v1/cluster_snapshot",
+                               "{\"uuid\":\"benchmark-snapshot\","
+                               "\"name\":\"benchmark\","
+                               "\"location\":\"benchmark-snapshot-location\","
+                               "\"header\":{}}");
+    m_endpoint->setInformation("v1/data_set",
+                               "{\"uuid\":\"benchmark-data-set\","
+                               "\"name\":\"benchmark\","
+                               "\"type\":\"csv\","
+                               "\"location\":\"benchmark-data-set-location\"}");
+    addShioriConnection(m_endpoint);
+    SupportedComponents::getInstance()->support[Kitsunemimi::Hanami::SHIORI] = true;
+}
+
+/**
+ * @brief run all benchmarks
+ */
+void
+ShioriBenchmark::runAll()
+{
+    for(const uint64_t payloadSize : m_payloadSizes)
+    {
+        for(const uint32_t numberOfThreads : m_threadCounts) {
+            benchmarkCompression(payloadSize, numberOfThreads);
+        }
+        benchmarkRestore(payloadSize);
+        benchmarkDelta(payloadSize);
+        benchmarkColumnView(payloadSize);
+        benchmarkSnapshotUpload(payloadSize);
+        benchmarkSnapshotDownload(payloadSize);
+    }
+
+    // the network-benchmarks run before the column-cache benchmark, because this one
+    // initializes the disk-tier, which would serve the requested data-set columns
+    for(const uint32_t numberOfThreads : m_threadCounts)
+    {
+        benchmarkDatasetFetch(numberOfThreads);
+        benchmarkInformationLookup(numberOfThreads);
+        benchmarkAuditMessages(numberOfThreads);
+        benchmarkErrorMessages(numberOfThreads);
+    }
+
+    for(const uint32_t numberOfThreads : m_threadCounts) {
+        benchmarkColumnCache(numberOfThreads);
+    }
+}
+
+/**
+ * @brief convert all results into a json-string
+ *
+ * @return json-string with the results
+ */
+const std::string
+ShioriBenchmark::toJson() const
+{
+    std::string output = "{\n  \"library\": \"libShioriArchive\",\n";
+    output += "  \"endpoint_latency_us\": " + std::to_string(m_endpoint->getLatency()) + ",\n";
+    output += "  \"results\": [";
+
+    for(uint64_t i = 0; i < m_results.size(); i++)
+    {
+        const Result* result = &m_results[i];
+        const double operationsPerSec = static_cast<double>(result->numberOfOperations)
+                                        / result->durationSec;
+        const double avgLatencyUs = (result->durationSec * result->numberOfThreads * 1000000.0)
+                                    / static_cast<double>(result->numberOfOperations);
+
+        output += i == 0 ? "\n" : ",\n";
+        output += "    {";
+        output += "\"name\": \"" + result->name + "\", ";
+        output += "\"variant\": \"" + result->variant + "\", ";
+        output += "\"payload_size\": " + std::to_string(result->payloadSize) + ", ";
+        output += "\"threads\": " + std::to_string(result->numberOfThreads) + ", ";
+        output += "\"operations\": " + std::to_string(result->numberOfOperations) + ", ";
+        output += "\"duration_sec\": " + std::to_string(result->durationSec) + ", ";
+        output += "\"ops_per_sec\": " + std::to_string(operationsPerSec) + ", ";
+        if(result->payloadSize > 0)
+        {
+            const double mbPerSec = (operationsPerSec * static_cast<double>(result->payloadSize))
+                                    / (1024.0 * 1024.0);
+            output += "\"mb_per_sec\": " + std::to_string(mbPerSec) + ", ";
+        }
+        output += "\"avg_latency_us\": " + std::to_string(avgLatencyUs);
+        output += "}";
+    }
+
+    output += "\n  ]\n}";
+
+    return output;
+}
+
+/**
+ * @brief measure compression and decompression of snapshots
+ *
+ * @param payloadSize size of the snapshot
+ * @param numberOfThreads number of threads, which process snapshots at the same time
+ */
+void
+ShioriBenchmark::benchmarkCompression(const uint64_t payloadSize,
+                                      const uint32_t numberOfThreads)
+{
+    Kitsunemimi::DataBuffer* payload = createPayload(payloadSize);
+    const uint64_t operationsPerThread = std::max(BYTES_PER_BENCHMARK
+                                                  / payloadSize
+                                                  / numberOfThreads,
+                                                  static_cast<uint64_t>(1));
+
+    const std::vector<SnapshotCompression> compressions = {LZ4_COMPRESSION, ZSTD_COMPRESSION};
+    for(const SnapshotCompression compression : compressions)
+    {
+        const std::string name = getCompressionName(compression);
+
+        double duration = runParallel(numberOfThreads, operationsPerThread,
+                                      [&](const uint32_t, const uint64_t)
+        {
+            Kitsunemimi::ErrorContainer error;
+            delete compressSnapshot(*payload, compression, error);
+        });
+        addResult("snapshot_compress", name, payloadSize, numberOfThreads,
+                  operationsPerThread * numberOfThreads, duration);
+
+        Kitsunemimi::ErrorContainer error;
+        Kitsunemimi::DataBuffer* compressed = compressSnapshot(*payload, compression, error);
+        duration = runParallel(numberOfThreads, operationsPerThread,
+                               [&](const uint32_t, const uint64_t)
+        {
+            Kitsunemimi::ErrorContainer error;
+            delete decompressSnapshot(*compressed, error);
+        });
+        addResult("snapshot_decompress", name, payloadSize, numberOfThreads,
+                  operationsPerThread * numberOfThreads, duration);
+        delete compressed;
+    }
+
+    delete payload;
+}
+
+/**
+ * @brief measure the restore of a compressed snapshot into an existing buffer
+ *
+ * @param payloadSize size of the snapshot
+ */
+void
+ShioriBenchmark::benchmarkRestore(const uint64_t payloadSize)
+{
+    Kitsunemimi::DataBuffer* payload = createPayload(payloadSize);
+    Kitsunemimi::DataBuffer* target = createPayload(payloadSize);
+    const uint64_t operations = std::max(BYTES_PER_BENCHMARK / payloadSize,
+                                         static_cast<uint64_t>(1));
+
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* compressed = compressSnapshot(*payload, LZ4_COMPRESSION, error);
+    const double duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        decompressSnapshot(static_cast<uint8_t*>(target->data), payloadSize, *compressed, error);
+    });
+    addResult("snapshot_restore", "lz4", payloadSize, 1, operations, duration);
+
+    delete compressed;
+    delete target;
+    delete payload;
+}
+
+/**
+ * @brief measure creation and rebuild of delta-snapshots, where 1% of the chunks changed
+ *
+ * @param payloadSize size of the snapshot
+ */
+void
+ShioriBenchmark::benchmarkDelta(const uint64_t payloadSize)
+{
+    Kitsunemimi::DataBuffer* parent = createPayload(payloadSize);
+    Kitsunemimi::DataBuffer* current = createPayload(payloadSize);
+    Kitsunemimi::DataBuffer* target = createPayload(payloadSize);
+    const uint64_t operations = std::max(BYTES_PER_BENCHMARK / payloadSize / 4,
+                                         static_cast<uint64_t>(1));
+
+    // change one byte in every 100th chunk of 8 KiB
+    uint8_t* u8Current = static_cast<uint8_t*>(current->data);
+    memcpy(u8Current, parent->data, payloadSize);
+    for(uint64_t pos = 0; pos < payloadSize; pos += 100 * 8 * 1024) {
+        u8Current[pos]++;
+    }
+
+    SnapshotManifest parentManifest;
+    double duration = runParallel(1, operations, [&](const uint32_t, const uint64_t) {
+        createSnapshotManifest(parentManifest, *parent);
+    });
+    addResult("snapshot_delta", "manifest", payloadSize, 1, operations, duration);
+    parentManifest.location = "benchmark";
+
+    SnapshotManifest manifest;
+    duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        delete createDeltaSnapshot(manifest, *current, parentManifest, error);
+    });
+    addResult("snapshot_delta", "create", payloadSize, 1, operations, duration);
+
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* delta = createDeltaSnapshot(manifest, *current, parentManifest, error);
+    duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        applyDeltaSnapshot(static_cast<uint8_t*>(target->data),
+                           payloadSize,
+                           *delta,
+                           *parent,
+                           error);
+    });
+    addResult("snapshot_delta", "apply", payloadSize, 1, operations, duration);
+
+    delete delta;
+    delete target;
+    delete current;
+    delete parent;
+}
+
+/**
+ * @brief measure the conversion of raw uint8-columns into normalized float-values
+ *
+ * @param payloadSize size of the raw column
+ */
+void
+ShioriBenchmark::benchmarkColumnView(const uint64_t payloadSize)
+{
+    Kitsunemimi::DataBuffer* payload = createPayload(payloadSize);
+    const uint64_t operations = std::max(BYTES_PER_BENCHMARK / payloadSize,
+                                         static_cast<uint64_t>(1));
+
+    ColumnConversion conversion;
+    conversion.sourceType = UINT8_VALUE_TYPE;
+    conversion.scale = 1.0f / 255.0f;
+    ColumnView view;
+    const double duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        view.convert(payload->data, payloadSize, conversion, error);
+    });
+    addResult("dataset_column_view", "uint8_normalize", payloadSize, 1, operations, duration);
+
+    delete payload;
+}
+
+/**
+ * @brief measure the upload of snapshots to the fake endpoint, with a single sending thread
+ *        and pipelined with multiple sending threads
+ *
+ * @param payloadSize size of the snapshot
+ */
+void
+ShioriBenchmark::benchmarkSnapshotUpload(const uint64_t payloadSize)
+{
+    Kitsunemimi::DataBuffer* payload = createPayload(payloadSize);
+    const uint64_t operations = std::max(BYTES_PER_NETWORK_BENCHMARK / payloadSize,
+                                         static_cast<uint64_t>(1));
+
+    for(const bool pipelined : {false, true})
+    {
+        const double duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+        {
+            Kitsunemimi::ErrorContainer error;
+            std::string fileUuid = "";
+            if(runSnapshotInitProcess(fileUuid,
+                                      "benchmark-snapshot",
+                                      "benchmark",
+                                      "user",
+                                      "project",
+                                      payloadSize,
+                                      "{}",
+                                      "token",
+                                      error) == false)
+            {
+                return;
+            }
+
+            uint64_t targetPos = 0;
+            if(pipelined)
+            {
+                std::vector<SegmentState> segmentStates;
+                sendDataPipelined(payload,
+                                  targetPos,
+                                  "benchmark-snapshot",
+                                  fileUuid,
+                                  NUMBER_OF_UPLOAD_WORKERS,
+                                  segmentStates,
+                                  error);
+            }
+            else
+            {
+                sendData(payload, targetPos, "benchmark-snapshot", fileUuid, error);
+            }
+
+            runSnapshotFinalizeProcess("benchmark-snapshot",
+                                       fileUuid,
+                                       "token",
+                                       "user",
+                                       "project",
+                                       error);
+        });
+
+        const std::string variant = pipelined
+                                    ? "pipelined_" + std::to_string(NUMBER_OF_UPLOAD_WORKERS)
+                                    : "sequential";
+        addResult("snapshot_upload", variant, payloadSize, 1, operations, duration);
+    }
+
+    delete payload;
+}
+
+/**
+ * @brief measure the download of snapshots from the fake endpoint, which are restored
+ *        by the encoding in their header
+ *
+ * @param payloadSize size of the snapshot
+ */
+void
+ShioriBenchmark::benchmarkSnapshotDownload(const uint64_t payloadSize)
+{
+    Kitsunemimi::DataBuffer* payload = createPayload(payloadSize);
+    Kitsunemimi::DataBuffer* target = createPayload(payloadSize);
+    const uint64_t operations = std::max(BYTES_PER_NETWORK_BENCHMARK / payloadSize,
+                                         static_cast<uint64_t>(1));
+
+    SnapshotInformation snapshot;
+    snapshot.uuid = "benchmark-snapshot";
+    snapshot.location = "benchmark-snapshot-location";
+
+    // uncompressed snapshot
+    snapshot.header = "{}";
+    m_endpoint->setRequestResponse(*payload);
+    double duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        delete getSnapshotData(snapshot, error);
+    });
+    addResult("snapshot_download", "raw", payloadSize, 1, operations, duration);
+
+    // lz4-compressed snapshot
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* compressed = compressSnapshot(*payload, LZ4_COMPRESSION, error);
+    if(compressed != nullptr)
+    {
+        snapshot.header = "{\"compression\":\"lz4\"}";
+        m_endpoint->setRequestResponse(*compressed);
+        duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+        {
+            Kitsunemimi::ErrorContainer error;
+            delete getSnapshotData(snapshot, error);
+        });
+        addResult("snapshot_download", "lz4", payloadSize, 1, operations, duration);
+
+        duration = runParallel(1, operations, [&](const uint32_t, const uint64_t)
+        {
+            Kitsunemimi::ErrorContainer error;
+            uint64_t snapshotSize = 0;
+            getSnapshotData(target->data, snapshotSize, payloadSize, snapshot, error);
+        });
+        addResult("snapshot_download", "lz4_into_buffer", payloadSize, 1, operations, duration);
+        delete compressed;
+    }
+
+    delete target;
+    delete payload;
+}
+
+/**
+ * @brief measure the latency of requests of data-set columns from the fake endpoint, without
+ *        column-cache and without cached information of the data-set
+ *
+ * @param numberOfThreads number of threads, which request columns at the same time
+ */
+void
+ShioriBenchmark::benchmarkDatasetFetch(const uint32_t numberOfThreads)
+{
+    Kitsunemimi::DataBuffer* column = createPayload(CACHED_COLUMN_SIZE);
+    m_endpoint->setRequestResponse(*column);
+    ColumnCache::getInstance()->setMemoryLimit(0);
+    MetadataCache::getInstance()->setTimeToLive(0);
+
+    const double duration = runParallel(numberOfThreads, NETWORK_REQUESTS_PER_THREAD,
+                                        [&](const uint32_t, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        delete getDatasetData("token", "benchmark-data-set", "column", error);
+    });
+    addResult("dataset_fetch", "uncached", CACHED_COLUMN_SIZE, numberOfThreads,
+              NETWORK_REQUESTS_PER_THREAD * numberOfThreads, duration);
+
+    delete column;
+}
+
+/**
+ * @brief measure the lookup of the information of a snapshot, which is requested from the
+ *        fake endpoint for each lookup or is served by the metadata-cache
+ *
+ * @param numberOfThreads number of threads, which request information at the same time
+ */
+void
+ShioriBenchmark::benchmarkInformationLookup(const uint32_t numberOfThreads)
+{
+    MetadataCache* cache = MetadataCache::getInstance();
+
+    for(const bool cached : {false, true})
+    {
+        cache->clear();
+        cache->setTimeToLive(cached ? 60000 : 0);
+
+        const double duration = runParallel(numberOfThreads, NETWORK_REQUESTS_PER_THREAD,
+                                            [&](const uint32_t, const uint64_t)
+        {
+            Kitsunemimi::ErrorContainer error;
+            SnapshotInformation snapshot;
+            getSnapshotInformation(snapshot, "benchmark-snapshot", "token", error);
+        });
+        addResult("snapshot_information", cached ? "cached" : "uncached", 0, numberOfThreads,
+                  NETWORK_REQUESTS_PER_THREAD * numberOfThreads, duration);
+    }
+
+    cache->clear();
+    cache->setTimeToLive(0);
+}
+
+/**
+ * @brief measure the latency of requests of data-set columns, which are served by the cache
+ *
+ * @param numberOfThreads number of threads, which request columns at the same time
+ */
+void
+ShioriBenchmark::benchmarkColumnCache(const uint32_t numberOfThreads)
+{
+    ColumnCache* cache = ColumnCache::getInstance();
+    Kitsunemimi::DataBuffer* column = createPayload(CACHED_COLUMN_SIZE);
+
+    // memory-tier
+    cache->setMemoryLimit(NUMBER_OF_CACHED_COLUMNS * CACHED_COLUMN_SIZE * 2);
+    for(uint64_t i = 0; i < NUMBER_OF_CACHED_COLUMNS; i++) {
+        cache->add("benchmark", "column_" + std::to_string(i), column);
+    }
+
+    double duration = runParallel(numberOfThreads, CACHE_REQUESTS_PER_THREAD,
+                                  [&](const uint32_t threadId, const uint64_t i)
+    {
+        const uint64_t columnId = (threadId * 7 + i) % NUMBER_OF_CACHED_COLUMNS;
+        delete cache->get("benchmark", "column_" + std::to_string(columnId));
+    });
+    addResult("dataset_column_cache", "memory", CACHED_COLUMN_SIZE, numberOfThreads,
+              CACHE_REQUESTS_PER_THREAD * numberOfThreads, duration);
+
+    // disk-tier
+    const std::filesystem::path cacheDir = std::filesystem::temp_directory_path()
+                                           / "shiori_benchmark_cache";
+    Kitsunemimi::ErrorContainer error;
+    std::filesystem::create_directories(cacheDir);
+    if(cache->initDiskCache(cacheDir.string(),
+                            NUMBER_OF_CACHED_COLUMNS * CACHED_COLUMN_SIZE * 2,
+                            error))
+    {
+        cache->setMemoryLimit(0);
+        for(uint64_t i = 0; i < NUMBER_OF_CACHED_COLUMNS; i++) {
+            cache->add("benchmark", "column_" + std::to_string(i), column);
+        }
+
+        duration = runParallel(numberOfThreads, CACHE_REQUESTS_PER_THREAD,
+                               [&](const uint32_t threadId, const uint64_t i)
+        {
+            const uint64_t columnId = (threadId * 7 + i) % NUMBER_OF_CACHED_COLUMNS;
+            delete cache->get("benchmark", "column_" + std::to_string(columnId));
+        });
+        addResult("dataset_column_cache", "disk", CACHED_COLUMN_SIZE, numberOfThreads,
+                  CACHE_REQUESTS_PER_THREAD * numberOfThreads, duration);
+    }
+
+    cache->clear();
+    std::filesystem::remove_all(cacheDir);
+    delete column;
+}
+
+/**
+ * @brief measure how many audit-messages per second are sent to the fake endpoint, over the
+ *        audit-queue and directly. The time of the queue includes the stop of the queue, so
+ *        all queued messages are sent to the endpoint within the measured time.
+ *
+ * @param numberOfThreads number of threads, which send audit-messages at the same time
+ */
+void
+ShioriBenchmark::benchmarkAuditMessages(const uint32_t numberOfThreads)
+{
+    auto send = [](const uint32_t, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        sendAuditMessage("benchmark", "v1/benchmark", "user", Kitsunemimi::Hanami::GET_TYPE, error);
+    };
+
+    // over the audit-queue
+    const uint64_t numberOfMessages = m_endpoint->getNumberOfMessages();
+    startAuditQueue(1000, 10);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    runParallel(numberOfThreads, AUDIT_MESSAGES_PER_THREAD, send);
+    stopAuditQueue();
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    if(m_endpoint->getNumberOfMessages() == numberOfMessages) {
+        std::cerr << "Audit-queue didn't send any message to the fake endpoint" << std::endl;
+    }
+    addResult("audit_message", "queue", 0, numberOfThreads,
+              AUDIT_MESSAGES_PER_THREAD * numberOfThreads, duration.count());
+
+    // directly, because the audit-queue is stopped
+    const double directDuration = runParallel(numberOfThreads,
+                                              DIRECT_AUDIT_MESSAGES_PER_THREAD,
+                                              send);
+    addResult("audit_message", "direct", 0, numberOfThreads,
+              DIRECT_AUDIT_MESSAGES_PER_THREAD * numberOfThreads, directDuration);
+}
+
+/**
+ * @brief measure how many error-messages per second are handled, including the flush of the
+ *        combined messages to the fake endpoint
+ *
+ * @param numberOfThreads number of threads, which send error-messages at the same time
+ */
+void
+ShioriBenchmark::benchmarkErrorMessages(const uint32_t numberOfThreads)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    runParallel(numberOfThreads, ERROR_MESSAGES_PER_THREAD,
+                [&](const uint32_t threadId, const uint64_t)
+    {
+        Kitsunemimi::ErrorContainer error;
+        sendErrorMessage("user", "benchmark-error " + std::to_string(threadId), error);
+    });
+    Kitsunemimi::ErrorContainer error;
+    flushErrorMessages(error);
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    addResult("error_message", "aggregated", 0, numberOfThreads,
+              ERROR_MESSAGES_PER_THREAD * numberOfThreads, duration.count());
+}
+
+/**
+ * @brief run a function with multiple threads at the same time and measure the duration
+ *
+ * @param numberOfThreads number of threads
+ * @param operationsPerThread number of calls of the function by each thread
+ * @param function function to measure, which gets the id of the thread and the number
+ *                 of the call
+ *
+ * @return duration in seconds until all threads are finished
+ */
+double
+ShioriBenchmark::runParallel(const uint32_t numberOfThreads,
+                             const uint64_t operationsPerThread,
+                             const std::function<void(const uint32_t, const uint64_t)> &function)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for(uint32_t threadId = 0; threadId < numberOfThreads; threadId++)
+    {
+        threads.emplace_back([&, threadId]()
+        {
+            for(uint64_t i = 0; i < operationsPerThread; i++) {
+                function(threadId, i);
+            }
+        });
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    return duration.count();
+}
+
+/**
+ * @brief add new result to the list of results
+ *
+ * @param name name of the benchmark
+ * @param variant variant of the benchmark
+ * @param payloadSize number of bytes per operation, or 0 if not relevant
+ * @param numberOfThreads number of threads
+ * @param numberOfOperations total number of operations of all threads
+ * @param durationSec duration in seconds
+ */
+void
+ShioriBenchmark::addResult(const std::string &name,
+                           const std::string &variant,
+                           const uint64_t payloadSize,
+                           const uint32_t numberOfThreads,
+                           const uint64_t numberOfOperations,
+                           const double durationSec)
+{
+    Result result;
+    result.name = name;
+    result.variant = variant;
+    result.payloadSize = payloadSize;
+    result.numberOfThreads = numberOfThreads;
+    result.numberOfOperations = numberOfOperations;
+    result.durationSec = durationSec;
+    m_results.push_back(result);
+}
+
+/**
+ * @brief create a payload, which is similar to the weights of a cluster. Most values come from
+ *        a small set of values and are compressible, the rest are random.
+ *
+ * @param size size of the payload in bytes
+ *
+ * @return pointer to new data-buffer with the payload
+ */
+Kitsunemimi::DataBuffer*
+ShioriBenchmark::createPayload(const uint64_t size)
+{
+    Kitsunemimi::DataBuffer* buffer = new Kitsunemimi::DataBuffer((size / 4096) + 1);
+    uint8_t* u8Buffer = static_cast<uint8_t*>(buffer->data);
+    std::mt19937 generator(42);
+
+    for(uint64_t pos = 0; pos + sizeof(float) <= size; pos += sizeof(float))
+    {
+        const uint32_t random = generator();
+        float value = static_cast<float>(random % 64) * 0.01f;
+        if(random % 8 == 0) {
+            value = static_cast<float>(random) / 4294967296.0f;
+        }
+        memcpy(&u8Buffer[pos], &value, sizeof(float));
+    }
+
+    buffer->usedBufferSize = size;
+
+    return buffer;
+}
+
+}
@@ -0,0 +1,89 @@
+/**
+ * @file        shiori_benchmark.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef SHIORI_BENCHMARK_H
+#define SHIORI_BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <fake_shiori_endpoint.h>
+
+namespace Kitsunemimi {
+struct DataBuffer;
+}
+
+namespace Shiori
+{
+
+class ShioriBenchmark
+{
+public:
+    ShioriBenchmark();
+
+    void runAll();
+    const std::string toJson() const;
+
+private:
+    struct Result
+    {
+        std::string name = "";
+        std::string variant = "";
+        uint64_t payloadSize = 0;
+        uint32_t numberOfThreads = 0;
+        uint64_t numberOfOperations = 0;
+        double durationSec = 0.0;
+    };
+
+    std::vector<Result> m_results;
+    std::vector<uint64_t> m_payloadSizes;
+    std::vector<uint32_t> m_threadCounts;
+    FakeShioriEndpoint* m_endpoint = nullptr;
+
+    void benchmarkCompression(const uint64_t payloadSize, const uint32_t numberOfThreads);
+    void benchmarkRestore(const uint64_t payloadSize);
+    void benchmarkDelta(const uint64_t payloadSize);
+    void benchmarkColumnView(const uint64_t payloadSize);
+    void benchmarkSnapshotUpload(const uint64_t payloadSize);
+    void benchmarkSnapshotDownload(const uint64_t payloadSize);
+    void benchmarkDatasetFetch(const uint32_t numberOfThreads);
+    void benchmarkInformationLookup(const uint32_t numberOfThreads);
+    void benchmarkColumnCache(const uint32_t numberOfThreads);
+    void benchmarkAuditMessages(const uint32_t numberOfThreads);
+    void benchmarkErrorMessages(const uint32_t numberOfThreads);
+
+    double runParallel(const uint32_t numberOfThreads,
+                       const uint64_t operationsPerThread,
+                       const std::function<void(const uint32_t, const uint64_t)> &function);
+    void addResult(const std::string &name,
+                   const std::string &variant,
+                   const uint64_t payloadSize,
+                   const uint32_t numberOfThreads,
+                   const uint64_t numberOfOperations,
+                   const double durationSec);
+    Kitsunemimi::DataBuffer* createPayload(const uint64_t size);
+};
+
+}
+
+#endif // SHIORI_BENCHMARK_H
@@ -0,0 +1,178 @@
+/**
+ * @file        buffer_pool_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <buffer_pool_test.h>
+
+#include <limits>
+#include <thread>
+
+#include <buffer_pool.h>
+
+namespace Shiori
+{
+
+BufferPool_Test::BufferPool_Test()
+    : Kitsunemimi::CompareTestHelper("BufferPool_Test")
+{
+    acquire_test();
+    release_test();
+    setLimit_test();
+    pooledBuffer_test();
+}
+
+/**
+ * @brief acquire_test
+ */
+void
+BufferPool_Test::acquire_test()
+{
+    BufferPool* pool = BufferPool::getInstance();
+    Kitsunemimi::ErrorContainer error;
+    uint64_t capacity = 0;
+
+    // each size is rounded up to the next size-class
+    const std::vector<std::pair<uint64_t, uint64_t>> sizes = {{1, 1024},
+                                                             {1024, 1024},
+                                                             {1025, 2048},
+                                                             {100000, 131072},
+                                                             {64 * 1024 * 1024,
+                                                              64 * 1024 * 1024}};
+    for(const auto &[size, expectedCapacity] : sizes)
+    {
+        uint8_t* buffer = pool->acquire(capacity, size, error);
+        TEST_NOT_EQUAL(buffer, nullptr);
+        TEST_EQUAL(capacity, expectedCapacity);
+        pool->release(buffer, capacity);
+    }
+
+    // sizes above the biggest size-class are allocated with their exact size
+    const uint64_t bigSize = 64 * 1024 * 1024 + 1;
+    const uint64_t allocatedSize = pool->getAllocatedSize();
+    uint8_t* buffer = pool->acquire(capacity, bigSize, error);
+    TEST_NOT_EQUAL(buffer, nullptr);
+    TEST_EQUAL(capacity, bigSize);
+    TEST_EQUAL(pool->getAllocatedSize(), allocatedSize + bigSize);
+    pool->release(buffer, capacity);
+    TEST_EQUAL(pool->getAllocatedSize(), allocatedSize);
+}
+
+/**
+ * @brief release_test
+ */
+void
+BufferPool_Test::release_test()
+{
+    BufferPool* pool = BufferPool::getInstance();
+    Kitsunemimi::ErrorContainer error;
+    uint64_t capacity = 0;
+
+    // released buffer is used again for the same size-class
+    uint8_t* buffer = pool->acquire(capacity, 100, error);
+    pool->release(buffer, capacity);
+    const uint64_t allocatedSize = pool->getAllocatedSize();
+    TEST_EQUAL(pool->acquire(capacity, 1000, error), buffer);
+    TEST_EQUAL(pool->getAllocatedSize(), allocatedSize);
+    pool->release(buffer, capacity);
+
+    // buffers of a finished thread are used by other threads
+    uint8_t* threadBuffer = nullptr;
+    std::thread thread([&]()
+    {
+        uint64_t threadCapacity = 0;
+        Kitsunemimi::ErrorContainer threadError;
+        threadBuffer = pool->acquire(threadCapacity, 3 * 1024 * 1024, threadError);
+        pool->release(threadBuffer, threadCapacity);
+    });
+    thread.join();
+    const uint64_t allocatedAfterThread = pool->getAllocatedSize();
+    TEST_EQUAL(pool->acquire(capacity, 3 * 1024 * 1024, error), threadBuffer);
+    TEST_EQUAL(pool->getAllocatedSize(), allocatedAfterThread);
+    pool->release(threadBuffer, capacity);
+}
+
+/**
+ * @brief setLimit_test
+ */
+void
+BufferPool_Test::setLimit_test()
+{
+    BufferPool* pool = BufferPool::getInstance();
+    Kitsunemimi::ErrorContainer error;
+    uint64_t capacity = 0;
+    uint64_t smallCapacity = 0;
+
+    // no limit by default
+    TEST_EQUAL(pool->getLimit(), std::numeric_limits<uint64_t>::max());
+
+    // lower limit removes the free buffers
+    pool->setLimit(0);
+    const uint64_t allocatedSize = pool->getAllocatedSize();
+    TEST_EQUAL(allocatedSize, 0);
+
+    // limit for exactly one buffer of 4 KiB
+    pool->setLimit(allocatedSize + 4096);
+    TEST_EQUAL(pool->getLimit(), allocatedSize + 4096);
+    uint8_t* buffer = pool->acquire(capacity, 3000, error);
+    TEST_NOT_EQUAL(buffer, nullptr);
+    TEST_EQUAL(pool->acquire(smallCapacity, 100, error), nullptr);
+    TEST_EQUAL(pool->acquire(smallCapacity, 8192, error), nullptr);
+
+    // the free buffer of the other size-class is removed for the new one
+    pool->release(buffer, capacity);
+    buffer = pool->acquire(smallCapacity, 100, error);
+    TEST_NOT_EQUAL(buffer, nullptr);
+    TEST_EQUAL(pool->getAllocatedSize(), allocatedSize + 1024);
+    pool->release(buffer, smallCapacity);
+
+    pool->setLimit(DEFAULT_BUFFER_POOL_LIMIT);
+}
+
+/**
+ * @brief pooledBuffer_test
+ */
+void
+BufferPool_Test::pooledBuffer_test()
+{
+    BufferPool* pool = BufferPool::getInstance();
+    Kitsunemimi::ErrorContainer error;
+
+    uint8_t* firstBuffer = nullptr;
+    {
+        PooledBuffer buffer;
+        firstBuffer = buffer.get(100, error);
+        TEST_NOT_EQUAL(firstBuffer, nullptr);
+
+        // same buffer, while big enough
+        TEST_EQUAL(buffer.get(1024, error), firstBuffer);
+        TEST_NOT_EQUAL(buffer.get(1025, error), nullptr);
+    }
+    const uint64_t allocatedSize = pool->getAllocatedSize();
+
+    // buffer was given back by the destructor
+    {
+        PooledBuffer buffer;
+        TEST_EQUAL(buffer.get(100, error), firstBuffer);
+    }
+    TEST_EQUAL(pool->getAllocatedSize(), allocatedSize);
+}
+
+}
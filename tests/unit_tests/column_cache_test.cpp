@@ -0,0 +1,330 @@
+/**
+ * @file        column_cache_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <column_cache_test.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+#include <libShioriArchive/column_cache.h>
+
+namespace Shiori
+{
+
+const uint64_t TEST_COLUMN_SIZE = 10000;
+// header of a cache-file with magic, size of the key and size of the data
+const uint64_t CACHE_FILE_HEADER_SIZE = 24;
+const uint64_t CACHE_FILE_MAGIC = 0x314c4f4349524f48;
+
+/**
+ * @brief create a column, which has different content for each id
+ *
+ * @param id id of the column
+ *
+ * @return pointer to new data-buffer with the column
+ */
+static Kitsunemimi::DataBuffer*
+createColumn(const uint8_t id)
+{
+    Kitsunemimi::DataBuffer* buffer = new Kitsunemimi::DataBuffer((TEST_COLUMN_SIZE / 4096) + 1);
+    uint8_t* u8Buffer = static_cast<uint8_t*>(buffer->data);
+    for(uint64_t i = 0; i < TEST_COLUMN_SIZE; i++) {
+        u8Buffer[i] = static_cast<uint8_t>(i % 251) ^ id;
+    }
+    buffer->usedBufferSize = TEST_COLUMN_SIZE;
+
+    return buffer;
+}
+
+/**
+ * @brief check if a column from the cache is equal to the original column, and delete it
+ *
+ * @param result column from the cache
+ * @param id id of the original column
+ *
+ * @return true, if equal, else false
+ */
+static bool
+checkColumn(Kitsunemimi::DataBuffer* result,
+            const uint8_t id)
+{
+    if(result == nullptr) {
+        return false;
+    }
+
+    Kitsunemimi::DataBuffer* original = createColumn(id);
+    const bool isEqual = result->usedBufferSize == TEST_COLUMN_SIZE
+                         && memcmp(result->data, original->data, TEST_COLUMN_SIZE) == 0;
+    delete original;
+    delete result;
+
+    return isEqual;
+}
+
+/**
+ * @brief get the paths of all cache-files within a directory
+ *
+ * @param cacheDir directory of the disk-tier
+ *
+ * @return list of paths
+ */
+static std::vector<std::filesystem::path>
+getCacheFiles(const std::filesystem::path &cacheDir)
+{
+    std::vector<std::filesystem::path> result;
+    for(const auto &dirEntry : std::filesystem::directory_iterator(cacheDir))
+    {
+        if(dirEntry.path().extension() == ".column") {
+            result.push_back(dirEntry.path());
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief get the directory of the disk-tier for the tests
+ *
+ * @return path of the directory
+ */
+static const std::filesystem::path
+getCacheDir()
+{
+    return std::filesystem::temp_directory_path() / "shiori_column_cache_test";
+}
+
+ColumnCache_Test::ColumnCache_Test()
+    : Kitsunemimi::CompareTestHelper("ColumnCache_Test")
+{
+    std::filesystem::remove_all(getCacheDir());
+
+    memoryTier_test();
+    diskTier_test();
+    initDiskCache_test();
+    getRange_test();
+
+    ColumnCache::getInstance()->clear();
+    std::filesystem::remove_all(getCacheDir());
+}
+
+/**
+ * @brief memoryTier_test
+ */
+void
+ColumnCache_Test::memoryTier_test()
+{
+    ColumnCache* cache = ColumnCache::getInstance();
+    Kitsunemimi::DataBuffer* column1 = createColumn(1);
+    Kitsunemimi::DataBuffer* column2 = createColumn(2);
+    Kitsunemimi::DataBuffer* column3 = createColumn(3);
+
+    // disabled memory-tier
+    cache->setMemoryLimit(0);
+    cache->add("location", "column1", column1);
+    TEST_EQUAL(cache->get("location", "column1"), nullptr);
+
+    // space for two columns
+    cache->setMemoryLimit(2 * TEST_COLUMN_SIZE);
+    cache->add("location", "column1", column1);
+    cache->add("location", "column2", column2);
+    TEST_EQUAL(checkColumn(cache->get("location", "column1"), 1), true);
+    TEST_EQUAL(checkColumn(cache->get("location", "column2"), 2), true);
+
+    // column1 was used last, so column2 is evicted by the third column
+    TEST_EQUAL(checkColumn(cache->get("location", "column1"), 1), true);
+    cache->add("location", "column3", column3);
+    TEST_EQUAL(cache->get("location", "column2"), nullptr);
+    TEST_EQUAL(checkColumn(cache->get("location", "column1"), 1), true);
+    TEST_EQUAL(checkColumn(cache->get("location", "column3"), 3), true);
+
+    // other location is another key
+    TEST_EQUAL(cache->get("other_location", "column1"), nullptr);
+
+    // lower limit evicts the entries
+    cache->setMemoryLimit(TEST_COLUMN_SIZE);
+    TEST_EQUAL(cache->get("location", "column1"), nullptr);
+    TEST_EQUAL(checkColumn(cache->get("location", "column3"), 3), true);
+
+    cache->clear();
+    TEST_EQUAL(cache->get("location", "column3"), nullptr);
+    cache->setMemoryLimit(0);
+
+    delete column1;
+    delete column2;
+    delete column3;
+}
+
+/**
+ * @brief diskTier_test
+ */
+void
+ColumnCache_Test::diskTier_test()
+{
+    ColumnCache* cache = ColumnCache::getInstance();
+    Kitsunemimi::ErrorContainer error;
+    const std::string key = "location\ncolumn1";
+    const uint64_t fileSize = CACHE_FILE_HEADER_SIZE + key.size() + TEST_COLUMN_SIZE;
+
+    // space for two files
+    TEST_EQUAL(cache->initDiskCache(getCacheDir().string(), 2 * fileSize, error), true);
+
+    Kitsunemimi::DataBuffer* column1 = createColumn(1);
+    cache->add("location", "column1", column1);
+    std::vector<std::filesystem::path> files = getCacheFiles(getCacheDir());
+    TEST_EQUAL(files.size(), 1);
+    if(files.size() != 1)
+    {
+        delete column1;
+        return;
+    }
+
+    // check format of the file
+    std::ifstream file(files.at(0), std::ios::binary);
+    std::vector<char> content(fileSize);
+    file.read(content.data(), static_cast<std::streamsize>(fileSize));
+    TEST_EQUAL(static_cast<uint64_t>(file.gcount()), fileSize);
+    TEST_EQUAL(file.peek(), std::ifstream::traits_type::eof());
+    uint64_t header[3];
+    memcpy(header, content.data(), CACHE_FILE_HEADER_SIZE);
+    TEST_EQUAL(header[0], CACHE_FILE_MAGIC);
+    TEST_EQUAL(header[1], key.size());
+    TEST_EQUAL(header[2], TEST_COLUMN_SIZE);
+    TEST_EQUAL(std::string(&content[CACHE_FILE_HEADER_SIZE], key.size()), key);
+    TEST_EQUAL(memcmp(&content[CACHE_FILE_HEADER_SIZE + key.size()],
+                      column1->data,
+                      TEST_COLUMN_SIZE), 0);
+    file.close();
+
+    // read from disk, because the memory-tier is disabled
+    TEST_EQUAL(checkColumn(cache->get("location", "column1"), 1), true);
+
+    // column1 was used last, so the file of column2 is removed for the third column
+    Kitsunemimi::DataBuffer* column2 = createColumn(2);
+    Kitsunemimi::DataBuffer* column3 = createColumn(3);
+    cache->add("location", "column2", column2);
+    TEST_EQUAL(checkColumn(cache->get("location", "column1"), 1), true);
+    cache->add("location", "column3", column3);
+    TEST_EQUAL(cache->get("location", "column2"), nullptr);
+    TEST_EQUAL(checkColumn(cache->get("location", "column1"), 1), true);
+    TEST_EQUAL(checkColumn(cache->get("location", "column3"), 3), true);
+    TEST_EQUAL(getCacheFiles(getCacheDir()).size(), 2);
+
+    delete column1;
+    delete column2;
+    delete column3;
+}
+
+/**
+ * @brief initDiskCache_test
+ */
+void
+ColumnCache_Test::initDiskCache_test()
+{
+    ColumnCache* cache = ColumnCache::getInstance();
+    Kitsunemimi::ErrorContainer error;
+
+    // invalid file, which has to be removed
+    const std::filesystem::path invalidPath = getCacheDir() / "invalid.column";
+    std::ofstream invalidFile(invalidPath, std::ios::binary);
+    invalidFile << "not a cache-file of the column-cache";
+    invalidFile.close();
+    TEST_EQUAL(getCacheFiles(getCacheDir()).size(), 3);
+
+    // existing files of the last test are taken over
+    TEST_EQUAL(cache->initDiskCache(getCacheDir().string(), 1024 * 1024, error), true);
+    TEST_EQUAL(std::filesystem::exists(invalidPath), false);
+    TEST_EQUAL(checkColumn(cache->get("location", "column1"), 1), true);
+    TEST_EQUAL(checkColumn(cache->get("location", "column3"), 3), true);
+
+    // file, which is broken after the start, is not used and removed from the cache
+    const std::vector<std::filesystem::path> files = getCacheFiles(getCacheDir());
+    for(const std::filesystem::path &path : files)
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(0);
+        file.put(0);
+        file.close();
+    }
+    TEST_EQUAL(cache->get("location", "column1"), nullptr);
+    TEST_EQUAL(cache->get("location", "column3"), nullptr);
+
+    // smaller limit removes the files
+    TEST_EQUAL(cache->initDiskCache(getCacheDir().string(), 0, error), true);
+    TEST_EQUAL(getCacheFiles(getCacheDir()).size(), 0);
+}
+
+/**
+ * @brief getRange_test
+ */
+void
+ColumnCache_Test::getRange_test()
+{
+    ColumnCache* cache = ColumnCache::getInstance();
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* column = createColumn(4);
+    const uint8_t* u8Column = static_cast<const uint8_t*>(column->data);
+    Kitsunemimi::DataBuffer* result = nullptr;
+    uint64_t columnSize = 0;
+
+    TEST_EQUAL(cache->initDiskCache(getCacheDir().string(), 1024 * 1024, error), true);
+    cache->add("location", "disk_column", column);
+    cache->setMemoryLimit(1024 * 1024);
+    cache->add("location", "memory_column", column);
+
+    for(const std::string columnName : {"disk_column", "memory_column"})
+    {
+        // range within the column
+        TEST_EQUAL(cache->getRange(result, columnSize, "location", columnName, 5000, 100), true);
+        TEST_NOT_EQUAL(result, nullptr);
+        TEST_EQUAL(columnSize, TEST_COLUMN_SIZE);
+        if(result != nullptr)
+        {
+            TEST_EQUAL(result->usedBufferSize, 100);
+            TEST_EQUAL(memcmp(result->data, &u8Column[5000], 100), 0);
+            delete result;
+        }
+
+        // range outside of the column is found, but has no result
+        result = nullptr;
+        TEST_EQUAL(cache->getRange(result,
+                                   columnSize,
+                                   "location",
+                                   columnName,
+                                   TEST_COLUMN_SIZE - 50,
+                                   100), true);
+        TEST_EQUAL(result, nullptr);
+        TEST_EQUAL(columnSize, TEST_COLUMN_SIZE);
+    }
+
+    // not cached column
+    TEST_EQUAL(cache->getRange(result, columnSize, "location", "unknown", 0, 1), false);
+    TEST_EQUAL(result, nullptr);
+
+    cache->setMemoryLimit(0);
+    delete column;
+}
+
+}
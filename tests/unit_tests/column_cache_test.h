@@ -0,0 +1,46 @@
+/**
+ * @file        column_cache_test.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef COLUMN_CACHE_TEST_H
+#define COLUMN_CACHE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Shiori
+{
+
+class ColumnCache_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    ColumnCache_Test();
+
+private:
+    void memoryTier_test();
+    void diskTier_test();
+    void initDiskCache_test();
+    void getRange_test();
+};
+
+}
+
+#endif // COLUMN_CACHE_TEST_H
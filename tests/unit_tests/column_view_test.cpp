@@ -0,0 +1,199 @@
+/**
+ * @file        column_view_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <column_view_test.h>
+
+#include <cstring>
+#include <random>
+#include <type_traits>
+
+namespace Shiori
+{
+
+// number of values, which are converted with multiple threads
+const uint64_t PARALLEL_NUMBER_OF_VALUES = 4 * 1024 * 1024 + 13;
+
+/**
+ * @brief create random raw values of a column
+ *
+ * @param numberOfValues number of values
+ *
+ * @return list with the values
+ */
+template<typename T>
+static std::vector<T>
+createValues(const uint64_t numberOfValues)
+{
+    std::mt19937 generator(42);
+    std::vector<T> values(numberOfValues);
+    for(uint64_t i = 0; i < numberOfValues; i++)
+    {
+        // float-values are limited to a range, which is not distorted by the conversion
+        if constexpr(std::is_same<T, float>::value) {
+            values[i] = static_cast<float>(i % 1000) * 0.25f - 100.0f;
+        }
+        else {
+            values[i] = static_cast<T>(generator());
+        }
+    }
+
+    return values;
+}
+
+ColumnView_Test::ColumnView_Test()
+    : Kitsunemimi::CompareTestHelper("ColumnView_Test")
+{
+    convert_test();
+    unalignedSource_test();
+    invalidSize_test();
+}
+
+/**
+ * @brief convert raw values and compare the result of the vectorized conversion with the
+ *        plain conversion of each single value
+ *
+ * @param rawValues raw values of the column
+ * @param offset number of bytes, which the values are shifted against their alignment
+ * @param conversion conversion to apply
+ *
+ * @return true, if all values are equal and correctly aligned, else false
+ */
+template<typename T>
+bool
+ColumnView_Test::checkConversion(const std::vector<T> &rawValues,
+                                 const uint64_t offset,
+                                 const ColumnConversion &conversion)
+{
+    Kitsunemimi::ErrorContainer error;
+    const uint64_t dataSize = rawValues.size() * sizeof(T);
+    std::vector<uint8_t> data(dataSize + offset + 1);
+    if(dataSize > 0) {
+        memcpy(&data[offset], rawValues.data(), dataSize);
+    }
+
+    ColumnView view;
+    if(view.convert(&data[offset], dataSize, conversion, error) == false
+            || view.getNumberOfValues() != rawValues.size()
+            || reinterpret_cast<uintptr_t>(view.getValues()) % COLUMN_VIEW_ALIGNMENT != 0)
+    {
+        return false;
+    }
+
+    const float* values = view.getValues();
+    for(uint64_t i = 0; i < rawValues.size(); i++)
+    {
+        const float expected = static_cast<float>(rawValues[i]) * conversion.scale
+                               + conversion.offset;
+        if(values[i] != expected) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief convert_test
+ */
+void
+ColumnView_Test::convert_test()
+{
+    ColumnConversion conversion;
+    conversion.scale = 1.0f / 255.0f;
+    conversion.offset = -0.5f;
+
+    // sizes around the blocks of 4, 8 and 16 values of the vectorized conversions
+    const std::vector<uint64_t> sizes = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 1001};
+    for(const uint64_t numberOfValues : sizes)
+    {
+        conversion.sourceType = UINT8_VALUE_TYPE;
+        TEST_EQUAL(checkConversion(createValues<uint8_t>(numberOfValues), 0, conversion), true);
+        conversion.sourceType = UINT16_VALUE_TYPE;
+        TEST_EQUAL(checkConversion(createValues<uint16_t>(numberOfValues), 0, conversion), true);
+        conversion.sourceType = INT32_VALUE_TYPE;
+        TEST_EQUAL(checkConversion(createValues<int32_t>(numberOfValues), 0, conversion), true);
+        conversion.sourceType = FLOAT_VALUE_TYPE;
+        TEST_EQUAL(checkConversion(createValues<float>(numberOfValues), 0, conversion), true);
+    }
+
+    // big column, which is converted by multiple threads
+    conversion.sourceType = UINT8_VALUE_TYPE;
+    TEST_EQUAL(checkConversion(createValues<uint8_t>(PARALLEL_NUMBER_OF_VALUES),
+                               0,
+                               conversion), true);
+    conversion.sourceType = INT32_VALUE_TYPE;
+    TEST_EQUAL(checkConversion(createValues<int32_t>(PARALLEL_NUMBER_OF_VALUES),
+                               0,
+                               conversion), true);
+}
+
+/**
+ * @brief unalignedSource_test
+ */
+void
+ColumnView_Test::unalignedSource_test()
+{
+    ColumnConversion conversion;
+    conversion.scale = 2.0f;
+    conversion.offset = 1.0f;
+
+    for(uint64_t offset = 1; offset < 4; offset++)
+    {
+        conversion.sourceType = UINT16_VALUE_TYPE;
+        TEST_EQUAL(checkConversion(createValues<uint16_t>(1001), offset, conversion), true);
+        conversion.sourceType = INT32_VALUE_TYPE;
+        TEST_EQUAL(checkConversion(createValues<int32_t>(1001), offset, conversion), true);
+        conversion.sourceType = FLOAT_VALUE_TYPE;
+        TEST_EQUAL(checkConversion(createValues<float>(1001), offset, conversion), true);
+    }
+}
+
+/**
+ * @brief invalidSize_test
+ */
+void
+ColumnView_Test::invalidSize_test()
+{
+    Kitsunemimi::ErrorContainer error;
+    ColumnConversion conversion;
+    ColumnView view;
+    const std::vector<uint8_t> data(11, 0);
+
+    conversion.sourceType = FLOAT_VALUE_TYPE;
+    TEST_EQUAL(view.convert(data.data(), data.size(), conversion, error), false);
+    conversion.sourceType = UINT16_VALUE_TYPE;
+    TEST_EQUAL(view.convert(data.data(), data.size(), conversion, error), false);
+    conversion.sourceType = UINT8_VALUE_TYPE;
+    TEST_EQUAL(view.convert(data.data(), data.size(), conversion, error), true);
+    TEST_EQUAL(view.getNumberOfValues(), 11);
+
+    // view is reused for a smaller column
+    TEST_EQUAL(view.convert(data.data(), 3, conversion, error), true);
+    TEST_EQUAL(view.getNumberOfValues(), 3);
+
+    TEST_EQUAL(getColumnValueSize(UINT8_VALUE_TYPE), 1);
+    TEST_EQUAL(getColumnValueSize(UINT16_VALUE_TYPE), 2);
+    TEST_EQUAL(getColumnValueSize(INT32_VALUE_TYPE), 4);
+    TEST_EQUAL(getColumnValueSize(FLOAT_VALUE_TYPE), 4);
+}
+
+}
@@ -0,0 +1,53 @@
+/**
+ * @file        column_view_test.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef COLUMN_VIEW_TEST_H
+#define COLUMN_VIEW_TEST_H
+
+#include <vector>
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+#include <libShioriArchive/column_view.h>
+
+namespace Shiori
+{
+
+class ColumnView_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    ColumnView_Test();
+
+private:
+    void convert_test();
+    void unalignedSource_test();
+    void invalidSize_test();
+
+    template<typename T>
+    bool checkConversion(const std::vector<T> &rawValues,
+                         const uint64_t offset,
+                         const ColumnConversion &conversion);
+};
+
+}
+
+#endif // COLUMN_VIEW_TEST_H
@@ -0,0 +1,115 @@
+/**
+ * @file        crc32c_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <crc32c_test.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <crc32c.h>
+
+namespace Shiori
+{
+
+/**
+ * @brief calculate crc32c bit by bit as reference for the table- and hardware-based version
+ *
+ * @param data pointer to the input
+ * @param dataSize number of bytes of the input
+ *
+ * @return checksum
+ */
+static uint32_t
+calculateReference(const uint8_t* data, const uint64_t dataSize)
+{
+    uint32_t crc = 0xffffffff;
+    for(uint64_t i = 0; i < dataSize; i++)
+    {
+        crc ^= data[i];
+        for(uint32_t j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+Crc32c_Test::Crc32c_Test()
+    : Kitsunemimi::CompareTestHelper("Crc32c_Test")
+{
+    calculateCrc32c_test();
+    unaligned_test();
+}
+
+/**
+ * @brief calculateCrc32c_test
+ */
+void
+Crc32c_Test::calculateCrc32c_test()
+{
+    // check-value of the crc32c-specification
+    const std::string checkInput = "123456789";
+    TEST_EQUAL(calculateCrc32c(checkInput.c_str(), checkInput.size()), 0xe3069283);
+
+    // test-vectors of RFC 3720, appendix B.4
+    uint8_t input[32];
+    memset(input, 0x00, 32);
+    TEST_EQUAL(calculateCrc32c(input, 32), 0x8a9136aa);
+    memset(input, 0xff, 32);
+    TEST_EQUAL(calculateCrc32c(input, 32), 0x62a8ab43);
+    for(uint8_t i = 0; i < 32; i++) {
+        input[i] = i;
+    }
+    TEST_EQUAL(calculateCrc32c(input, 32), 0x46dd794e);
+    for(uint8_t i = 0; i < 32; i++) {
+        input[i] = 31 - i;
+    }
+    TEST_EQUAL(calculateCrc32c(input, 32), 0x113fdb5c);
+
+    // empty input
+    TEST_EQUAL(calculateCrc32c(input, 0), 0x00000000);
+}
+
+/**
+ * @brief unaligned_test
+ */
+void
+Crc32c_Test::unaligned_test()
+{
+    std::vector<uint8_t> input(1024 + 16);
+    for(uint64_t i = 0; i < input.size(); i++) {
+        input[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+
+    // all offsets and sizes, which are no multiple of the 8 bytes per hardware-instruction
+    for(uint64_t offset = 0; offset < 16; offset++)
+    {
+        for(const uint64_t size : {1ul, 7ul, 8ul, 9ul, 63ul, 1001ul, 1024ul})
+        {
+            TEST_EQUAL(calculateCrc32c(&input[offset], size),
+                       calculateReference(&input[offset], size));
+        }
+    }
+}
+
+}
@@ -0,0 +1,199 @@
+/**
+ * @file        error_aggregator_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <error_aggregator_test.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <error_aggregator.h>
+
+namespace Shiori
+{
+
+ErrorAggregator_Test::ErrorAggregator_Test()
+    : Kitsunemimi::CompareTestHelper("ErrorAggregator_Test")
+{
+    combine_test();
+    tokenBucket_test();
+    numberOfAggregates_test();
+    backgroundThread_test();
+
+    ErrorAggregator::getInstance()->setLimits(0, 0, nullptr);
+}
+
+/**
+ * @brief combine_test
+ */
+void
+ErrorAggregator_Test::combine_test()
+{
+    ErrorAggregator* aggregator = ErrorAggregator::getInstance();
+    std::vector<ErrorRecord> readyToSend;
+
+    // long time-window, which is only closed by the flush
+    aggregator->setLimits(60000, 0, nullptr);
+
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->add(readyToSend, "other_user", "message");
+    TEST_EQUAL(readyToSend.size(), 2);
+    TEST_EQUAL(readyToSend.at(0).userId, "user");
+    TEST_EQUAL(readyToSend.at(0).errorMessage, "message");
+    TEST_EQUAL(readyToSend.at(1).userId, "other_user");
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 2);
+
+    // only the repeated message is sent again with its number
+    readyToSend.clear();
+    aggregator->flush(readyToSend);
+    TEST_EQUAL(readyToSend.size(), 1);
+    TEST_EQUAL(readyToSend.at(0).userId, "user");
+    TEST_EQUAL(readyToSend.at(0).errorMessage, "message (repeated 2 times)");
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 0);
+}
+
+/**
+ * @brief tokenBucket_test
+ */
+void
+ErrorAggregator_Test::tokenBucket_test()
+{
+    ErrorAggregator* aggregator = ErrorAggregator::getInstance();
+    std::vector<ErrorRecord> readyToSend;
+
+    // two messages per second with time-window
+    aggregator->setLimits(60000, 2, nullptr);
+
+    aggregator->add(readyToSend, "user", "message1");
+    aggregator->add(readyToSend, "user", "message2");
+    aggregator->add(readyToSend, "user", "message3");
+    aggregator->add(readyToSend, "user", "message3");
+    TEST_EQUAL(readyToSend.size(), 2);
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 3);
+
+    // after the refill, the message is sent with the number of all occurrences, because
+    // the first one was not sent
+    readyToSend.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    aggregator->flush(readyToSend);
+    TEST_EQUAL(readyToSend.size(), 1);
+    if(readyToSend.size() == 1) {
+        TEST_EQUAL(readyToSend.at(0).errorMessage, "message3 (occurred 2 times)");
+    }
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 0);
+
+    // without token, the flush drops all suppressed messages instead of keeping them
+    aggregator->add(readyToSend, "user", "message4");
+    aggregator->add(readyToSend, "user", "message5");
+    aggregator->add(readyToSend, "user", "message5");
+    aggregator->add(readyToSend, "user", "message6");
+    aggregator->add(readyToSend, "user", "message6");
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 3);
+    uint64_t numberOfDropped = aggregator->getNumberOfDropped();
+    readyToSend.clear();
+    aggregator->flush(readyToSend);
+    TEST_EQUAL(readyToSend.size(), 0);
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 0);
+    TEST_EQUAL(aggregator->getNumberOfDropped(), numberOfDropped + 5);
+
+    // without time-window, messages above the rate-limit are dropped
+    aggregator->setLimits(0, 2, nullptr);
+    numberOfDropped = aggregator->getNumberOfDropped();
+    readyToSend.clear();
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->add(readyToSend, "user", "message");
+    TEST_EQUAL(readyToSend.size(), 2);
+    TEST_EQUAL(aggregator->getNumberOfDropped(), numberOfDropped + 1);
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 0);
+}
+
+/**
+ * @brief numberOfAggregates_test
+ */
+void
+ErrorAggregator_Test::numberOfAggregates_test()
+{
+    ErrorAggregator* aggregator = ErrorAggregator::getInstance();
+    std::vector<ErrorRecord> readyToSend;
+
+    aggregator->setLimits(60000, 0, nullptr);
+
+    // messages above the maximum number of aggregates are sent without combining
+    for(uint64_t i = 0; i < MAX_NUMBER_OF_AGGREGATES + 5; i++) {
+        aggregator->add(readyToSend, "user", "message " + std::to_string(i));
+    }
+    TEST_EQUAL(readyToSend.size(), MAX_NUMBER_OF_AGGREGATES + 5);
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), MAX_NUMBER_OF_AGGREGATES);
+
+    readyToSend.clear();
+    aggregator->flush(readyToSend);
+    TEST_EQUAL(readyToSend.size(), 0);
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 0);
+}
+
+/**
+ * @brief backgroundThread_test
+ */
+void
+ErrorAggregator_Test::backgroundThread_test()
+{
+    ErrorAggregator* aggregator = ErrorAggregator::getInstance();
+    std::vector<ErrorRecord> readyToSend;
+    std::vector<ErrorRecord> sent;
+    std::mutex sentLock;
+
+    auto send = [&](const std::vector<ErrorRecord> &records)
+    {
+        std::lock_guard<std::mutex> guard(sentLock);
+        sent.insert(sent.end(), records.begin(), records.end());
+    };
+    aggregator->setLimits(50, 0, send);
+
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->add(readyToSend, "user", "message");
+    TEST_EQUAL(readyToSend.size(), 1);
+
+    // the expired time-window is sent by the background-thread
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    {
+        std::lock_guard<std::mutex> guard(sentLock);
+        TEST_EQUAL(sent.size(), 1);
+        if(sent.size() == 1) {
+            TEST_EQUAL(sent.at(0).errorMessage, "message (repeated 1 times)");
+        }
+    }
+    TEST_EQUAL(aggregator->getNumberOfAggregates(), 0);
+
+    // disabled time-window sends the remaining messages
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->add(readyToSend, "user", "message");
+    aggregator->setLimits(0, 0, send);
+    {
+        std::lock_guard<std::mutex> guard(sentLock);
+        TEST_EQUAL(sent.size(), 2);
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+/**
+ * @file        json_helper_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <json_helper_test.h>
+
+#include <json_helper.h>
+
+namespace Shiori
+{
+
+JsonHelper_Test::JsonHelper_Test()
+    : Kitsunemimi::CompareTestHelper("JsonHelper_Test")
+{
+    appendJsonString_test();
+    appendJsonField_test();
+}
+
+/**
+ * @brief appendJsonString_test
+ */
+void
+JsonHelper_Test::appendJsonString_test()
+{
+    std::string output = "";
+
+    appendJsonString(output, "");
+    TEST_EQUAL(output, "\"\"");
+
+    output.clear();
+    appendJsonString(output, "plain text");
+    TEST_EQUAL(output, "\"plain text\"");
+
+    // quotes and backslashes
+    output.clear();
+    appendJsonString(output, "say \"hi\" C:\\path");
+    TEST_EQUAL(output, "\"say \\\"hi\\\" C:\\\\path\"");
+
+    // control-characters with short and unicode escape-sequences
+    output.clear();
+    appendJsonString(output, "a\nb\rc\td\x01" "e\x1f");
+    TEST_EQUAL(output, "\"a\\nb\\rc\\td\\u0001e\\u001f\"");
+
+    // zero-byte within the string
+    output.clear();
+    appendJsonString(output, std::string("a\0b", 3));
+    TEST_EQUAL(output, "\"a\\u0000b\"");
+
+    // utf-8 is kept unchanged
+    output.clear();
+    appendJsonString(output, "\xe6\x9c\xac");
+    TEST_EQUAL(output, "\"\xe6\x9c\xac\"");
+
+    // existing content is kept
+    output = "prefix";
+    appendJsonString(output, "x");
+    TEST_EQUAL(output, "prefix\"x\"");
+}
+
+/**
+ * @brief appendJsonField_test
+ */
+void
+JsonHelper_Test::appendJsonField_test()
+{
+    std::string output = "{";
+
+    appendJsonField(output, "uuid", "1234");
+    TEST_EQUAL(output, "{\"uuid\":\"1234\"");
+
+    // separator before all following fields
+    appendJsonField(output, "size", 42);
+    TEST_EQUAL(output, "{\"uuid\":\"1234\",\"size\":42");
+
+    appendJsonField(output, "key \"x\"", "line\nbreak");
+    output.push_back('}');
+    TEST_EQUAL(output, "{\"uuid\":\"1234\",\"size\":42,\"key \\\"x\\\"\":\"line\\nbreak\"}");
+
+    // maximum of the numeric values
+    output = "{";
+    appendJsonField(output, "max", UINT64_MAX);
+    TEST_EQUAL(output, "{\"max\":18446744073709551615");
+}
+
+}
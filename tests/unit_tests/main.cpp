@@ -20,7 +20,29 @@
  *      limitations under the License.
  */
 
+#include <buffer_pool_test.h>
+#include <column_cache_test.h>
+#include <column_view_test.h>
+#include <crc32c_test.h>
+#include <error_aggregator_test.h>
+#include <json_helper_test.h>
+#include <metadata_cache_test.h>
+#include <snapshot_compression_test.h>
+#include <snapshot_delta_test.h>
+#include <snapshot_upload_test.h>
+
 int main()
 {
+    Shiori::ColumnCache_Test();
+    Shiori::MetadataCache_Test();
+    Shiori::ErrorAggregator_Test();
+    Shiori::SnapshotCompression_Test();
+    Shiori::Crc32c_Test();
+    Shiori::SnapshotDelta_Test();
+    Shiori::JsonHelper_Test();
+    Shiori::BufferPool_Test();
+    Shiori::ColumnView_Test();
+    Shiori::SnapshotUpload_Test();
+
     return 0;
 }
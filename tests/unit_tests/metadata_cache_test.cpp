@@ -0,0 +1,170 @@
+/**
+ * @file        metadata_cache_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <metadata_cache_test.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <libShioriArchive/metadata_cache.h>
+
+#include <test_connection.h>
+
+namespace Shiori
+{
+
+MetadataCache_Test::MetadataCache_Test()
+    : Kitsunemimi::CompareTestHelper("MetadataCache_Test")
+{
+    combinedRequests_test();
+    timeToLive_test();
+    failedRequest_test();
+    invalidResponse_test();
+
+    MetadataCache::getInstance()->setTimeToLive(0);
+    MetadataCache::getInstance()->clear();
+}
+
+/**
+ * @brief combinedRequests_test
+ */
+void
+MetadataCache_Test::combinedRequests_test()
+{
+    MetadataCache* cache = MetadataCache::getInstance();
+    TestConnection* connection = getTestConnection();
+    cache->setTimeToLive(0);
+    cache->clear();
+
+    // concurrent requests for the same object result in a single request to shiori
+    const uint32_t numberOfThreads = 8;
+    std::vector<std::string> responses(numberOfThreads);
+    std::vector<uint8_t> results(numberOfThreads, 0);
+    std::vector<std::thread> threads;
+    const uint32_t numberOfRequests = connection->numberOfRequests;
+    for(uint32_t i = 0; i < numberOfThreads; i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            Kitsunemimi::ErrorContainer error;
+            results[i] = cache->request(responses[i], "v1/data_set", "uuid", "token", error);
+        });
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    TEST_EQUAL(connection->numberOfRequests.load(), numberOfRequests + 1);
+    for(uint32_t i = 0; i < numberOfThreads; i++)
+    {
+        TEST_EQUAL(results[i], 1);
+        TEST_EQUAL(responses[i], responses[0]);
+    }
+
+    // without time-to-live, the finished request is not kept
+    Kitsunemimi::ErrorContainer error;
+    std::string response = "";
+    TEST_EQUAL(cache->request(response, "v1/data_set", "uuid", "token", error), true);
+    TEST_EQUAL(connection->numberOfRequests.load(), numberOfRequests + 2);
+    TEST_NOT_EQUAL(response, responses[0]);
+}
+
+/**
+ * @brief timeToLive_test
+ */
+void
+MetadataCache_Test::timeToLive_test()
+{
+    MetadataCache* cache = MetadataCache::getInstance();
+    TestConnection* connection = getTestConnection();
+    Kitsunemimi::ErrorContainer error;
+    std::string firstResponse = "";
+    std::string response = "";
+    cache->setTimeToLive(60000);
+    cache->clear();
+
+    const uint32_t numberOfRequests = connection->numberOfRequests;
+    TEST_EQUAL(cache->request(firstResponse, "v1/data_set", "uuid", "token", error), true);
+    TEST_EQUAL(cache->request(response, "v1/data_set", "uuid", "token", error), true);
+    TEST_EQUAL(connection->numberOfRequests.load(), numberOfRequests + 1);
+    TEST_EQUAL(response, firstResponse);
+
+    // other object, endpoint or token are requested separately
+    TEST_EQUAL(cache->request(response, "v1/data_set", "other_uuid", "token", error), true);
+    TEST_EQUAL(cache->request(response, "v1/cluster_snapshot", "uuid", "token", error), true);
+    TEST_EQUAL(cache->request(response, "v1/data_set", "uuid", "other_token", error), true);
+    TEST_EQUAL(connection->numberOfRequests.load(), numberOfRequests + 4);
+
+    // expired entry is requested again
+    cache->setTimeToLive(1);
+    cache->clear();
+    TEST_EQUAL(cache->request(firstResponse, "v1/data_set", "uuid", "token", error), true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    TEST_EQUAL(cache->request(response, "v1/data_set", "uuid", "token", error), true);
+    TEST_EQUAL(connection->numberOfRequests.load(), numberOfRequests + 6);
+    TEST_NOT_EQUAL(response, firstResponse);
+}
+
+/**
+ * @brief failedRequest_test
+ */
+void
+MetadataCache_Test::failedRequest_test()
+{
+    MetadataCache* cache = MetadataCache::getInstance();
+    TestConnection* connection = getTestConnection();
+    Kitsunemimi::ErrorContainer error;
+    std::string response = "";
+    cache->setTimeToLive(60000);
+    cache->clear();
+
+    // failed requests are not kept, even with time-to-live
+    const uint32_t numberOfRequests = connection->numberOfRequests;
+    TEST_EQUAL(cache->request(response, "v1/data_set", "unknown", "token", error), false);
+    TEST_EQUAL(cache->request(response, "v1/data_set", "unknown", "token", error), false);
+    TEST_EQUAL(connection->numberOfRequests.load(), numberOfRequests + 2);
+}
+
+/**
+ * @brief invalidResponse_test
+ */
+void
+MetadataCache_Test::invalidResponse_test()
+{
+    MetadataCache* cache = MetadataCache::getInstance();
+    TestConnection* connection = getTestConnection();
+    Kitsunemimi::ErrorContainer error;
+    std::shared_ptr<const Kitsunemimi::JsonItem> parsed;
+    std::string response = "";
+    cache->setTimeToLive(60000);
+    cache->clear();
+
+    // responses, which can not be parsed, are still delivered as string, but not kept
+    const uint32_t numberOfRequests = connection->numberOfRequests;
+    TEST_EQUAL(cache->request(parsed, "v1/data_set", "invalid", "token", error), false);
+    TEST_EQUAL(cache->request(response, "v1/data_set", "invalid", "token", error), true);
+    TEST_EQUAL(connection->numberOfRequests.load(), numberOfRequests + 2);
+    TEST_EQUAL(response, "invalid_" + std::to_string(numberOfRequests + 2));
+}
+
+}
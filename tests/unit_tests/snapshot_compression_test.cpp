@@ -0,0 +1,269 @@
+/**
+ * @file        snapshot_compression_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <snapshot_compression_test.h>
+
+#include <cstring>
+#include <random>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+#include <libShioriArchive/snapshot_compression.h>
+
+namespace Shiori
+{
+
+// more than two frames of 1 MiB, where the last one is not full
+const uint64_t TEST_SNAPSHOT_SIZE = 2 * 1024 * 1024 + 4099;
+
+/**
+ * @brief create a snapshot, which is compressible in the first half and random in the second
+ *
+ * @param size size of the snapshot in bytes
+ *
+ * @return pointer to new data-buffer with the snapshot
+ */
+static Kitsunemimi::DataBuffer*
+createSnapshot(const uint64_t size)
+{
+    Kitsunemimi::DataBuffer* buffer = new Kitsunemimi::DataBuffer((size / 4096) + 1);
+    uint8_t* u8Buffer = static_cast<uint8_t*>(buffer->data);
+    std::mt19937 generator(42);
+
+    for(uint64_t i = 0; i < size; i++)
+    {
+        if(i < size / 2) {
+            u8Buffer[i] = static_cast<uint8_t>((i / 64) % 8);
+        }
+        else {
+            u8Buffer[i] = static_cast<uint8_t>(generator());
+        }
+    }
+    buffer->usedBufferSize = size;
+
+    return buffer;
+}
+
+/**
+ * @brief check if a decompressed snapshot is equal to the original
+ *
+ * @param result decompressed snapshot
+ * @param original original snapshot
+ *
+ * @return true, if equal, else false
+ */
+static bool
+isEqual(const Kitsunemimi::DataBuffer* result,
+        const Kitsunemimi::DataBuffer &original)
+{
+    return result != nullptr
+           && result->usedBufferSize == original.usedBufferSize
+           && memcmp(result->data, original.data, original.usedBufferSize) == 0;
+}
+
+SnapshotCompression_Test::SnapshotCompression_Test()
+    : Kitsunemimi::CompareTestHelper("SnapshotCompression_Test")
+{
+    getCompressionType_test();
+    compressSnapshot_test();
+    decompressSnapshot_test();
+    corruptedSnapshot_test();
+}
+
+/**
+ * @brief getCompressionType_test
+ */
+void
+SnapshotCompression_Test::getCompressionType_test()
+{
+    SnapshotCompression compression = NO_COMPRESSION;
+
+    TEST_EQUAL(getCompressionType(compression, "lz4"), true);
+    TEST_EQUAL(compression, LZ4_COMPRESSION);
+    TEST_EQUAL(getCompressionType(compression, "zstd"), true);
+    TEST_EQUAL(compression, ZSTD_COMPRESSION);
+    TEST_EQUAL(getCompressionType(compression, ""), true);
+    TEST_EQUAL(compression, NO_COMPRESSION);
+    TEST_EQUAL(getCompressionType(compression, "gzip"), false);
+
+    TEST_EQUAL(getCompressionName(LZ4_COMPRESSION), "lz4");
+    TEST_EQUAL(getCompressionName(ZSTD_COMPRESSION), "zstd");
+}
+
+/**
+ * @brief compressSnapshot_test
+ */
+void
+SnapshotCompression_Test::compressSnapshot_test()
+{
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* snapshot = createSnapshot(TEST_SNAPSHOT_SIZE);
+
+    for(const SnapshotCompression compression : {LZ4_COMPRESSION, ZSTD_COMPRESSION})
+    {
+        Kitsunemimi::DataBuffer* compressed = compressSnapshot(*snapshot, compression, error);
+        TEST_NOT_EQUAL(compressed, nullptr);
+        if(compressed == nullptr) {
+            continue;
+        }
+
+        TEST_EQUAL(isCompressedSnapshot(*compressed), true);
+        const bool isSmaller = compressed->usedBufferSize < snapshot->usedBufferSize;
+        TEST_EQUAL(isSmaller, true);
+
+        uint64_t size = 0;
+        TEST_EQUAL(getDecompressedSize(size, *compressed, error), true);
+        TEST_EQUAL(size, TEST_SNAPSHOT_SIZE);
+
+        Kitsunemimi::DataBuffer* result = decompressSnapshot(*compressed, error);
+        TEST_EQUAL(isEqual(result, *snapshot), true);
+
+        delete result;
+        delete compressed;
+    }
+
+    // invalid compression-type
+    TEST_EQUAL(compressSnapshot(*snapshot, NO_COMPRESSION, error), nullptr);
+    TEST_EQUAL(isCompressedSnapshot(*snapshot), false);
+
+    // empty snapshot
+    Kitsunemimi::DataBuffer empty;
+    Kitsunemimi::DataBuffer* compressed = compressSnapshot(empty, LZ4_COMPRESSION, error);
+    TEST_NOT_EQUAL(compressed, nullptr);
+    if(compressed != nullptr)
+    {
+        Kitsunemimi::DataBuffer* result = decompressSnapshot(*compressed, error);
+        TEST_EQUAL(isEqual(result, empty), true);
+        delete result;
+        delete compressed;
+    }
+
+    delete snapshot;
+}
+
+/**
+ * @brief decompressSnapshot_test
+ */
+void
+SnapshotCompression_Test::decompressSnapshot_test()
+{
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* snapshot = createSnapshot(TEST_SNAPSHOT_SIZE);
+    Kitsunemimi::DataBuffer* compressed = compressSnapshot(*snapshot, LZ4_COMPRESSION, error);
+    Kitsunemimi::DataBuffer target((TEST_SNAPSHOT_SIZE / 4096) + 1);
+    uint8_t* u8Target = static_cast<uint8_t*>(target.data);
+
+    // into an existing buffer
+    TEST_EQUAL(decompressSnapshot(u8Target, TEST_SNAPSHOT_SIZE, *compressed, error), true);
+    TEST_EQUAL(memcmp(u8Target, snapshot->data, TEST_SNAPSHOT_SIZE), 0);
+
+    // too small buffer
+    TEST_EQUAL(decompressSnapshot(u8Target, TEST_SNAPSHOT_SIZE - 1, *compressed, error), false);
+
+    // not compressed input
+    TEST_EQUAL(decompressSnapshot(u8Target, TEST_SNAPSHOT_SIZE, *snapshot, error), false);
+
+    delete compressed;
+    delete snapshot;
+}
+
+/**
+ * @brief corruptedSnapshot_test
+ */
+void
+SnapshotCompression_Test::corruptedSnapshot_test()
+{
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* snapshot = createSnapshot(TEST_SNAPSHOT_SIZE);
+    Kitsunemimi::DataBuffer* compressed = compressSnapshot(*snapshot, LZ4_COMPRESSION, error);
+    uint8_t* u8Compressed = static_cast<uint8_t*>(compressed->data);
+    const uint64_t compressedSize = compressed->usedBufferSize;
+
+    // copy of the untouched compressed snapshot to reset the changes of the single tests
+    Kitsunemimi::DataBuffer original((compressedSize / 4096) + 1);
+    memcpy(original.data, compressed->data, compressedSize);
+    auto reset = [&]() {
+        memcpy(compressed->data, original.data, compressedSize);
+        compressed->usedBufferSize = compressedSize;
+    };
+
+    // positions of the values within the header of the snapshot and the first frame
+    const uint64_t magicPos = 0;
+    const uint64_t rawSizePos = 16;
+    const uint64_t numberOfFramesPos = 24;
+    const uint64_t frameRawSizePos = 32;
+    const uint64_t frameStoredSizePos = 36;
+    uint64_t value64 = 0;
+    uint32_t value32 = 0;
+
+    // wrong magic
+    u8Compressed[magicPos] ^= 0xff;
+    TEST_EQUAL(isCompressedSnapshot(*compressed), false);
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    reset();
+
+    // raw-size, which doesn't match the number of frames
+    value64 = uint64_t(1) << 50;
+    memcpy(&u8Compressed[rawSizePos], &value64, sizeof(uint64_t));
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    reset();
+
+    // more frames than the snapshot could contain
+    value64 = uint64_t(1) << 60;
+    memcpy(&u8Compressed[numberOfFramesPos], &value64, sizeof(uint64_t));
+    uint64_t size = 0;
+    TEST_EQUAL(getDecompressedSize(size, *compressed, error), false);
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    reset();
+
+    // frame, which is bigger than the frame-size
+    value32 = 2 * 1024 * 1024;
+    memcpy(&u8Compressed[frameRawSizePos], &value32, sizeof(uint32_t));
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    reset();
+
+    // frame, which is stored with a wrong size
+    value32 = 1;
+    memcpy(&u8Compressed[frameStoredSizePos], &value32, sizeof(uint32_t));
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    value32 = 0xffffffff;
+    memcpy(&u8Compressed[frameStoredSizePos], &value32, sizeof(uint32_t));
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    reset();
+
+    // truncated snapshot
+    compressed->usedBufferSize = compressedSize - 1;
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    compressed->usedBufferSize = 40;
+    TEST_EQUAL(decompressSnapshot(*compressed, error), nullptr);
+    reset();
+
+    // untouched snapshot is still valid after all resets
+    Kitsunemimi::DataBuffer* result = decompressSnapshot(*compressed, error);
+    TEST_EQUAL(isEqual(result, *snapshot), true);
+
+    delete result;
+    delete compressed;
+    delete snapshot;
+}
+
+}
@@ -0,0 +1,46 @@
+/**
+ * @file        snapshot_compression_test.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef SNAPSHOT_COMPRESSION_TEST_H
+#define SNAPSHOT_COMPRESSION_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Shiori
+{
+
+class SnapshotCompression_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    SnapshotCompression_Test();
+
+private:
+    void getCompressionType_test();
+    void compressSnapshot_test();
+    void decompressSnapshot_test();
+    void corruptedSnapshot_test();
+};
+
+}
+
+#endif // SNAPSHOT_COMPRESSION_TEST_H
@@ -0,0 +1,283 @@
+/**
+ * @file        snapshot_delta_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <snapshot_delta_test.h>
+
+#include <cstring>
+#include <random>
+
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+#include <libShioriArchive/snapshot_delta.h>
+
+namespace Shiori
+{
+
+const uint64_t TEST_SNAPSHOT_SIZE = 4 * 1024 * 1024;
+
+/**
+ * @brief create a snapshot with random content
+ *
+ * @param size size of the snapshot in bytes
+ *
+ * @return pointer to new data-buffer with the snapshot
+ */
+static Kitsunemimi::DataBuffer*
+createSnapshot(const uint64_t size)
+{
+    Kitsunemimi::DataBuffer* buffer = new Kitsunemimi::DataBuffer((size / 4096) + 2);
+    uint8_t* u8Buffer = static_cast<uint8_t*>(buffer->data);
+    std::mt19937 generator(42);
+
+    for(uint64_t i = 0; i < size; i++) {
+        u8Buffer[i] = static_cast<uint8_t>(generator());
+    }
+    buffer->usedBufferSize = size;
+
+    return buffer;
+}
+
+/**
+ * @brief create a changed copy of a snapshot, where a few bytes are changed and inserted, so
+ *        the positions of the following chunks are shifted
+ *
+ * @param parent original snapshot
+ *
+ * @return pointer to new data-buffer with the changed snapshot
+ */
+static Kitsunemimi::DataBuffer*
+createChangedSnapshot(const Kitsunemimi::DataBuffer &parent)
+{
+    const uint64_t insertPos = 1000000;
+    const uint64_t insertSize = 100;
+    const uint8_t* u8Parent = static_cast<const uint8_t*>(parent.data);
+
+    Kitsunemimi::DataBuffer* buffer = createSnapshot(parent.usedBufferSize + insertSize);
+    uint8_t* u8Buffer = static_cast<uint8_t*>(buffer->data);
+    memcpy(u8Buffer, u8Parent, insertPos);
+    memset(&u8Buffer[insertPos], 7, insertSize);
+    memcpy(&u8Buffer[insertPos + insertSize],
+           &u8Parent[insertPos],
+           parent.usedBufferSize - insertPos);
+    u8Buffer[3000000]++;
+
+    return buffer;
+}
+
+SnapshotDelta_Test::SnapshotDelta_Test()
+    : Kitsunemimi::CompareTestHelper("SnapshotDelta_Test")
+{
+    createSnapshotManifest_test();
+    createDeltaSnapshot_test();
+    applyDeltaSnapshot_test();
+    deltaChain_test();
+}
+
+/**
+ * @brief createSnapshotManifest_test
+ */
+void
+SnapshotDelta_Test::createSnapshotManifest_test()
+{
+    Kitsunemimi::DataBuffer* snapshot = createSnapshot(TEST_SNAPSHOT_SIZE);
+
+    SnapshotManifest manifest;
+    createSnapshotManifest(manifest, *snapshot);
+    TEST_EQUAL(manifest.totalSize, TEST_SNAPSHOT_SIZE);
+    const bool hasMultipleChunks = manifest.chunks.size() > 1;
+    TEST_EQUAL(hasMultipleChunks, true);
+
+    // chunks must cover the complete snapshot without gaps
+    uint64_t position = 0;
+    for(const SnapshotChunk &chunk : manifest.chunks)
+    {
+        TEST_EQUAL(chunk.position, position);
+        position += chunk.size;
+    }
+    TEST_EQUAL(position, TEST_SNAPSHOT_SIZE);
+
+    // same content results in the same chunks
+    SnapshotManifest secondManifest;
+    createSnapshotManifest(secondManifest, *snapshot);
+    TEST_EQUAL(secondManifest.chunks.size(), manifest.chunks.size());
+    TEST_EQUAL(memcmp(secondManifest.chunks.back().hash, manifest.chunks.back().hash, 32), 0);
+
+    delete snapshot;
+}
+
+/**
+ * @brief createDeltaSnapshot_test
+ */
+void
+SnapshotDelta_Test::createDeltaSnapshot_test()
+{
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* parent = createSnapshot(TEST_SNAPSHOT_SIZE);
+    Kitsunemimi::DataBuffer* current = createChangedSnapshot(*parent);
+
+    SnapshotManifest parentManifest;
+    createSnapshotManifest(parentManifest, *parent);
+
+    // parent without location can not be referenced
+    SnapshotManifest manifest;
+    TEST_EQUAL(createDeltaSnapshot(manifest, *current, parentManifest, error), nullptr);
+
+    parentManifest.location = "parent-location";
+    parentManifest.encoding.compression = LZ4_COMPRESSION;
+    Kitsunemimi::DataBuffer* delta = createDeltaSnapshot(manifest, *current, parentManifest, error);
+    TEST_NOT_EQUAL(delta, nullptr);
+    if(delta == nullptr)
+    {
+        delete current;
+        delete parent;
+        return;
+    }
+
+    // only the changed chunks are part of the delta
+    const bool isSmaller = delta->usedBufferSize < current->usedBufferSize / 10;
+    TEST_EQUAL(isSmaller, true);
+    TEST_EQUAL(isDeltaSnapshot(*delta), true);
+    TEST_EQUAL(isDeltaSnapshot(*current), false);
+    uint64_t deltaSize = 0;
+    TEST_EQUAL(getDeltaSnapshotSize(deltaSize, *delta, error), true);
+    TEST_EQUAL(deltaSize, current->usedBufferSize);
+    TEST_EQUAL(manifest.totalSize, current->usedBufferSize);
+    TEST_EQUAL(manifest.chainLength, 1);
+
+    std::string location = "";
+    SnapshotEncoding encoding;
+    uint64_t parentSize = 0;
+    TEST_EQUAL(getDeltaParent(location, encoding, parentSize, *delta), true);
+    TEST_EQUAL(location, "parent-location");
+    TEST_EQUAL(encoding.compression, LZ4_COMPRESSION);
+    TEST_EQUAL(encoding.isDelta, false);
+    TEST_EQUAL(parentSize, TEST_SNAPSHOT_SIZE);
+
+    delete delta;
+    delete current;
+    delete parent;
+}
+
+/**
+ * @brief applyDeltaSnapshot_test
+ */
+void
+SnapshotDelta_Test::applyDeltaSnapshot_test()
+{
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* parent = createSnapshot(TEST_SNAPSHOT_SIZE);
+    Kitsunemimi::DataBuffer* current = createChangedSnapshot(*parent);
+
+    SnapshotManifest parentManifest;
+    createSnapshotManifest(parentManifest, *parent);
+    parentManifest.location = "parent-location";
+    SnapshotManifest manifest;
+    Kitsunemimi::DataBuffer* delta = createDeltaSnapshot(manifest, *current, parentManifest, error);
+
+    // rebuild into a new buffer
+    Kitsunemimi::DataBuffer* result = applyDeltaSnapshot(*delta, *parent, error);
+    TEST_NOT_EQUAL(result, nullptr);
+    if(result != nullptr)
+    {
+        TEST_EQUAL(result->usedBufferSize, current->usedBufferSize);
+        TEST_EQUAL(memcmp(result->data, current->data, current->usedBufferSize), 0);
+        delete result;
+    }
+
+    // rebuild into an existing buffer
+    const uint64_t currentSize = current->usedBufferSize;
+    Kitsunemimi::DataBuffer target((currentSize / 4096) + 1);
+    uint8_t* u8Target = static_cast<uint8_t*>(target.data);
+    TEST_EQUAL(applyDeltaSnapshot(u8Target, currentSize, *delta, *parent, error), true);
+    TEST_EQUAL(memcmp(u8Target, current->data, currentSize), 0);
+    TEST_EQUAL(applyDeltaSnapshot(u8Target, currentSize - 1, *delta, *parent, error), false);
+
+    // wrong parent
+    parent->usedBufferSize--;
+    TEST_EQUAL(applyDeltaSnapshot(*delta, *parent, error), nullptr);
+    parent->usedBufferSize++;
+
+    // no delta-snapshot
+    TEST_EQUAL(applyDeltaSnapshot(*current, *parent, error), nullptr);
+
+    // header with sizes, which don't match the operations, is rejected before the allocation
+    uint8_t* u8Delta = static_cast<uint8_t*>(delta->data);
+    uint64_t rawSize = 0;
+    uint64_t numberOfOperations = 0;
+    const uint64_t invalidValue = 0xFFFFFFFFFFFFFFF0;
+    memcpy(&rawSize, &u8Delta[8], sizeof(uint64_t));
+    memcpy(&numberOfOperations, &u8Delta[32], sizeof(uint64_t));
+    memcpy(&u8Delta[8], &invalidValue, sizeof(uint64_t));
+    uint64_t size = 0;
+    TEST_EQUAL(getDeltaSnapshotSize(size, *delta, error), false);
+    TEST_EQUAL(applyDeltaSnapshot(*delta, *parent, error), nullptr);
+    memcpy(&u8Delta[8], &rawSize, sizeof(uint64_t));
+    memcpy(&u8Delta[32], &invalidValue, sizeof(uint64_t));
+    TEST_EQUAL(getDeltaSnapshotSize(size, *delta, error), false);
+    TEST_EQUAL(applyDeltaSnapshot(*delta, *parent, error), nullptr);
+    memcpy(&u8Delta[32], &numberOfOperations, sizeof(uint64_t));
+    TEST_EQUAL(getDeltaSnapshotSize(size, *delta, error), true);
+
+    // truncated delta-snapshot
+    delta->usedBufferSize -= 10;
+    TEST_EQUAL(getDeltaSnapshotSize(size, *delta, error), false);
+    TEST_EQUAL(applyDeltaSnapshot(*delta, *parent, error), nullptr);
+
+    delete delta;
+    delete current;
+    delete parent;
+}
+
+/**
+ * @brief deltaChain_test
+ */
+void
+SnapshotDelta_Test::deltaChain_test()
+{
+    Kitsunemimi::ErrorContainer error;
+    Kitsunemimi::DataBuffer* parent = createSnapshot(TEST_SNAPSHOT_SIZE);
+    Kitsunemimi::DataBuffer* current = createChangedSnapshot(*parent);
+
+    SnapshotManifest parentManifest;
+    createSnapshotManifest(parentManifest, *parent);
+    parentManifest.location = "parent-location";
+    SnapshotManifest manifest;
+
+    // last delta, which is allowed in a row
+    parentManifest.chainLength = MAX_DELTA_CHAIN_LENGTH - 1;
+    TEST_EQUAL(needsFullSnapshot(parentManifest), false);
+    Kitsunemimi::DataBuffer* delta = createDeltaSnapshot(manifest, *current, parentManifest, error);
+    TEST_NOT_EQUAL(delta, nullptr);
+    TEST_EQUAL(manifest.chainLength, MAX_DELTA_CHAIN_LENGTH);
+    delete delta;
+
+    // behind this one, a full snapshot is necessary
+    TEST_EQUAL(needsFullSnapshot(manifest), true);
+    manifest.location = "delta-location";
+    SnapshotManifest nextManifest;
+    TEST_EQUAL(createDeltaSnapshot(nextManifest, *current, manifest, error), nullptr);
+
+    delete current;
+    delete parent;
+}
+
+}
@@ -0,0 +1,271 @@
+/**
+ * @file        snapshot_upload_test.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <snapshot_upload_test.h>
+
+#include <cstring>
+#include <vector>
+
+#include <libShioriArchive/snapshots.h>
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+#include <test_connection.h>
+
+namespace Shiori
+{
+
+// default segment-size of the uploads
+const uint64_t TEST_SEGMENT_SIZE = 96 * 1024;
+
+/**
+ * @brief create buffer with data, which is different for each position
+ *
+ * @param size size of the data in bytes
+ *
+ * @return buffer with the data
+ */
+static Kitsunemimi::DataBuffer*
+createData(const uint64_t size)
+{
+    Kitsunemimi::DataBuffer* data = new Kitsunemimi::DataBuffer((size / 4096) + 1);
+    uint8_t* u8Data = static_cast<uint8_t*>(data->data);
+    for(uint64_t i = 0; i < size; i++) {
+        u8Data[i] = static_cast<uint8_t>((i * 7) + (i >> 12));
+    }
+    data->usedBufferSize = size;
+
+    return data;
+}
+
+/**
+ * @brief put the received segments together at their positions
+ *
+ * @param result reference for the assembled data
+ * @param segments received segments
+ * @param targetPos byte-position within the snapshot where the data begins
+ *
+ * @return false, if a segment is outside of the result or overlaps another one, else true
+ */
+static bool
+assembleSegments(std::string &result,
+                 const std::vector<UploadedSegment> &segments,
+                 const uint64_t targetPos)
+{
+    std::vector<bool> covered(result.size(), false);
+    for(const UploadedSegment &segment : segments)
+    {
+        if(segment.position < targetPos
+                || segment.data.size() > result.size() - (segment.position - targetPos))
+        {
+            return false;
+        }
+
+        const uint64_t offset = segment.position - targetPos;
+        for(uint64_t i = offset; i < offset + segment.data.size(); i++)
+        {
+            if(covered[i]) {
+                return false;
+            }
+            covered[i] = true;
+        }
+        memcpy(&result[offset], segment.data.data(), segment.data.size());
+    }
+
+    for(const bool isCovered : covered)
+    {
+        if(isCovered == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+SnapshotUpload_Test::SnapshotUpload_Test()
+    : Kitsunemimi::CompareTestHelper("SnapshotUpload_Test")
+{
+    sendDataPipelined_test();
+    exactMultiple_test();
+    retrySendData_test();
+    configureSegmentSize_test();
+}
+
+/**
+ * @brief sendDataPipelined_test
+ */
+void
+SnapshotUpload_Test::sendDataPipelined_test()
+{
+    TestConnection* connection = getTestConnection();
+    Kitsunemimi::ErrorContainer error;
+    const uint64_t dataSize = (10 * TEST_SEGMENT_SIZE) + 1000;
+    const uint64_t startPos = 4096;
+    Kitsunemimi::DataBuffer* data = createData(dataSize);
+    std::vector<SegmentState> segmentStates;
+
+    connection->recordUploads(true);
+    uint64_t targetPos = startPos;
+    TEST_EQUAL(sendDataPipelined(data, targetPos, "uuid", "file", 4, segmentStates, error), true);
+    connection->recordUploads(false);
+    TEST_EQUAL(targetPos, startPos + dataSize);
+
+    // every segment was sent once and the states describe the data
+    TEST_EQUAL(segmentStates.size(), 11);
+    for(const SegmentState &state : segmentStates) {
+        TEST_EQUAL(state.sent, true);
+    }
+    TEST_EQUAL(segmentStates.back().size, 1000);
+
+    const std::vector<UploadedSegment> segments = connection->getUploadedSegments();
+    TEST_EQUAL(segments.size(), segmentStates.size());
+    std::string result(dataSize, '\0');
+    TEST_EQUAL(assembleSegments(result, segments, startPos), true);
+    TEST_EQUAL(memcmp(result.data(), data->data, dataSize), 0);
+
+    // the last segment is held back until all other segments were sent and only it is marked
+    if(segments.size() > 0)
+    {
+        TEST_EQUAL(segments.back().position, segmentStates.back().position);
+        TEST_EQUAL(segments.back().isLast, true);
+        for(uint64_t i = 0; i < segments.size() - 1; i++) {
+            TEST_EQUAL(segments[i].isLast, false);
+        }
+    }
+
+    // the workers share one connection, where only one stream-message is sent at a time
+    TEST_EQUAL(connection->getMaxParallelStreamMessages(), 1);
+
+    delete data;
+}
+
+/**
+ * @brief exactMultiple_test
+ */
+void
+SnapshotUpload_Test::exactMultiple_test()
+{
+    TestConnection* connection = getTestConnection();
+    Kitsunemimi::ErrorContainer error;
+    const uint64_t dataSize = 4 * TEST_SEGMENT_SIZE;
+    Kitsunemimi::DataBuffer* data = createData(dataSize);
+    std::vector<SegmentState> segmentStates;
+    std::vector<UploadedSegment> segments;
+
+    // pipelined upload, whose last segment has the full size
+    connection->recordUploads(true);
+    uint64_t targetPos = 0;
+    TEST_EQUAL(sendDataPipelined(data, targetPos, "uuid", "file", 2, segmentStates, error), true);
+    connection->recordUploads(false);
+    segments = connection->getUploadedSegments();
+    TEST_EQUAL(segments.size(), 4);
+    if(segments.size() > 0)
+    {
+        TEST_EQUAL(segments.back().position, 3 * TEST_SEGMENT_SIZE);
+        TEST_EQUAL(segments.back().data.size(), TEST_SEGMENT_SIZE);
+        TEST_EQUAL(segments.back().isLast, true);
+    }
+
+    // sequential upload
+    connection->recordUploads(true);
+    targetPos = 0;
+    TEST_EQUAL(sendData(data, targetPos, "uuid", "file", error), true);
+    connection->recordUploads(false);
+    segments = connection->getUploadedSegments();
+    TEST_EQUAL(segments.size(), 4);
+    uint64_t numberOfLast = 0;
+    for(const UploadedSegment &segment : segments) {
+        numberOfLast += segment.isLast;
+    }
+    TEST_EQUAL(numberOfLast, 1);
+    if(segments.size() > 0) {
+        TEST_EQUAL(segments.back().isLast, true);
+    }
+
+    delete data;
+}
+
+/**
+ * @brief retrySendData_test
+ */
+void
+SnapshotUpload_Test::retrySendData_test()
+{
+    TestConnection* connection = getTestConnection();
+    Kitsunemimi::ErrorContainer error;
+    const uint64_t dataSize = (5 * TEST_SEGMENT_SIZE) + 10;
+    Kitsunemimi::DataBuffer* data = createData(dataSize);
+    std::vector<SegmentState> segmentStates;
+
+    uint64_t targetPos = 0;
+    TEST_EQUAL(sendDataPipelined(data, targetPos, "uuid", "file", 3, segmentStates, error), true);
+
+    // all segments are sent again, because shiori doesn't confirm single segments
+    segmentStates[2].sent = false;
+    connection->recordUploads(true);
+    targetPos = 0;
+    TEST_EQUAL(retrySendData(data, targetPos, "uuid", "file", 3, segmentStates, error), true);
+    connection->recordUploads(false);
+    TEST_EQUAL(targetPos, dataSize);
+    const std::vector<UploadedSegment> segments = connection->getUploadedSegments();
+    TEST_EQUAL(segments.size(), segmentStates.size());
+    std::string result(dataSize, '\0');
+    TEST_EQUAL(assembleSegments(result, segments, 0), true);
+    TEST_EQUAL(memcmp(result.data(), data->data, dataSize), 0);
+
+    // changed data doesn't match the checksums of the segments
+    static_cast<uint8_t*>(data->data)[TEST_SEGMENT_SIZE + 5]++;
+    connection->recordUploads(true);
+    targetPos = 0;
+    TEST_EQUAL(retrySendData(data, targetPos, "uuid", "file", 3, segmentStates, error), false);
+    connection->recordUploads(false);
+    TEST_EQUAL(connection->getUploadedSegments().size(), 0);
+    TEST_EQUAL(targetPos, 0);
+
+    // states of other data
+    targetPos = 4096;
+    TEST_EQUAL(retrySendData(data, targetPos, "uuid", "file", 3, segmentStates, error), false);
+
+    delete data;
+}
+
+/**
+ * @brief configureSegmentSize_test
+ */
+void
+SnapshotUpload_Test::configureSegmentSize_test()
+{
+    TEST_EQUAL(configureSegmentSize(0, 0, TEST_SEGMENT_SIZE, false), false);
+    TEST_EQUAL(configureSegmentSize(64 * 1024, 96 * 1024, 32 * 1024, false), false);
+    TEST_EQUAL(configureSegmentSize(16 * 1024, 32 * 1024, 64 * 1024, false), false);
+
+    // each segment must fit together with its header-fields into a single stream-message
+    TEST_EQUAL(configureSegmentSize(64 * 1024, 32 * 1024, 124 * 1024, true), true);
+    TEST_EQUAL(configureSegmentSize(64 * 1024, 32 * 1024, 124 * 1024 + 1, true), false);
+    TEST_EQUAL(configureSegmentSize(64 * 1024, 32 * 1024, 1024 * 1024, true), false);
+
+    TEST_EQUAL(configureSegmentSize(TEST_SEGMENT_SIZE,
+                                    TEST_SEGMENT_SIZE,
+                                    TEST_SEGMENT_SIZE,
+                                    false), true);
+}
+
+}
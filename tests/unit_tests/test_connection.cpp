@@ -0,0 +1,90 @@
+/**
+ * @file        test_connection.cpp
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#include <test_connection.h>
+
+#include <chrono>
+#include <thread>
+
+#include <libShioriArchive/other.h>
+
+namespace Shiori
+{
+
+// latency of the stream-messages, so parallel messages of an upload would overlap
+const uint64_t TEST_CONNECTION_LATENCY_US = 200;
+
+/**
+ * @brief constructor
+ */
+TestConnection::TestConnection()
+    : FakeShioriEndpoint(TEST_CONNECTION_LATENCY_US) {}
+
+/**
+ * @brief count the request and answer it after a delay with the number of the request as
+ *        location. Requests for the object "unknown" fail and requests for the object
+ *        "invalid" get a response, which is not valid json.
+ *
+ * @param response reference for the response
+ * @param request received request
+ *
+ * @return true
+ */
+bool
+TestConnection::triggerSakuraFile(Kitsunemimi::Hanami::ResponseMessage &response,
+                                  const Kitsunemimi::Hanami::RequestMessage &request,
+                                  Kitsunemimi::ErrorContainer &)
+{
+    numberOfRequests++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    response.success = request.inputValues.find("unknown") == std::string::npos;
+    response.responseContent = "{\"location\":\"request_"
+                               + std::to_string(numberOfRequests.load())
+                               + "\"}";
+    if(request.inputValues.find("invalid") != std::string::npos) {
+        response.responseContent = "invalid_" + std::to_string(numberOfRequests.load());
+    }
+
+    return true;
+}
+
+/**
+ * @brief get the connection of the tests, which is added to the pool of clients on first use.
+ *        It is never deleted, because the pool has no way to remove it again.
+ *
+ * @return pointer to the connection
+ */
+TestConnection*
+getTestConnection()
+{
+    static TestConnection* connection = []()
+    {
+        TestConnection* newConnection = new TestConnection();
+        addShioriConnection(newConnection);
+        return newConnection;
+    }();
+
+    return connection;
+}
+
+}
@@ -0,0 +1,53 @@
+/**
+ * @file        test_connection.h
+ *
+ * @author      Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ * @copyright   Apache License Version 2.0
+ *
+ *      Copyright 2021 Tobias Anker
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License");
+ *      you may not use this file except in compliance with the License.
+ *      You may obtain a copy of the License at
+ *
+ *          http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *      Unless required by applicable law or agreed to in writing, software
+ *      distributed under the License is distributed on an "AS IS" BASIS,
+ *      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *      See the License for the specific language governing permissions and
+ *      limitations under the License.
+ */
+
+#ifndef TEST_CONNECTION_H
+#define TEST_CONNECTION_H
+
+#include <atomic>
+
+#include <fake_shiori_endpoint.h>
+
+namespace Shiori
+{
+
+// connection of all unit-tests, because connections can't be removed from the pool of clients
+// again and a second connection would get a part of the requests of the tests. Requests for
+// information are counted and answered after a delay, so concurrent requests overlap.
+class TestConnection
+        : public FakeShioriEndpoint
+{
+public:
+    TestConnection();
+
+    std::atomic<uint32_t> numberOfRequests = {0};
+
+    bool triggerSakuraFile(Kitsunemimi::Hanami::ResponseMessage &response,
+                           const Kitsunemimi::Hanami::RequestMessage &request,
+                           Kitsunemimi::ErrorContainer &error);
+};
+
+TestConnection* getTestConnection();
+
+}
+
+#endif // TEST_CONNECTION_H
@@ -7,6 +7,7 @@ CONFIG += c++17 console
 
 LIBS += -L../../src -lShioriArchive
 INCLUDEPATH += $$PWD
+INCLUDEPATH += ../benchmark_tests
 
 LIBS += -L../../../libKitsunemimiConfig/src -lKitsunemimiConfig
 LIBS += -L../../../libKitsunemimiConfig/src/debug -lKitsunemimiConfig
@@ -68,9 +69,33 @@ LIBS += -L../../../libKitsunemimiHanamiNetwork/src/debug -lKitsunemimiHanamiNetw
 LIBS += -L../../../libKitsunemimiHanamiNetwork/src/release -lKitsunemimiHanamiNetwork
 INCLUDEPATH += ../../../libKitsunemimiHanamiNetwork/include
 
-LIBS += -lssl -lcryptopp -lcrypto
+LIBS += -lssl -lcryptopp -lcrypto -llz4 -lzstd -lprotobuf
 
 SOURCES += \
-    main.cpp
-
-HEADERS +=
+    ../benchmark_tests/fake_shiori_endpoint.cpp \
+    buffer_pool_test.cpp \
+    column_cache_test.cpp \
+    column_view_test.cpp \
+    crc32c_test.cpp \
+    error_aggregator_test.cpp \
+    json_helper_test.cpp \
+    main.cpp \
+    metadata_cache_test.cpp \
+    snapshot_compression_test.cpp \
+    snapshot_delta_test.cpp \
+    snapshot_upload_test.cpp \
+    test_connection.cpp
+
+HEADERS += \
+    ../benchmark_tests/fake_shiori_endpoint.h \
+    buffer_pool_test.h \
+    column_cache_test.h \
+    column_view_test.h \
+    crc32c_test.h \
+    error_aggregator_test.h \
+    json_helper_test.h \
+    metadata_cache_test.h \
+    snapshot_compression_test.h \
+    snapshot_delta_test.h \
+    snapshot_upload_test.h \
+    test_connection.h